@@ -0,0 +1,389 @@
+/**
+ * Chapter 3: GPIO In-Depth - Masked GPIO Example
+ *
+ * Writes single pins and pin groups with one store instead of a
+ * read-modify-write of the whole port.
+ *
+ * Most examples change LEDs with `GPIO3DATA |= x` or `GPIO3DATA &= ~x`.
+ * That is a load, a modify and a store of all 12 pins of the port. If an
+ * interrupt writes another pin of the same port between the load and the
+ * store, the store puts the old value back and the interrupt's change is
+ * lost.
+ *
+ * Every GPIO port has 4096 DATA addresses. Address bits 13:2 are a pin
+ * mask: a store only changes the pins whose mask bit is set, and a load
+ * returns 0 for all other pins. GPIO3DATA (offset 0x3FFC) is simply the
+ * address with all 12 mask bits set.
+ *
+ * At reset the program:
+ *   1. Measures RMW and masked writes with the DWT cycle counter
+ *   2. Runs a race test: SysTick toggles LED1 ~72000 times a second while
+ *      the main loop toggles LED0, first with RMW, then with masked writes
+ *   3. Prints both results over UART and shows the verdict on the LEDs
+ *
+ * Concepts demonstrated:
+ *   - Masked DATA addresses: one store, no read
+ *   - A small gpio_* API built on them
+ *   - Lost updates from read-modify-write shared with an interrupt
+ *   - Measuring cycles with DWT_CYCCNT
+ *
+ * Hardware:
+ *   - LEDs on P3.0-P3.3 (active-low)
+ *   - P1.6: UART RXD
+ *   - P1.7: UART TXD (115200 8N1)
+ *
+ * Note: This example assumes 72 MHz system clock (PLL configured)
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+#define UARTCLKDIV     (*((volatile uint32_t *)0x40048098))
+
+/* IOCON */
+#define IOCON_PIO1_6   (*((volatile uint32_t *)0x400440A4))
+#define IOCON_PIO1_7   (*((volatile uint32_t *)0x400440A8))
+#define IOCON_PIO3_0   (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1   (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2   (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3   (*((volatile uint32_t *)0x400440AC))
+
+/* GPIO Port 3 (LEDs) */
+#define GPIO3DIR       (*((volatile uint32_t *)0x50038000))
+#define GPIO3DATA      (*((volatile uint32_t *)0x50033FFC))
+
+/* UART Registers */
+#define U0THR          (*((volatile uint32_t *)0x40008000))
+#define U0DLL          (*((volatile uint32_t *)0x40008000))
+#define U0DLM          (*((volatile uint32_t *)0x40008004))
+#define U0FCR          (*((volatile uint32_t *)0x40008008))
+#define U0LCR          (*((volatile uint32_t *)0x4000800C))
+#define U0LSR          (*((volatile uint32_t *)0x40008014))
+
+/* SysTick Registers (ARM Cortex-M3 core) */
+#define SYST_CSR       (*((volatile uint32_t *)0xE000E010))
+#define SYST_RVR       (*((volatile uint32_t *)0xE000E014))
+#define SYST_CVR       (*((volatile uint32_t *)0xE000E018))
+
+/* Debug and Trace (ARM Cortex-M3 core) */
+#define DEMCR          (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL       (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT     (*((volatile uint32_t *)0xE0001004))
+
+/*******************************************************************************
+ * Masked GPIO API
+ ******************************************************************************/
+
+/* Port n registers start at 0x50000000 + n * 0x10000 */
+#define GPIO_BASE(port)          (0x50000000UL + ((uint32_t)(port) << 16))
+
+/* DATA alias that only sees the pins in mask (bits 11:0) */
+#define GPIO_MASKED(port, mask)  (*((volatile uint32_t *)(GPIO_BASE(port) + ((uint32_t)(mask) << 2))))
+
+/* Set the pins in mask HIGH - one store */
+static inline void gpio_set(uint32_t port, uint32_t mask) {
+    GPIO_MASKED(port, mask) = mask;
+}
+
+/* Set the pins in mask LOW - one store */
+static inline void gpio_clear(uint32_t port, uint32_t mask) {
+    GPIO_MASKED(port, mask) = 0;
+}
+
+/* Write value to the pins in mask, leave all other pins alone - one store */
+static inline void gpio_write(uint32_t port, uint32_t mask, uint32_t value) {
+    GPIO_MASKED(port, mask) = value;
+}
+
+/* Read the pins in mask; all other bits read as 0 */
+static inline uint32_t gpio_read(uint32_t port, uint32_t mask) {
+    return GPIO_MASKED(port, mask);
+}
+
+/* Set one pin HIGH or LOW */
+static inline void gpio_pin_write(uint32_t port, uint32_t pin, uint32_t level) {
+    GPIO_MASKED(port, 1u << pin) = level ? 0xFFF : 0;
+}
+
+/* Invert the pins in mask. Needs a load, but the load and store only see
+ * these pins, so other pins changed in between are never overwritten. */
+static inline void gpio_toggle(uint32_t port, uint32_t mask) {
+    GPIO_MASKED(port, mask) = ~GPIO_MASKED(port, mask);
+}
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define LED_MASK       0x0F
+#define LED_PORT       3
+
+#define SYSTEM_CLOCK   72000000UL
+
+/* Clock enable bits */
+#define GPIO_CLK       (1 << 6)
+#define UART_CLK       (1 << 12)
+#define IOCON_CLK      (1 << 16)
+
+/* DWT enable bits */
+#define DEMCR_TRCENA        (1 << 24)
+#define DWT_CTRL_CYCCNTENA  (1 << 0)
+
+/* SysTick: CPU clock, interrupt, enable */
+#define SYST_CSR_RUN   0x07
+
+#define LSR_THRE       (1 << 5)
+
+/* Benchmark: each loop pass does BENCH_UNROLL writes */
+#define BENCH_LOOPS    1000
+#define BENCH_UNROLL   8
+
+/* Race test: pin owned by the main loop and pin owned by SysTick */
+#define MAIN_PIN       (1 << 0)    /* LED0 */
+#define ISR_PIN        (1 << 1)    /* LED1 */
+
+/* ~72 kHz interrupt rate; not a multiple of the main loop length, so the
+ * interrupt lands on every instruction of the loop over time */
+#define RACE_RELOAD    (1000 - 1)
+#define RACE_TICKS     100000
+
+typedef enum {
+    MODE_RMW,
+    MODE_MASKED
+} write_mode_t;
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+
+volatile write_mode_t race_mode = MODE_RMW;
+volatile uint32_t race_ticks = 0;
+volatile uint32_t race_lost = 0;
+volatile uint32_t isr_level = 0;   /* Level SysTick last wrote to ISR_PIN */
+
+/*******************************************************************************
+ * SysTick Interrupt Handler
+ ******************************************************************************/
+
+/**
+ * Check that ISR_PIN still has the level written last time, then toggle
+ * it. A mismatch means the main loop's write put an old value back.
+ */
+void SysTick_Handler(void) {
+    uint32_t seen = GPIO_MASKED(LED_PORT, ISR_PIN) ? 1 : 0;
+
+    if (seen != isr_level) race_lost++;
+    isr_level ^= 1;
+
+    if (race_mode == MODE_RMW) {
+        if (isr_level) GPIO3DATA |= ISR_PIN;
+        else GPIO3DATA &= ~ISR_PIN;
+    } else {
+        gpio_write(LED_PORT, ISR_PIN, isr_level ? ISR_PIN : 0);
+    }
+
+    race_ticks++;
+}
+
+/*******************************************************************************
+ * UART Functions
+ ******************************************************************************/
+
+void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= UART_CLK | IOCON_CLK;
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+void print_number(uint32_t n) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/* Print a value in hundredths as n.nn */
+void print_fixed2(uint32_t hundredths) {
+    print_number(hundredths / 100);
+    uart_putchar('.');
+    uart_putchar('0' + (hundredths / 10) % 10);
+    uart_putchar('0' + hundredths % 10);
+}
+
+/*******************************************************************************
+ * LED Functions
+ ******************************************************************************/
+
+void led_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK | IOCON_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    gpio_set(LED_PORT, LED_MASK);   /* All off before becoming outputs */
+    GPIO3DIR |= LED_MASK;
+}
+
+/* Show a 4-bit pattern (1 = on) - active-low, so write the inverse */
+void led_pattern(uint8_t pattern) {
+    gpio_write(LED_PORT, LED_MASK, ~pattern);
+}
+
+/*******************************************************************************
+ * Benchmark
+ ******************************************************************************/
+
+/* Eight writes per loop pass so the loop itself costs little */
+#define REPEAT8(x)  x; x; x; x; x; x; x; x
+
+static uint32_t bench_empty(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    for (volatile uint32_t i = 0; i < BENCH_LOOPS; i++) {
+    }
+    return DWT_CYCCNT - t0;
+}
+
+static uint32_t bench_rmw(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    for (volatile uint32_t i = 0; i < BENCH_LOOPS; i++) {
+        REPEAT8(GPIO3DATA &= ~MAIN_PIN; GPIO3DATA |= MAIN_PIN);
+    }
+    return DWT_CYCCNT - t0;
+}
+
+static uint32_t bench_masked(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    for (volatile uint32_t i = 0; i < BENCH_LOOPS; i++) {
+        REPEAT8(gpio_clear(LED_PORT, MAIN_PIN); gpio_set(LED_PORT, MAIN_PIN));
+    }
+    return DWT_CYCCNT - t0;
+}
+
+/**
+ * Print cycles per single pin write in hundredths, after subtracting
+ * the empty loop
+ */
+static void print_bench(const char *name, uint32_t cycles, uint32_t empty) {
+    uint32_t writes = BENCH_LOOPS * BENCH_UNROLL * 2;
+
+    uart_puts(name);
+    print_fixed2(((cycles - empty) * 100) / writes);
+    uart_puts(" cycles per write\r\n");
+}
+
+void run_benchmark(void) {
+    uint32_t empty = bench_empty();
+    uint32_t rmw = bench_rmw();
+    uint32_t masked = bench_masked();
+
+    uart_puts("Benchmark (one pin, set + clear):\r\n");
+    print_bench("  GPIO3DATA |= / &= : ", rmw, empty);
+    print_bench("  gpio_set / clear  : ", masked, empty);
+}
+
+/*******************************************************************************
+ * Race Test
+ ******************************************************************************/
+
+/**
+ * Toggle MAIN_PIN as fast as possible while SysTick toggles ISR_PIN.
+ * Returns the number of ISR_PIN updates that were lost.
+ */
+uint32_t race_run(write_mode_t mode) {
+    SYST_CSR = 0;
+    race_mode = mode;
+    race_ticks = 0;
+    race_lost = 0;
+    isr_level = gpio_read(LED_PORT, ISR_PIN) ? 1 : 0;
+
+    SYST_RVR = RACE_RELOAD;
+    SYST_CVR = 0;
+    SYST_CSR = SYST_CSR_RUN;
+
+    if (mode == MODE_RMW) {
+        while (race_ticks < RACE_TICKS) {
+            GPIO3DATA &= ~MAIN_PIN;
+            GPIO3DATA |= MAIN_PIN;
+        }
+    } else {
+        while (race_ticks < RACE_TICKS) {
+            gpio_clear(LED_PORT, MAIN_PIN);
+            gpio_set(LED_PORT, MAIN_PIN);
+        }
+    }
+
+    SYST_CSR = 0;
+    return race_lost;
+}
+
+static void print_race(const char *name, uint32_t lost) {
+    uart_puts(name);
+    print_number(lost);
+    uart_puts(" of ");
+    print_number(RACE_TICKS);
+    uart_puts(" interrupt writes lost\r\n");
+}
+
+/*******************************************************************************
+ * Main Function
+ ******************************************************************************/
+
+int main(void) {
+    led_init();
+    uart_init(115200);
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    uart_puts("\r\nMasked GPIO\r\n\r\n");
+
+    run_benchmark();
+
+    uart_puts("\r\nRace test (SysTick toggles LED1, main toggles LED0):\r\n");
+    uint32_t lost_rmw = race_run(MODE_RMW);
+    print_race("  read-modify-write : ", lost_rmw);
+    uint32_t lost_masked = race_run(MODE_MASKED);
+    print_race("  masked            : ", lost_masked);
+
+    /* LED3 = masked writes lost nothing, LED2 = RMW lost updates (expected) */
+    led_pattern((lost_masked == 0 ? 0x08 : 0) | (lost_rmw != 0 ? 0x04 : 0));
+
+    while (1) {
+        __asm volatile ("wfi");
+    }
+
+    return 0;
+}
@@ -0,0 +1,277 @@
+/**
+ * Chapter 3: GPIO In-Depth - Vertical Debounce Example
+ *
+ * Debounces all 12 pins of port 0 and port 2 at once from a 5 ms SysTick
+ * interrupt, using vertical counters.
+ *
+ * A vertical counter stores a small counter for every pin, but "sideways":
+ * cnt0 holds bit 0 of all 12 counters and cnt1 holds bit 1. Counting
+ * every pin at once then takes a handful of AND/XOR operations per port,
+ * whether one button is connected or twelve.
+ *
+ * A pin's debounced level only changes after it has read the new level in
+ * 4 samples in a row (20 ms). Any sample with the old level restarts that
+ * pin's count, so bounces never get through.
+ *
+ * Each change sets a bit in a press or release mask. The main loop reads
+ * and clears these masks - no delays in interrupts, no spinning in the
+ * main loop.
+ *
+ * Demo:
+ *   - P0.1 (board button): count up, shown in binary on the LEDs
+ *   - P2.0-P2.3 (optional external buttons): flip bit 0-3 of the count
+ *   A bouncy button with the old delay-based debounce often counts twice;
+ *   here every press counts exactly once.
+ *
+ * Concepts demonstrated:
+ *   - Sampling inputs from a periodic interrupt
+ *   - Vertical (bit-parallel) counters
+ *   - Press/release edge masks
+ *   - Atomic read-and-clear of flags shared with an interrupt
+ *
+ * Hardware:
+ *   - LEDs on P3.0-P3.3 (active-low)
+ *   - Button on P0.1 (active-low, directly on LPC-P1343 board)
+ *   - Optional buttons on P2.0-P2.3 to GND
+ *
+ * Note: This example assumes 72 MHz system clock (PLL configured)
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+
+/* IOCON */
+#define IOCON_PIO0_1   (*((volatile uint32_t *)0x40044010))
+#define IOCON_PIO2_0   (*((volatile uint32_t *)0x40044008))
+#define IOCON_PIO2_1   (*((volatile uint32_t *)0x40044028))
+#define IOCON_PIO2_2   (*((volatile uint32_t *)0x4004405C))
+#define IOCON_PIO2_3   (*((volatile uint32_t *)0x4004408C))
+#define IOCON_PIO3_0   (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1   (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2   (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3   (*((volatile uint32_t *)0x400440AC))
+
+/* GPIO Port 0 (button) */
+#define GPIO0DIR       (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA      (*((volatile uint32_t *)0x50003FFC))
+
+/* GPIO Port 2 (external buttons) */
+#define GPIO2DIR       (*((volatile uint32_t *)0x50028000))
+#define GPIO2DATA      (*((volatile uint32_t *)0x50023FFC))
+
+/* GPIO Port 3 (LEDs) */
+#define GPIO3DIR       (*((volatile uint32_t *)0x50038000))
+#define GPIO3_LEDS     (*((volatile uint32_t *)0x5003003C))  /* Masked: P3.0-P3.3 only */
+
+/* SysTick Registers (ARM Cortex-M3 core) */
+#define SYST_CSR       (*((volatile uint32_t *)0xE000E010))
+#define SYST_RVR       (*((volatile uint32_t *)0xE000E014))
+#define SYST_CVR       (*((volatile uint32_t *)0xE000E018))
+
+/* Debug and Trace (ARM Cortex-M3 core) */
+#define DEMCR          (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL       (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT     (*((volatile uint32_t *)0xE0001004))
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define LED_MASK       0x0F
+#define BUTTON_PIN     (1 << 1)  /* P0.1 */
+#define EXT_BUTTONS    0x0F      /* P2.0-P2.3 */
+#define PORT_PINS      0xFFF     /* 12 pins per port */
+
+#define SYSTEM_CLOCK   72000000UL
+
+/* Clock enable bits */
+#define GPIO_CLK       (1 << 6)
+#define IOCON_CLK      (1 << 16)
+
+/* SysTick: CPU clock, interrupt, enable */
+#define SYST_CSR_RUN   0x07
+
+/* DWT enable bits */
+#define DEMCR_TRCENA        (1 << 24)
+#define DWT_CTRL_CYCCNTENA  (1 << 0)
+
+/* IOCON: GPIO function, pull-up, hysteresis */
+#define IOCON_BUTTON   ((0x02 << 3) | (0x01 << 5))
+
+/* Sample every 5 ms; a change needs 4 equal samples = 20 ms */
+#define DEBOUNCE_TICK_MS  5
+
+/*******************************************************************************
+ * Debounce Service
+ ******************************************************************************/
+
+typedef struct {
+    uint32_t state;      /* Debounced level, bit n = pin n (1 = HIGH) */
+    uint32_t cnt0;       /* Bit 0 of every pin's counter */
+    uint32_t cnt1;       /* Bit 1 of every pin's counter */
+    uint32_t pressed;    /* Went LOW since last read (sticky) */
+    uint32_t released;   /* Went HIGH since last read (sticky) */
+} debounce_port_t;
+
+enum {
+    DEBOUNCE_PORT0,
+    DEBOUNCE_PORT2,
+    DEBOUNCE_NUM_PORTS
+};
+
+static debounce_port_t debounce[DEBOUNCE_NUM_PORTS];
+
+volatile uint32_t debounce_cycles = 0;   /* Cost of the last tick */
+
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/**
+ * Feed one sample of a whole port into its vertical counters.
+ *
+ * Pins whose sample equals the debounced state have their counter held
+ * at 0. The others count 0 -> 1 -> 2 -> 3 -> 0; the wrap back to 0 is
+ * the 4th differing sample in a row and flips the debounced state.
+ */
+static inline void debounce_sample(debounce_port_t *d, uint32_t sample) {
+    uint32_t delta = sample ^ d->state;
+
+    d->cnt1 = (d->cnt1 ^ d->cnt0) & delta;
+    d->cnt0 = ~d->cnt0 & delta;
+
+    uint32_t toggle = delta & ~(d->cnt0 | d->cnt1);
+
+    d->state ^= toggle;
+    d->pressed |= toggle & ~d->state;
+    d->released |= toggle & d->state;
+}
+
+void SysTick_Handler(void) {
+    uint32_t t0 = DWT_CYCCNT;
+
+    debounce_sample(&debounce[DEBOUNCE_PORT0], GPIO0DATA & PORT_PINS);
+    debounce_sample(&debounce[DEBOUNCE_PORT2], GPIO2DATA & PORT_PINS);
+
+    debounce_cycles = DWT_CYCCNT - t0;
+}
+
+/**
+ * Start sampling. The current pin levels become the debounced state, so
+ * nothing is reported for buttons already held at reset.
+ */
+void debounce_init(void) {
+    debounce[DEBOUNCE_PORT0].state = GPIO0DATA & PORT_PINS;
+    debounce[DEBOUNCE_PORT2].state = GPIO2DATA & PORT_PINS;
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    SYST_RVR = (SYSTEM_CLOCK / 1000) * DEBOUNCE_TICK_MS - 1;
+    SYST_CVR = 0;
+    SYST_CSR = SYST_CSR_RUN;
+}
+
+/**
+ * Return the pins of a port that were pressed (went LOW) since the last
+ * call, and clear them
+ */
+uint32_t debounce_pressed(uint32_t port) {
+    uint32_t primask = irq_save();
+    uint32_t mask = debounce[port].pressed;
+    debounce[port].pressed = 0;
+    irq_restore(primask);
+    return mask;
+}
+
+/**
+ * Return the pins of a port that were released (went HIGH) since the
+ * last call, and clear them
+ */
+uint32_t debounce_released(uint32_t port) {
+    uint32_t primask = irq_save();
+    uint32_t mask = debounce[port].released;
+    debounce[port].released = 0;
+    irq_restore(primask);
+    return mask;
+}
+
+/**
+ * Current debounced level of a port (1 = HIGH)
+ */
+uint32_t debounce_state(uint32_t port) {
+    return *(volatile uint32_t *)&debounce[port].state;
+}
+
+/*******************************************************************************
+ * Helper Functions
+ ******************************************************************************/
+
+void init_leds(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO3_LEDS = LED_MASK;  /* All off */
+    GPIO3DIR |= LED_MASK;
+}
+
+void set_leds(uint8_t pattern) {
+    GPIO3_LEDS = ~pattern;  /* Active-low; masked store touches only the LEDs */
+}
+
+void init_buttons(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK | IOCON_CLK;
+
+    IOCON_PIO0_1 = IOCON_BUTTON;
+    IOCON_PIO2_0 = IOCON_BUTTON;
+    IOCON_PIO2_1 = IOCON_BUTTON;
+    IOCON_PIO2_2 = IOCON_BUTTON;
+    IOCON_PIO2_3 = IOCON_BUTTON;
+
+    GPIO0DIR &= ~BUTTON_PIN;
+    GPIO2DIR &= ~EXT_BUTTONS;
+}
+
+/*******************************************************************************
+ * Main Function
+ ******************************************************************************/
+
+int main(void) {
+    uint8_t count = 0;
+
+    init_leds();
+    init_buttons();
+    debounce_init();
+
+    while (1) {
+        __asm volatile ("wfi");     /* Woken by every SysTick */
+
+        uint32_t p0 = debounce_pressed(DEBOUNCE_PORT0);
+        uint32_t p2 = debounce_pressed(DEBOUNCE_PORT2);
+
+        if (p0 & BUTTON_PIN) count++;
+        count ^= (p2 & EXT_BUTTONS);
+
+        set_leds(count & LED_MASK);
+    }
+
+    return 0;
+}
@@ -0,0 +1,640 @@
+/**
+ * Chapter 4: Timers and PWM - DDS Synthesizer Example
+ *
+ * A polyphonic wavetable synthesizer using direct digital synthesis (DDS).
+ * CT16B1 runs an 8-bit PWM carrier at 281 kHz - far above hearing, so an
+ * RC filter (or the speaker itself) leaves only the audio. CT32B0
+ * interrupts at the sample rate; each interrupt advances every voice's
+ * phase accumulator, reads its wavetable, applies its ADSR envelope, mixes
+ * the voices and writes the result to the carrier's match register.
+ *
+ * Where Tone-Generator can only play one square wave at a time, this plays
+ * several notes at once with any waveform and a volume envelope per note.
+ *
+ * At startup the synthesizer benchmarks itself: it measures the cycles
+ * per sample for 1 to SYNTH_VOICES active voices with the DWT cycle
+ * counter and prints a table over UART, so you can see how many voices
+ * fit at 16 kHz and 32 kHz. Then it plays a melody with a bass line.
+ *
+ * Concepts demonstrated:
+ *   - PWM as a DAC (carrier frequency >> audio frequency)
+ *   - Phase accumulators and frequency tuning words
+ *   - Wavetables (sine, computed harmonics, sawtooth)
+ *   - ADSR envelopes in fixed point
+ *   - Mixing with saturation
+ *   - Measuring interrupt cost with DWT_CYCCNT
+ *
+ * Hardware:
+ *   - P1.9: Audio PWM (CT16B1_MAT0) - 1k resistor + 10nF to GND as a
+ *           low-pass filter, then a small amplifier or piezo
+ *   - P1.6: UART RXD, P1.7: UART TXD (115200 8N1) for the benchmark
+ *
+ * Build: make                     (32 kHz sample rate)
+ *        make OPT="-O2 -DSAMPLE_RATE=16000"
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+#define UARTCLKDIV     (*((volatile uint32_t *)0x40048098))
+
+/* IOCON */
+#define IOCON_PIO1_6   (*((volatile uint32_t *)0x400440A4))
+#define IOCON_PIO1_7   (*((volatile uint32_t *)0x400440A8))
+#define IOCON_PIO1_9   (*((volatile uint32_t *)0x40044038))
+
+/* UART Registers */
+#define U0THR          (*((volatile uint32_t *)0x40008000))
+#define U0DLL          (*((volatile uint32_t *)0x40008000))
+#define U0DLM          (*((volatile uint32_t *)0x40008004))
+#define U0FCR          (*((volatile uint32_t *)0x40008008))
+#define U0LCR          (*((volatile uint32_t *)0x4000800C))
+#define U0LSR          (*((volatile uint32_t *)0x40008014))
+
+/* CT16B1 Timer Registers (PWM carrier) */
+#define TMR16B1TCR     (*((volatile uint32_t *)0x40010004))
+#define TMR16B1PR      (*((volatile uint32_t *)0x4001000C))
+#define TMR16B1MCR     (*((volatile uint32_t *)0x40010014))
+#define TMR16B1MR0     (*((volatile uint32_t *)0x40010018))
+#define TMR16B1MR3     (*((volatile uint32_t *)0x40010024))
+#define TMR16B1PWMC    (*((volatile uint32_t *)0x40010074))
+
+/* CT32B0 Timer Registers (sample clock) */
+#define TMR32B0IR      (*((volatile uint32_t *)0x40014000))
+#define TMR32B0TCR     (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR      (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR     (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0     (*((volatile uint32_t *)0x40014018))
+
+/* NVIC */
+#define NVIC_ISER1     (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+
+/* Debug and Trace (ARM Cortex-M3 core) */
+#define DEMCR          (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL       (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT     (*((volatile uint32_t *)0xE0001004))
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define SYSTEM_CLOCK   72000000UL
+
+#ifndef SAMPLE_RATE
+#define SAMPLE_RATE    32000     /* Hz - 16000 also works well */
+#endif
+
+/* Carrier: 8-bit PWM, 72 MHz / 256 = 281.25 kHz */
+#define PWM_BITS       8
+#define PWM_PERIOD     (1 << PWM_BITS)
+
+#define SYNTH_VOICES   8
+
+/* Clock enable bits */
+#define CT16B1_CLK     (1 << 8)
+#define CT32B0_CLK     (1 << 9)
+#define UART_CLK       (1 << 12)
+#define IOCON_CLK      (1 << 16)
+
+/* CT32B0 IRQ number */
+#define CT32B0_IRQn    43
+
+/* DWT enable bits */
+#define DEMCR_TRCENA        (1 << 24)
+#define DWT_CTRL_CYCCNTENA  (1 << 0)
+
+/* UART bits */
+#define LSR_THRE       (1 << 5)
+
+/* Envelope scale: 24-bit level, top 8 bits used as the gain */
+#define ENV_MAX        0x00FFFFFFUL
+
+/* Mix: each voice contributes up to +-127 * 255. With this shift four
+ * voices at full level reach full scale; louder mixes are clipped. */
+#define MIX_SHIFT      10
+
+/* Exception entry and exit (about 12 cycles each on Cortex-M3, a few more
+ * with flash wait states). The DWT reads inside the handler can't see
+ * them, so they are added to the measured body for the CPU load. */
+#define ISR_OVERHEAD_CYCLES 24
+
+/* Samples per benchmark run */
+#define BENCH_SAMPLES  4096
+
+/*******************************************************************************
+ * Musical Note Frequencies (Hz)
+ ******************************************************************************/
+
+#define NOTE_REST  0
+#define NOTE_G2    98
+#define NOTE_C3    131
+#define NOTE_G3    196
+#define NOTE_C4    262
+#define NOTE_D4    294
+#define NOTE_E4    330
+#define NOTE_G4    392
+
+/*******************************************************************************
+ * Wavetables
+ *
+ * 256 signed 8-bit samples per cycle. The top 8 bits of a voice's 32-bit
+ * phase accumulator index the table.
+ ******************************************************************************/
+
+#define WAVE_SIZE      256
+
+/* 127 * sin(2 * pi * i / 256) */
+const int8_t wave_sine[WAVE_SIZE] = {
+       0,    3,    6,    9,   12,   16,   19,   22,   25,   28,   31,   34,   37,   40,   43,   46,
+      49,   51,   54,   57,   60,   63,   65,   68,   71,   73,   76,   78,   81,   83,   85,   88,
+      90,   92,   94,   96,   98,  100,  102,  104,  106,  107,  109,  111,  112,  113,  115,  116,
+     117,  118,  120,  121,  122,  122,  123,  124,  125,  125,  126,  126,  126,  127,  127,  127,
+     127,  127,  127,  127,  126,  126,  126,  125,  125,  124,  123,  122,  122,  121,  120,  118,
+     117,  116,  115,  113,  112,  111,  109,  107,  106,  104,  102,  100,   98,   96,   94,   92,
+      90,   88,   85,   83,   81,   78,   76,   73,   71,   68,   65,   63,   60,   57,   54,   51,
+      49,   46,   43,   40,   37,   34,   31,   28,   25,   22,   19,   16,   12,    9,    6,    3,
+       0,   -3,   -6,   -9,  -12,  -16,  -19,  -22,  -25,  -28,  -31,  -34,  -37,  -40,  -43,  -46,
+     -49,  -51,  -54,  -57,  -60,  -63,  -65,  -68,  -71,  -73,  -76,  -78,  -81,  -83,  -85,  -88,
+     -90,  -92,  -94,  -96,  -98, -100, -102, -104, -106, -107, -109, -111, -112, -113, -115, -116,
+    -117, -118, -120, -121, -122, -122, -123, -124, -125, -125, -126, -126, -126, -127, -127, -127,
+    -127, -127, -127, -127, -126, -126, -126, -125, -125, -124, -123, -122, -122, -121, -120, -118,
+    -117, -116, -115, -113, -112, -111, -109, -107, -106, -104, -102, -100,  -98,  -96,  -94,  -92,
+     -90,  -88,  -85,  -83,  -81,  -78,  -76,  -73,  -71,  -68,  -65,  -63,  -60,  -57,  -54,  -51,
+     -49,  -46,  -43,  -40,  -37,  -34,  -31,  -28,  -25,  -22,  -19,  -16,  -12,   -9,   -6,   -3,
+};
+
+/* Custom tables, filled in by waves_init() */
+int8_t wave_organ[WAVE_SIZE];
+int8_t wave_saw[WAVE_SIZE];
+
+/*******************************************************************************
+ * Synthesizer Types
+ ******************************************************************************/
+
+typedef enum {
+    ENV_OFF,
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE
+} env_state_t;
+
+/* ADSR envelope shape */
+typedef struct {
+    uint16_t attack_ms;
+    uint16_t decay_ms;
+    uint8_t  sustain;      /* Sustain level, 0-255 */
+    uint16_t release_ms;
+} synth_env_t;
+
+typedef struct {
+    uint32_t phase;        /* Phase accumulator, 2^32 = one cycle */
+    uint32_t inc;          /* Tuning word: f * 2^32 / SAMPLE_RATE */
+    const int8_t *wave;
+    uint32_t env;          /* Envelope level, 0 .. ENV_MAX */
+    uint32_t sustain;
+    uint32_t attack_step;
+    uint32_t decay_step;
+    uint32_t release_step;
+    uint8_t  state;        /* env_state_t */
+} synth_voice_t;
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+
+volatile synth_voice_t voices[SYNTH_VOICES];
+
+volatile uint32_t sample_count = 0;
+volatile uint32_t ms_ticks = 0;
+
+/* Benchmark accumulators, updated by the sample interrupt */
+volatile uint32_t bench_sum = 0;
+volatile uint32_t bench_max = 0;
+volatile uint32_t bench_count = 0;
+
+/*******************************************************************************
+ * Interrupt Helpers
+ ******************************************************************************/
+
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/*******************************************************************************
+ * Sample Interrupt
+ ******************************************************************************/
+
+/**
+ * Runs once per sample. Voices that are off cost only the state check.
+ *
+ * The carrier's MR0 is written at an arbitrary point in its 3.5 us period,
+ * so an update occasionally stretches or drops one carrier pulse. That
+ * error sits at 281 kHz and is removed by the output filter.
+ */
+void CT32B0_IRQHandler(void) {
+    uint32_t start = DWT_CYCCNT;
+    int32_t mix = 0;
+
+    TMR32B0IR = (1 << 0);
+
+    for (int i = 0; i < SYNTH_VOICES; i++) {
+        volatile synth_voice_t *v = &voices[i];
+        uint32_t env = v->env;
+
+        switch (v->state) {
+            case ENV_OFF:
+                continue;
+            case ENV_ATTACK:
+                if (ENV_MAX - env > v->attack_step) {
+                    env += v->attack_step;
+                } else {
+                    env = ENV_MAX;
+                    v->state = ENV_DECAY;
+                }
+                break;
+            case ENV_DECAY:
+                if (env > v->sustain + v->decay_step) {
+                    env -= v->decay_step;
+                } else {
+                    env = v->sustain;
+                    v->state = ENV_SUSTAIN;
+                }
+                break;
+            case ENV_RELEASE:
+                if (env > v->release_step) {
+                    env -= v->release_step;
+                } else {
+                    env = 0;
+                    v->state = ENV_OFF;
+                }
+                break;
+            default:
+                break;
+        }
+        v->env = env;
+
+        uint32_t phase = v->phase + v->inc;
+        v->phase = phase;
+
+        mix += v->wave[phase >> 24] * (int32_t)(env >> 16);
+    }
+
+    /* Scale, saturate and convert to an unsigned PWM level */
+    mix >>= MIX_SHIFT;
+    if (mix > 127) mix = 127;
+    if (mix < -128) mix = -128;
+
+    /* Output is HIGH from MR0 to the end of the period */
+    TMR16B1MR0 = PWM_PERIOD - (uint32_t)(mix + 128);
+
+    if (++sample_count >= SAMPLE_RATE / 1000) {
+        sample_count = 0;
+        ms_ticks++;
+    }
+
+    uint32_t cycles = DWT_CYCCNT - start;
+    bench_sum += cycles;
+    bench_count++;
+    if (cycles > bench_max) bench_max = cycles;
+}
+
+/*******************************************************************************
+ * Synthesizer Functions
+ ******************************************************************************/
+
+/**
+ * Build the custom wavetables from the sine table.
+ * Organ: fundamental plus 2nd and 3rd harmonics (weights 4:2:1).
+ */
+void waves_init(void) {
+    for (int i = 0; i < WAVE_SIZE; i++) {
+        int32_t s = 4 * wave_sine[i]
+                  + 2 * wave_sine[(2 * i) & (WAVE_SIZE - 1)]
+                  + 1 * wave_sine[(3 * i) & (WAVE_SIZE - 1)];
+        wave_organ[i] = (int8_t)(s / 7);
+        wave_saw[i] = (int8_t)(i - 128);
+    }
+}
+
+/**
+ * Carrier PWM on CT16B1_MAT0 and sample-rate interrupt on CT32B0
+ */
+void synth_init(void) {
+    SYSAHBCLKCTRL |= CT16B1_CLK | CT32B0_CLK | IOCON_CLK;
+
+    /* Cycle counter for the benchmark */
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    /* P1.9 = CT16B1_MAT0 */
+    IOCON_PIO1_9 = 0x01;
+
+    /* Carrier: PR = 0, 256-tick period, start at mid-scale (silence) */
+    TMR16B1TCR = 0x02;
+    TMR16B1PR = 0;
+    TMR16B1MR3 = PWM_PERIOD - 1;
+    TMR16B1MR0 = PWM_PERIOD / 2;
+    TMR16B1MCR = (1 << 10);         /* Reset on MR3 */
+    TMR16B1PWMC = (1 << 0);
+    TMR16B1TCR = 0x01;
+
+    /* Sample clock: interrupt and reset on MR0 */
+    TMR32B0TCR = 0x02;
+    TMR32B0PR = 0;
+    TMR32B0MR0 = SYSTEM_CLOCK / SAMPLE_RATE - 1;
+    TMR32B0MCR = (1 << 0) | (1 << 1);
+    TMR32B0IR = 0x1F;
+    NVIC_ISER1 = (1 << (CT32B0_IRQn - 32));
+    TMR32B0TCR = 0x01;
+}
+
+/**
+ * Per-sample envelope step that covers range in the given time.
+ * Never 0, so every phase is guaranteed to end.
+ */
+static uint32_t env_step(uint32_t range, uint16_t ms) {
+    uint32_t samples = ((uint32_t)ms * SAMPLE_RATE) / 1000;
+    uint32_t step = samples ? (range / samples) : range;
+    return step ? step : 1;
+}
+
+/**
+ * Start a note on a free voice (or steal the quietest releasing one).
+ * Returns the voice number, or -1 if all voices are busy.
+ */
+int synth_note_on(uint16_t frequency, const int8_t *wave,
+                  const synth_env_t *shape) {
+    synth_voice_t v;
+    int slot = -1;
+    uint32_t quietest = ENV_MAX + 1;
+
+    /* Tuning word: the 64-bit divide stays out of the interrupt */
+    v.phase = 0;
+    v.inc = (uint32_t)(((uint64_t)frequency << 32) / SAMPLE_RATE);
+    v.wave = wave;
+    v.env = 0;
+    v.sustain = ((uint32_t)shape->sustain << 16) | 0xFFFF;
+    if (shape->sustain == 0) v.sustain = 0;
+    v.attack_step = env_step(ENV_MAX, shape->attack_ms);
+    v.decay_step = env_step(ENV_MAX - v.sustain, shape->decay_ms);
+    v.release_step = env_step(ENV_MAX, shape->release_ms);
+    v.state = ENV_ATTACK;
+
+    uint32_t primask = irq_save();
+
+    for (int i = 0; i < SYNTH_VOICES; i++) {
+        if (voices[i].state == ENV_OFF) {
+            slot = i;
+            break;
+        }
+        if (voices[i].state == ENV_RELEASE && voices[i].env < quietest) {
+            quietest = voices[i].env;
+            slot = i;
+        }
+    }
+    if (slot >= 0) voices[slot] = v;
+
+    irq_restore(primask);
+    return slot;
+}
+
+/**
+ * Enter the release phase; the voice frees itself when it reaches zero
+ */
+void synth_note_off(int voice) {
+    if (voice < 0) return;
+
+    uint32_t primask = irq_save();
+    if (voices[voice].state != ENV_OFF) voices[voice].state = ENV_RELEASE;
+    irq_restore(primask);
+}
+
+void synth_all_off(void) {
+    uint32_t primask = irq_save();
+    for (int i = 0; i < SYNTH_VOICES; i++) voices[i].state = ENV_OFF;
+    irq_restore(primask);
+}
+
+void delay_ms(uint32_t ms) {
+    uint32_t start = ms_ticks;
+    while ((ms_ticks - start) < ms);
+}
+
+/*******************************************************************************
+ * UART Functions
+ ******************************************************************************/
+
+void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= UART_CLK | IOCON_CLK;
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*******************************************************************************
+ * Benchmark
+ ******************************************************************************/
+
+/**
+ * Average and worst-case cycles per sample with n voices sounding.
+ * All n voices are held in sustain so every one does full work.
+ */
+static void bench_voices(int n, uint32_t *avg, uint32_t *max) {
+    static const synth_env_t hold = { 0, 0, 255, 0 };
+
+    synth_all_off();
+    for (int i = 0; i < n; i++) {
+        synth_note_on(NOTE_C4 + 37 * i, wave_sine, &hold);
+    }
+    delay_ms(5);                    /* Let every voice reach sustain */
+
+    uint32_t primask = irq_save();
+    bench_sum = 0;
+    bench_max = 0;
+    bench_count = 0;
+    irq_restore(primask);
+
+    while (bench_count < BENCH_SAMPLES);
+
+    primask = irq_save();
+    *avg = bench_sum / bench_count;
+    *max = bench_max;
+    irq_restore(primask);
+
+    synth_all_off();
+}
+
+/**
+ * CPU load in tenths of a percent at a given sample rate
+ */
+static uint32_t cpu_permille(uint32_t cycles, uint32_t rate) {
+    return (uint32_t)(((uint64_t)(cycles + ISR_OVERHEAD_CYCLES) * rate * 1000)
+                      / SYSTEM_CLOCK);
+}
+
+static void print_permille(uint32_t pm, uint8_t width) {
+    print_number(pm / 10, width - 2);
+    uart_putchar('.');
+    print_number(pm % 10, 1);
+}
+
+void run_benchmark(void) {
+    uint32_t avg[SYNTH_VOICES + 1];
+    uint32_t max;
+
+    uart_puts("\r\nDDS synth benchmark (cycles per sample, ISR body)\r\n");
+    uart_puts("voices   avg   max  CPU@16k  CPU@32k\r\n");
+
+    for (int n = 1; n <= SYNTH_VOICES; n++) {
+        bench_voices(n, &avg[n], &max);
+
+        print_number(n, 6);
+        print_number(avg[n], 6);
+        print_number(max, 6);
+        print_permille(cpu_permille(avg[n], 16000), 8);
+        uart_putchar('%');
+        print_permille(cpu_permille(avg[n], 32000), 8);
+        uart_puts("%\r\n");
+    }
+
+    /* Linear fit: fixed cost per sample plus cost per voice */
+    uint32_t per_voice = (avg[SYNTH_VOICES] - avg[1]) / (SYNTH_VOICES - 1);
+    uint32_t fixed = avg[1] - per_voice + ISR_OVERHEAD_CYCLES;
+
+    uart_puts("fixed ");
+    print_number(fixed, 0);
+    uart_puts(" + ");
+    print_number(per_voice, 0);
+    uart_puts(" per voice\r\n");
+
+    if (per_voice == 0) per_voice = 1;
+    uart_puts("voices at 100% CPU: 16 kHz ");
+    print_number((SYSTEM_CLOCK / 16000 - fixed) / per_voice, 0);
+    uart_puts(", 32 kHz ");
+    print_number((SYSTEM_CLOCK / 32000 - fixed) / per_voice, 0);
+    uart_puts("\r\n\r\n");
+}
+
+/*******************************************************************************
+ * Melody Player
+ ******************************************************************************/
+
+typedef struct {
+    uint16_t frequency;    /* Melody note (0 = rest) */
+    uint16_t bass;         /* New bass note, 0 = keep the current one */
+    uint16_t duration_ms;
+} Note;
+
+/* "Mary Had a Little Lamb" with a C / G bass line */
+const Note melody[] = {
+    { NOTE_E4, NOTE_C3, 300 }, { NOTE_D4, 0, 300 },
+    { NOTE_C4, 0,       300 }, { NOTE_D4, 0, 300 },
+    { NOTE_E4, NOTE_C3, 300 }, { NOTE_E4, 0, 300 },
+    { NOTE_E4, 0,       600 },
+    { NOTE_D4, NOTE_G2, 300 }, { NOTE_D4, 0, 300 },
+    { NOTE_D4, 0,       600 },
+    { NOTE_E4, NOTE_C3, 300 }, { NOTE_G4, 0, 300 },
+    { NOTE_G4, NOTE_G3, 600 },
+    { NOTE_E4, NOTE_C3, 300 }, { NOTE_D4, 0, 300 },
+    { NOTE_C4, 0,       300 }, { NOTE_D4, 0, 300 },
+    { NOTE_E4, NOTE_C3, 300 }, { NOTE_E4, 0, 300 },
+    { NOTE_E4, 0,       300 }, { NOTE_E4, 0, 300 },
+    { NOTE_D4, NOTE_G2, 300 }, { NOTE_D4, 0, 300 },
+    { NOTE_E4, 0,       300 }, { NOTE_D4, 0, 300 },
+    { NOTE_C4, NOTE_C3, 900 },
+    { 0, 0, 0 }            /* End marker */
+};
+
+static const synth_env_t lead_env = {  10, 150, 160, 120 };
+static const synth_env_t bass_env = {  20, 400, 120, 300 };
+
+void play_melody(const Note *notes) {
+    int bass = -1;
+
+    while (notes->duration_ms != 0) {
+        int lead = -1;
+
+        if (notes->bass) {
+            synth_note_off(bass);
+            bass = synth_note_on(notes->bass, wave_saw, &bass_env);
+        }
+        if (notes->frequency) {
+            lead = synth_note_on(notes->frequency, wave_organ, &lead_env);
+        }
+
+        delay_ms(notes->duration_ms - 50);
+        synth_note_off(lead);
+        delay_ms(50);
+        notes++;
+    }
+    synth_note_off(bass);
+}
+
+/*******************************************************************************
+ * Main Function
+ ******************************************************************************/
+
+int main(void) {
+    uart_init(115200);
+    waves_init();
+    synth_init();
+
+    run_benchmark();
+
+    uart_puts("Playing at ");
+    print_number(SAMPLE_RATE, 0);
+    uart_puts(" Hz\r\n");
+
+    while (1) {
+        play_melody(melody);
+        delay_ms(1500);
+    }
+
+    return 0;
+}
@@ -0,0 +1,634 @@
+/**
+ * Chapter 4: Timers and PWM - Fade Engine Example
+ *
+ * An interrupt-driven fade engine for many PWM channels. Each channel
+ * plays a sequence of keyframes (target level, duration, easing curve).
+ * The engine runs entirely in the PWM period interrupt: every period it
+ * advances each channel, eases and interpolates between keyframes, applies
+ * gamma correction and writes the new match value. The main loop only sets
+ * up the sequences and then sleeps.
+ *
+ * Compared with Breathing-LED, which steps through 101 8-bit gamma values
+ * with delay_ms() in the main loop, the output here changes every PWM
+ * period (1 ms) and is looked up in 1024-entry 16-bit gamma tables with
+ * interpolation between entries, so even slow fades near black show no
+ * visible steps. The tables are generated by the compiler from integer
+ * constant expressions - no script and no start-up computation.
+ *
+ * Concepts demonstrated:
+ *   - Keyframe animation with per-segment easing curves
+ *   - Fixed-point interpolation (Q16 progress, 16-bit levels)
+ *   - Compile-time lookup tables via macro expansion
+ *   - CIE 1931 lightness and gamma 2.2 correction curves
+ *   - All animation work done in the period-match (MR3) interrupt
+ *   - Glitch-free match updates at the start of each period
+ *
+ * Hardware (same LED wiring as Multi-Channel-PWM):
+ *   - P0.8:  CT16B0_MAT0    - P0.9:  CT16B0_MAT1
+ *   - P1.9:  CT16B1_MAT0    - P1.10: CT16B1_MAT1
+ *   - P1.6:  CT32B0_MAT0    - P1.7:  CT32B0_MAT1
+ *   - P1.1:  CT32B1_MAT0    - P1.2:  CT32B1_MAT1
+ *   Connect each pin to an LED with a 330 ohm resistor to GND.
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+
+/* IOCON - PWM-capable pins */
+#define IOCON_PIO0_1        0x40044010
+#define IOCON_PIO1_9        0x40044038
+#define IOCON_PIO0_8        0x40044060
+#define IOCON_PIO0_9        0x40044064
+#define IOCON_SWCLK_PIO0_10 0x40044068
+#define IOCON_PIO1_10       0x4004406C
+#define IOCON_R_PIO1_1      0x4004407C
+#define IOCON_R_PIO1_2      0x40044080
+#define IOCON_SWDIO_PIO1_3  0x40044090
+#define IOCON_PIO1_6        0x400440A4
+#define IOCON_PIO1_7        0x400440A8
+
+#define IOCON_REG(addr)     (*((volatile uint32_t *)(addr)))
+
+/* Timer base addresses - all four share the same register layout */
+#define CT16B0_BASE    0x4000C000
+#define CT16B1_BASE    0x40010000
+#define CT32B0_BASE    0x40014000
+#define CT32B1_BASE    0x40018000
+
+#define TMR_IR(b)      (*((volatile uint32_t *)((b) + 0x00)))
+#define TMR_TCR(b)     (*((volatile uint32_t *)((b) + 0x04)))
+#define TMR_TC(b)      (*((volatile uint32_t *)((b) + 0x08)))
+#define TMR_PR(b)      (*((volatile uint32_t *)((b) + 0x0C)))
+#define TMR_MCR(b)     (*((volatile uint32_t *)((b) + 0x14)))
+#define TMR_MR(b, n)   (*((volatile uint32_t *)((b) + 0x18 + 4 * (n))))
+#define TMR_PWMC(b)    (*((volatile uint32_t *)((b) + 0x74)))
+
+/* NVIC */
+#define NVIC_ISER1     (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define SYSTEM_CLOCK   72000000UL
+#define PWM_FREQUENCY  1000      /* Also the fade engine's update rate */
+
+/* Clock enable bits */
+#define CT16B0_CLK     (1 << 7)
+#define CT16B1_CLK     (1 << 8)
+#define CT32B0_CLK     (1 << 9)
+#define CT32B1_CLK     (1 << 10)
+#define IOCON_CLK      (1 << 16)
+
+/* IOCON ADMODE bit: 1 = digital on analog-capable pins */
+#define IOCON_ADMODE   (1 << 7)
+
+/* MCR bits: interrupt and reset on MR3 */
+#define MCR_MR3I       (1 << 9)
+#define MCR_MR3R       (1 << 10)
+
+/* IR bit: MR3 match flag */
+#define IR_MR3         (1 << 3)
+
+/* CT32B0 IRQ number - its period interrupt runs the fade engine */
+#define CT32B0_IRQn    43
+
+/* No match value other than 0 is placed below this many CPU cycles, so
+ * the engine's writes at the start of a period always land ahead of TC.
+ * The engine touches every channel each period, so the write loop is kept
+ * separate from (and much shorter than) the fade calculations. */
+#define PWM_GUARD_CYCLES 256
+
+/* Duty cycle and brightness scale */
+#define PWM_DUTY_FULL  0xFFFF
+#define FADE_LEVEL_MAX 0xFFFF
+
+/*******************************************************************************
+ * Gamma Tables (generated at compile time)
+ *
+ * GAMMA_STEPS entries, index i stands for perceived brightness i / 1023,
+ * value is the 16-bit PWM duty cycle that produces it.
+ *
+ * Each entry is an integer constant expression, and the GAMMA_xxx(f, i)
+ * macros expand f once per index, so the compiler evaluates the whole
+ * table and places it in flash. All arithmetic is 64-bit unsigned with
+ * rounding; intermediate values stay below 2^50.
+ ******************************************************************************/
+
+#define GAMMA_STEPS    1024
+#define GAMMA_MAX_IDX  (GAMMA_STEPS - 1)
+
+/*
+ * CIE 1931 lightness (L* = 100 * i / 1023) to relative luminance Y:
+ *   L* <= 8:  Y = L* / 903.3
+ *   L* >  8:  Y = ((L* + 16) / 116)^3
+ * The cube is split into two steps so it fits in 64 bits.
+ */
+#define CIE_DEN        (116ULL * GAMMA_MAX_IDX)
+#define CIE_NUM(i)     (100ULL * (i) + 16ULL * GAMMA_MAX_IDX)
+#define CIE_LOW_DEN    (9033ULL * GAMMA_MAX_IDX)
+#define CIE_LOW(i)     ((65535ULL * 1000 * (i) + CIE_LOW_DEN / 2) / CIE_LOW_DEN)
+#define CIE_HIGH(i)    (((CIE_NUM(i) * CIE_NUM(i) * 65535 / CIE_DEN) * CIE_NUM(i) \
+                         + CIE_DEN * CIE_DEN / 2) / (CIE_DEN * CIE_DEN))
+#define CIE(i)         (uint16_t)((100 * (i) <= 8 * GAMMA_MAX_IDX) \
+                                  ? CIE_LOW(i) : CIE_HIGH(i))
+
+/*
+ * Gamma 2.2, approximated as 0.8 x^2 + 0.2 x^3 (x = i / 1023). Within
+ * 0.8% of full scale of x^2.2 everywhere, and exact at both ends.
+ */
+#define G22_DEN        (5ULL * GAMMA_MAX_IDX * GAMMA_MAX_IDX * GAMMA_MAX_IDX)
+#define G22(i)         (uint16_t)((65535ULL * (4ULL * GAMMA_MAX_IDX * (i) * (i) \
+                                               + 1ULL * (i) * (i) * (i))        \
+                                   + G22_DEN / 2) / G22_DEN)
+
+/* Expand f(i) .. f(i + n - 1) */
+#define GAMMA_4(f, i)    f(i), f((i) + 1), f((i) + 2), f((i) + 3)
+#define GAMMA_16(f, i)   GAMMA_4(f, i),  GAMMA_4(f, (i) + 4),   \
+                         GAMMA_4(f, (i) + 8),  GAMMA_4(f, (i) + 12)
+#define GAMMA_64(f, i)   GAMMA_16(f, i), GAMMA_16(f, (i) + 16), \
+                         GAMMA_16(f, (i) + 32), GAMMA_16(f, (i) + 48)
+#define GAMMA_256(f, i)  GAMMA_64(f, i), GAMMA_64(f, (i) + 64), \
+                         GAMMA_64(f, (i) + 128), GAMMA_64(f, (i) + 192)
+#define GAMMA_1024(f)    GAMMA_256(f, 0), GAMMA_256(f, 256),    \
+                         GAMMA_256(f, 512), GAMMA_256(f, 768)
+
+static const uint16_t gamma_cie[GAMMA_STEPS] = { GAMMA_1024(CIE) };
+static const uint16_t gamma_22[GAMMA_STEPS]  = { GAMMA_1024(G22) };
+
+/*******************************************************************************
+ * PWM Driver Types and Tables
+ ******************************************************************************/
+
+typedef enum {
+    PWM_CT16B0,
+    PWM_CT16B1,
+    PWM_CT32B0,
+    PWM_CT32B1,
+    PWM_NUM_TIMERS
+} pwm_timer_id_t;
+
+/* Channel = timer * 3 + match register (MR0..MR2) */
+typedef enum {
+    PWM_16B0_MAT0, PWM_16B0_MAT1, PWM_16B0_MAT2,
+    PWM_16B1_MAT0, PWM_16B1_MAT1, PWM_16B1_MAT2,
+    PWM_32B0_MAT0, PWM_32B0_MAT1, PWM_32B0_MAT2,
+    PWM_32B1_MAT0, PWM_32B1_MAT1, PWM_32B1_MAT2,
+    PWM_NUM_CHANNELS
+} pwm_channel_t;
+
+#define PWM_CHANNELS_PER_TIMER 3
+
+typedef struct {
+    uint32_t base;
+    uint32_t clk_bit;
+    uint32_t max_count;    /* 0xFFFF for 16-bit timers */
+} pwm_timer_info_t;
+
+typedef struct {
+    uint32_t iocon;        /* IOCON register address, 0 = not pinned out */
+    uint32_t func;         /* IOCON value selecting the match function */
+} pwm_pin_t;
+
+static const pwm_timer_info_t pwm_timers[PWM_NUM_TIMERS] = {
+    [PWM_CT16B0] = { CT16B0_BASE, CT16B0_CLK, 0xFFFF     },
+    [PWM_CT16B1] = { CT16B1_BASE, CT16B1_CLK, 0xFFFF     },
+    [PWM_CT32B0] = { CT32B0_BASE, CT32B0_CLK, 0xFFFFFFFF },
+    [PWM_CT32B1] = { CT32B1_BASE, CT32B1_CLK, 0xFFFFFFFF },
+};
+
+static const pwm_pin_t pwm_pins[PWM_NUM_CHANNELS] = {
+    [PWM_16B0_MAT0] = { IOCON_PIO0_8,        0x02 },
+    [PWM_16B0_MAT1] = { IOCON_PIO0_9,        0x02 },
+    [PWM_16B0_MAT2] = { IOCON_SWCLK_PIO0_10, 0x03 },
+    [PWM_16B1_MAT0] = { IOCON_PIO1_9,        0x01 },
+    [PWM_16B1_MAT1] = { IOCON_PIO1_10,       0x02 | IOCON_ADMODE },
+    [PWM_16B1_MAT2] = { 0,                   0 },
+    [PWM_32B0_MAT0] = { IOCON_PIO1_6,        0x02 },
+    [PWM_32B0_MAT1] = { IOCON_PIO1_7,        0x02 },
+    [PWM_32B0_MAT2] = { IOCON_PIO0_1,        0x02 },
+    [PWM_32B1_MAT0] = { IOCON_R_PIO1_1,      0x03 | IOCON_ADMODE },
+    [PWM_32B1_MAT1] = { IOCON_R_PIO1_2,      0x03 | IOCON_ADMODE },
+    [PWM_32B1_MAT2] = { IOCON_SWDIO_PIO1_3,  0x03 | IOCON_ADMODE },
+};
+
+/* Period in timer ticks (MR3 + 1) and guard band in ticks for each timer */
+uint32_t pwm_period[PWM_NUM_TIMERS];
+uint32_t pwm_guard[PWM_NUM_TIMERS];
+
+/*******************************************************************************
+ * Fade Engine Types
+ ******************************************************************************/
+
+typedef enum {
+    EASE_LINEAR,           /* Constant speed */
+    EASE_IN,               /* Starts slow, ends fast (quadratic) */
+    EASE_OUT,              /* Starts fast, ends slow (quadratic) */
+    EASE_IN_OUT,           /* Slow at both ends (smoothstep) */
+    EASE_STEP              /* Jump to the target at the end of the segment */
+} fade_ease_t;
+
+/* One keyframe: fade from the current level to 'level' over 'time_ms' */
+typedef struct {
+    uint16_t level;        /* Perceived brightness, 0 .. FADE_LEVEL_MAX */
+    uint16_t time_ms;      /* Segment length, 0 = jump immediately */
+    uint8_t  ease;         /* fade_ease_t */
+} fade_key_t;
+
+typedef struct {
+    const fade_key_t *keys;
+    uint8_t count;
+    uint8_t loop;          /* 1 = restart at keys[0] after the last key */
+} fade_seq_t;
+
+/* Per-channel state, owned by the interrupt once the channel is started */
+typedef struct {
+    const fade_seq_t *seq;
+    const uint16_t *gamma; /* GAMMA_STEPS-entry curve, NULL = linear */
+    uint8_t  pwm_ch;
+    uint8_t  key;          /* Index of the keyframe being played */
+    uint8_t  active;
+    uint16_t from;         /* Level at the start of the segment */
+    uint16_t level;        /* Current level */
+    uint32_t elapsed;      /* Periods into the segment */
+    uint32_t duration;     /* Segment length in periods */
+    uint32_t delay;        /* Periods to wait before the first keyframe */
+} fade_channel_t;
+
+#define FADE_MAX_CHANNELS  PWM_NUM_CHANNELS
+
+fade_channel_t fade_channels[FADE_MAX_CHANNELS];
+uint32_t fade_num_channels = 0;
+
+/*******************************************************************************
+ * Interrupt Helpers
+ ******************************************************************************/
+
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/*******************************************************************************
+ * PWM Driver
+ ******************************************************************************/
+
+/**
+ * Convert a 16-bit duty cycle into a match value (see Multi-Channel-PWM).
+ * MR = 0 is 100%, MR = period is 0%, and values inside the guard band are
+ * raised to the guard so that updates at the period start are safe.
+ */
+static inline uint32_t pwm_duty_to_match(pwm_timer_id_t t, uint16_t duty) {
+    uint32_t period = pwm_period[t];
+    uint32_t scale = (uint32_t)duty + (duty >> 15);
+    uint32_t high = (uint32_t)(((uint64_t)period * scale) >> 16);
+    uint32_t match = period - high;
+
+    if (match != 0 && match < pwm_guard[t]) match = pwm_guard[t];
+    return match;
+}
+
+/**
+ * Run all four timers in PWM mode at one frequency, phase-aligned.
+ * Only CT32B0 interrupts - its period match drives the fade engine.
+ */
+void pwm_init_shared(uint32_t frequency) {
+    uint32_t ticks = SYSTEM_CLOCK / frequency;
+
+    for (int t = 0; t < PWM_NUM_TIMERS; t++) {
+        const pwm_timer_info_t *ti = &pwm_timers[t];
+        uint32_t base = ti->base;
+        uint32_t prescale = (ticks - 1) / ti->max_count + 1;
+
+        SYSAHBCLKCTRL |= ti->clk_bit;
+
+        TMR_TCR(base) = 0x02;           /* Hold in reset */
+        TMR_PR(base) = prescale - 1;
+
+        pwm_period[t] = ticks / prescale;
+        pwm_guard[t] = PWM_GUARD_CYCLES / prescale;
+        TMR_MR(base, 3) = pwm_period[t] - 1;
+
+        for (int n = 0; n < PWM_CHANNELS_PER_TIMER; n++) {
+            TMR_MR(base, n) = pwm_period[t];   /* 0% */
+        }
+
+        TMR_MCR(base) = MCR_MR3R;
+        TMR_PWMC(base) = 0;
+        TMR_IR(base) = 0x1F;
+    }
+
+    TMR_MCR(CT32B0_BASE) = MCR_MR3R | MCR_MR3I;
+    NVIC_ISER1 = (1 << (CT32B0_IRQn - 32));
+
+    /* Release all timers back to back so they stay phase-aligned */
+    for (int t = 0; t < PWM_NUM_TIMERS; t++) {
+        TMR_TCR(pwm_timers[t].base) = 0x01;
+    }
+}
+
+/**
+ * Route a channel to its pin and enable PWM mode on its match output.
+ * Returns 0 if the channel has no pin on this package.
+ */
+uint8_t pwm_enable_channel(pwm_channel_t ch) {
+    const pwm_pin_t *pin = &pwm_pins[ch];
+    uint32_t base = pwm_timers[ch / PWM_CHANNELS_PER_TIMER].base;
+
+    if (pin->iocon == 0) return 0;
+
+    SYSAHBCLKCTRL |= IOCON_CLK;
+    IOCON_REG(pin->iocon) = pin->func;
+    TMR_PWMC(base) |= (1 << (ch % PWM_CHANNELS_PER_TIMER));
+    return 1;
+}
+
+/*******************************************************************************
+ * Fade Engine - Curves
+ ******************************************************************************/
+
+/**
+ * Apply an easing curve to progress p (Q16, 0 .. 0x10000).
+ * Returns the eased progress in the same format.
+ */
+static inline uint32_t fade_ease(uint8_t ease, uint32_t p) {
+    uint32_t q;
+
+    switch (ease) {
+        case EASE_IN:
+            return (p * p) >> 16;
+        case EASE_OUT:
+            q = 0x10000 - p;
+            return 0x10000 - ((q * q) >> 16);
+        case EASE_IN_OUT:
+            /* p^2 * (3 - 2p) */
+            q = (p * p) >> 16;
+            return (uint32_t)(((uint64_t)q * (0x30000 - 2 * p)) >> 16);
+        case EASE_STEP:
+            return (p >= 0x10000) ? 0x10000 : 0;
+        default:
+            return p;
+    }
+}
+
+/**
+ * Perceived brightness to duty cycle: look up the two table entries
+ * around the level and interpolate between them, so all 16 bits of the
+ * level are used. level >> 6 selects the entry, the low 6 bits weight it.
+ */
+static inline uint16_t fade_gamma(const uint16_t *table, uint16_t level) {
+    if (table == 0) return level;
+
+    uint32_t idx = level >> 6;
+    uint32_t frac = level & 0x3F;
+    uint32_t a = table[idx];
+    uint32_t b = (idx < GAMMA_MAX_IDX) ? table[idx + 1] : a;
+
+    return (uint16_t)(a + (((b - a) * frac) >> 6));
+}
+
+/*******************************************************************************
+ * Fade Engine - Sequencer
+ ******************************************************************************/
+
+/**
+ * Start the keyframe at fc->key from the current level
+ */
+static void fade_begin_key(fade_channel_t *fc) {
+    uint32_t periods = ((uint32_t)fc->seq->keys[fc->key].time_ms
+                        * PWM_FREQUENCY) / 1000;
+
+    /* elapsed << 16 must fit in 32 bits */
+    if (periods > 0xFFFF) periods = 0xFFFF;
+
+    fc->from = fc->level;
+    fc->elapsed = 0;
+    fc->duration = periods;
+}
+
+/**
+ * Advance one channel by one PWM period and return its new level
+ */
+static uint16_t fade_step(fade_channel_t *fc) {
+    if (!fc->active) return fc->level;
+
+    if (fc->delay) {
+        fc->delay--;
+        return fc->level;
+    }
+
+    const fade_key_t *k = &fc->seq->keys[fc->key];
+
+    if (fc->elapsed < fc->duration) fc->elapsed++;
+
+    if (fc->elapsed >= fc->duration) {
+        /* Segment done: land exactly on the target, move to the next key */
+        fc->level = k->level;
+
+        if (++fc->key >= fc->seq->count) {
+            if (!fc->seq->loop) {
+                fc->active = 0;
+                return fc->level;
+            }
+            fc->key = 0;
+        }
+        fade_begin_key(fc);
+        return fc->level;
+    }
+
+    uint32_t p = (fc->elapsed << 16) / fc->duration;
+    uint32_t e = fade_ease(k->ease, p);
+    int32_t diff = (int32_t)k->level - (int32_t)fc->from;
+
+    fc->level = (uint16_t)(fc->from + (int32_t)(((int64_t)diff * e) >> 16));
+    return fc->level;
+}
+
+/*******************************************************************************
+ * Fade Engine - Interrupt
+ ******************************************************************************/
+
+/* Match values computed for the next period, written by the next interrupt */
+static uint32_t fade_match[FADE_MAX_CHANNELS];
+
+/**
+ * CT32B0 period match: write last period's results, then compute the
+ * next ones.
+ *
+ * The writes come first and are a short loop, so they finish inside the
+ * guard band no matter how many channels the engine drives. The fade
+ * calculations run afterwards, while the outputs are already counting.
+ * The one-period pipeline delay (1 ms) is invisible.
+ *
+ * A switch to 100% (MR = 0) is done in two steps as in Multi-Channel-PWM:
+ * the guard value first, then 0 once TC has passed it and the output is
+ * HIGH, so the output never misses a pulse on the way to full brightness.
+ */
+void CT32B0_IRQHandler(void) {
+    uint32_t to_full = 0;
+
+    TMR_IR(CT32B0_BASE) = IR_MR3;
+
+    for (uint32_t i = 0; i < fade_num_channels; i++) {
+        uint32_t ch = fade_channels[i].pwm_ch;
+        uint32_t t = ch / PWM_CHANNELS_PER_TIMER;
+        volatile uint32_t *mr = &TMR_MR(pwm_timers[t].base,
+                                        ch % PWM_CHANNELS_PER_TIMER);
+        uint32_t match = fade_match[i];
+
+        if (match == 0 && *mr != 0) {
+            *mr = pwm_guard[t];
+            to_full |= (1u << i);
+        } else {
+            *mr = match;
+        }
+    }
+
+    for (uint32_t m = to_full; m; m &= m - 1) {
+        uint32_t i = __builtin_ctz(m);
+        uint32_t ch = fade_channels[i].pwm_ch;
+        uint32_t t = ch / PWM_CHANNELS_PER_TIMER;
+        uint32_t base = pwm_timers[t].base;
+
+        while (TMR_TC(base) < pwm_guard[t]);   /* At most the guard band */
+        TMR_MR(base, ch % PWM_CHANNELS_PER_TIMER) = 0;
+    }
+
+    for (uint32_t i = 0; i < fade_num_channels; i++) {
+        fade_channel_t *fc = &fade_channels[i];
+        uint16_t duty = fade_gamma(fc->gamma, fade_step(fc));
+
+        fade_match[i] = pwm_duty_to_match(fc->pwm_ch / PWM_CHANNELS_PER_TIMER,
+                                          duty);
+    }
+}
+
+/*******************************************************************************
+ * Fade Engine - API
+ ******************************************************************************/
+
+/**
+ * Add a PWM channel to the engine with a gamma curve (gamma_cie,
+ * gamma_22 or 0 for linear). Returns the fade channel index, or -1 if
+ * the channel has no pin or the engine is full.
+ */
+int fade_add_channel(pwm_channel_t ch, const uint16_t *gamma) {
+    if (fade_num_channels >= FADE_MAX_CHANNELS) return -1;
+    if (!pwm_enable_channel(ch)) return -1;
+
+    uint32_t primask = irq_save();
+    uint32_t i = fade_num_channels;
+
+    fade_channels[i] = (fade_channel_t){ .pwm_ch = ch, .gamma = gamma };
+    fade_match[i] = pwm_period[ch / PWM_CHANNELS_PER_TIMER];   /* 0% */
+    fade_num_channels = i + 1;
+
+    irq_restore(primask);
+    return (int)i;
+}
+
+/**
+ * Play a keyframe sequence on a fade channel, starting from its current
+ * level after delay_ms. Replaces whatever the channel was playing.
+ */
+void fade_start(int i, const fade_seq_t *seq, uint32_t delay_ms) {
+    fade_channel_t *fc = &fade_channels[i];
+    uint32_t primask = irq_save();
+
+    fc->seq = seq;
+    fc->key = 0;
+    fc->delay = (delay_ms * PWM_FREQUENCY) / 1000;
+    fade_begin_key(fc);
+    fc->active = 1;
+
+    irq_restore(primask);
+}
+
+/**
+ * Returns 1 while a channel is still playing (looping sequences never end)
+ */
+uint8_t fade_busy(int i) {
+    return fade_channels[i].active;
+}
+
+/*******************************************************************************
+ * Demo Sequences
+ ******************************************************************************/
+
+/* Slow breath: ease in and out, rest at the bottom */
+static const fade_key_t breath_keys[] = {
+    { FADE_LEVEL_MAX, 1800, EASE_IN_OUT },
+    { FADE_LEVEL_MAX,  200, EASE_LINEAR },  /* Hold at the top */
+    { 0,              1800, EASE_IN_OUT },
+    { 0,               600, EASE_LINEAR },  /* Rest */
+};
+static const fade_seq_t breath = { breath_keys, 4, 1 };
+
+/* Heartbeat: two fast beats with an ease-out attack and ease-in decay */
+static const fade_key_t heartbeat_keys[] = {
+    { FADE_LEVEL_MAX,    60, EASE_OUT },
+    { 0x3000,           180, EASE_IN  },
+    { 0xC000,            60, EASE_OUT },
+    { 0,                350, EASE_IN  },
+    { 0,                550, EASE_LINEAR },
+};
+static const fade_seq_t heartbeat = { heartbeat_keys, 5, 1 };
+
+/* Slow linear ramp - compare the two gamma curves side by side */
+static const fade_key_t ramp_keys[] = {
+    { FADE_LEVEL_MAX, 4000, EASE_LINEAR },
+    { 0,              4000, EASE_LINEAR },
+};
+static const fade_seq_t ramp = { ramp_keys, 2, 1 };
+
+/*******************************************************************************
+ * Main Function
+ ******************************************************************************/
+
+int main(void) {
+    static const pwm_channel_t breath_channels[] = {
+        PWM_16B0_MAT0, PWM_16B0_MAT1, PWM_16B1_MAT0, PWM_16B1_MAT1,
+    };
+    int fc;
+
+    pwm_init_shared(PWM_FREQUENCY);
+
+    /* LEDs 1-4: the same breath, each 500 ms behind the previous one */
+    for (uint32_t i = 0; i < 4; i++) {
+        fc = fade_add_channel(breath_channels[i], gamma_cie);
+        if (fc >= 0) fade_start(fc, &breath, i * 500);
+    }
+
+    /* LEDs 5-6: heartbeat, the second LED half a beat later */
+    fc = fade_add_channel(PWM_32B0_MAT0, gamma_cie);
+    if (fc >= 0) fade_start(fc, &heartbeat, 0);
+    fc = fade_add_channel(PWM_32B0_MAT1, gamma_cie);
+    if (fc >= 0) fade_start(fc, &heartbeat, 600);
+
+    /* LEDs 7-8: identical linear ramps, CIE vs gamma 2.2 correction */
+    fc = fade_add_channel(PWM_32B1_MAT0, gamma_cie);
+    if (fc >= 0) fade_start(fc, &ramp, 0);
+    fc = fade_add_channel(PWM_32B1_MAT1, gamma_22);
+    if (fc >= 0) fade_start(fc, &ramp, 0);
+
+    /* Everything else happens in the PWM interrupt */
+    while (1) {
+        __asm volatile ("wfi");
+    }
+
+    return 0;
+}
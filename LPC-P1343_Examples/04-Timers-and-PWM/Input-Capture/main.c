@@ -0,0 +1,513 @@
+/**
+ * Chapter 4: Timers and PWM - Input Capture Example
+ *
+ * Measures frequency, period and duty cycle of external signals using the
+ * capture inputs (CR0) of the 32-bit timers. The capture ISR only records a
+ * timestamp and the pin level into a ring buffer; all statistics are
+ * computed later, in the main loop, when results are needed.
+ *
+ * For inputs that are too fast for one interrupt per edge, the second timer
+ * runs in counter mode (CTCR): the TC counts edges in hardware and the main
+ * loop reads it once per gate interval.
+ *
+ * Concepts demonstrated:
+ *   - Capture Control Register (CCR) edge selection and capture interrupt
+ *   - Capture Register (CR0) timestamps at full 72 MHz resolution
+ *   - Minimal ISR: timestamp into a power-of-2 ring buffer, nothing else
+ *   - Lazy period/duty/frequency statistics in the main loop
+ *   - Count Control Register (CTCR) counter mode for high-frequency inputs
+ *   - Wrap-safe unsigned timestamp arithmetic
+ *
+ * Hardware:
+ *   - P1.5: CT32B0_CAP0 capture input (edge timestamps)
+ *   - P1.0: CT32B1_CAP0 counter input (edge counting)
+ *   - P0.8: CT16B0_MAT0 1 kHz / 25% test signal - jumper to P1.5 and P1.0
+ *   - P1.7: UART TXD (115200 8N1 results report)
+ *   - P3.0-P3.3: Status LEDs
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+#define UARTCLKDIV     (*((volatile uint32_t *)0x40048098))
+
+/* IOCON */
+#define IOCON_PIO0_8   (*((volatile uint32_t *)0x40044060))
+#define IOCON_R_PIO1_0 (*((volatile uint32_t *)0x40044078))
+#define IOCON_PIO1_5   (*((volatile uint32_t *)0x400440A0))
+#define IOCON_PIO1_7   (*((volatile uint32_t *)0x400440A8))
+#define IOCON_PIO3_0   (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1   (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2   (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3   (*((volatile uint32_t *)0x400440AC))
+
+/* GPIO Port 1 (capture pin levels) */
+#define GPIO1DATA      (*((volatile uint32_t *)0x50013FFC))
+
+/* GPIO Port 3 (status LEDs) */
+#define GPIO3DIR       (*((volatile uint32_t *)0x50038000))
+#define GPIO3DATA      (*((volatile uint32_t *)0x50033FFC))
+
+/* 32-bit timers share one register layout, so the capture driver
+ * addresses them through a base address plus register offset. */
+#define CT32B0_BASE    0x40014000
+#define CT32B1_BASE    0x40018000
+
+#define TMR_IR(b)      (*((volatile uint32_t *)((b) + 0x00)))  /* Interrupt */
+#define TMR_TCR(b)     (*((volatile uint32_t *)((b) + 0x04)))  /* Control */
+#define TMR_TC(b)      (*((volatile uint32_t *)((b) + 0x08)))  /* Counter */
+#define TMR_PR(b)      (*((volatile uint32_t *)((b) + 0x0C)))  /* Prescaler */
+#define TMR_MCR(b)     (*((volatile uint32_t *)((b) + 0x14)))  /* Match Control */
+#define TMR_CCR(b)     (*((volatile uint32_t *)((b) + 0x28)))  /* Capture Control */
+#define TMR_CR0(b)     (*((volatile uint32_t *)((b) + 0x2C)))  /* Capture 0 */
+#define TMR_CTCR(b)    (*((volatile uint32_t *)((b) + 0x70)))  /* Count Control */
+
+/* CT16B0 Timer Registers (test signal) */
+#define TMR16B0TCR     (*((volatile uint32_t *)0x4000C004))
+#define TMR16B0PR      (*((volatile uint32_t *)0x4000C00C))
+#define TMR16B0MCR     (*((volatile uint32_t *)0x4000C014))
+#define TMR16B0MR0     (*((volatile uint32_t *)0x4000C018))
+#define TMR16B0MR3     (*((volatile uint32_t *)0x4000C024))
+#define TMR16B0PWMC    (*((volatile uint32_t *)0x4000C074))
+
+/* UART Registers */
+#define U0THR          (*((volatile uint32_t *)0x40008000))
+#define U0DLL          (*((volatile uint32_t *)0x40008000))
+#define U0DLM          (*((volatile uint32_t *)0x40008004))
+#define U0FCR          (*((volatile uint32_t *)0x40008008))
+#define U0LCR          (*((volatile uint32_t *)0x4000800C))
+#define U0LSR          (*((volatile uint32_t *)0x40008014))
+
+/* SysTick */
+#define SYST_CSR       (*((volatile uint32_t *)0xE000E010))
+#define SYST_RVR       (*((volatile uint32_t *)0xE000E014))
+#define SYST_CVR       (*((volatile uint32_t *)0xE000E018))
+
+/* NVIC */
+#define NVIC_ISER1     (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define LED_MASK       0x0F
+#define SYSTEM_CLOCK   72000000UL
+
+/* Clock enable bits */
+#define GPIO_CLK       (1 << 6)
+#define CT16B0_CLK     (1 << 7)
+#define CT32B0_CLK     (1 << 9)
+#define CT32B1_CLK     (1 << 10)
+#define UART_CLK       (1 << 12)
+#define IOCON_CLK      (1 << 16)
+
+/* IRQ numbers */
+#define CT32B0_IRQn    43
+#define CT32B1_IRQn    44
+
+/* Capture Control Register bits (CAP0) */
+#define CCR_CAP0RE     (1 << 0)   /* Capture on rising edge */
+#define CCR_CAP0FE     (1 << 1)   /* Capture on falling edge */
+#define CCR_CAP0I      (1 << 2)   /* Interrupt on capture */
+
+/* Interrupt Register: CR0 capture flag */
+#define IR_CR0         (1 << 4)
+
+/* Count Control Register: mode field [1:0], input select [3:2] = CAP0 */
+#define CTCR_TIMER     0x00
+#define CTCR_RISING    0x01
+#define CTCR_FALLING   0x02
+#define CTCR_BOTH      0x03
+
+/* Ring buffer of edge events - must be power of 2 */
+#define ICAP_RING_SIZE 64
+
+/* Gate time for counter mode and report interval */
+#define GATE_MS        1000
+
+/* Test signal on CT16B0_MAT0: 1 MHz timer clock, 1000 ticks = 1 kHz */
+#define TEST_PERIOD    1000
+#define TEST_HIGH      250
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+/* One captured edge: CR0 value plus the pin level sampled in the ISR */
+typedef struct {
+    uint32_t timestamp;
+    uint32_t level;
+} icap_event_t;
+
+/* Running statistics for one quantity (period or high time), in ticks */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} icap_stat_t;
+
+typedef struct {
+    uint32_t base;         /* Timer base address */
+    uint32_t pin_mask;     /* Capture pin bit in GPIO1DATA */
+
+    /* Written by ISR */
+    volatile icap_event_t ring[ICAP_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t overruns;
+
+    /* Owned by main loop (tail is read by the ISR for the full check) */
+    volatile uint32_t tail;
+    uint32_t last_rise;
+    uint8_t have_rise;
+    icap_stat_t period;
+    icap_stat_t high;
+} icap_channel_t;
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+
+volatile uint32_t ms_ticks = 0;
+
+icap_channel_t icap0 = { .base = CT32B0_BASE, .pin_mask = (1 << 5) };
+
+/* Counter-mode state */
+uint32_t counter_last = 0;
+uint32_t counter_hz = 0;
+
+/*******************************************************************************
+ * Interrupt Handlers
+ ******************************************************************************/
+
+void SysTick_Handler(void) {
+    ms_ticks++;
+}
+
+/**
+ * Capture ISR body - works for either 32-bit timer.
+ *
+ * Does only what must happen at interrupt time: latch CR0, sample the pin
+ * level so the main loop knows which edge this was, and push the pair into
+ * the ring. No division, no statistics.
+ */
+static inline void icap_isr(icap_channel_t *ch) {
+    uint32_t base = ch->base;
+
+    if (TMR_IR(base) & IR_CR0) {
+        TMR_IR(base) = IR_CR0;
+
+        uint32_t head = ch->head;
+        uint32_t next = (head + 1) & (ICAP_RING_SIZE - 1);
+
+        if (next != ch->tail) {
+            ch->ring[head].timestamp = TMR_CR0(base);
+            ch->ring[head].level = GPIO1DATA & ch->pin_mask;
+            ch->head = next;
+        } else {
+            ch->overruns++;
+        }
+    }
+}
+
+void CT32B0_IRQHandler(void) {
+    icap_isr(&icap0);
+}
+
+/*******************************************************************************
+ * Input Capture Driver
+ ******************************************************************************/
+
+static void stat_reset(icap_stat_t *s) {
+    s->count = 0;
+    s->min = 0xFFFFFFFF;
+    s->max = 0;
+    s->sum = 0;
+}
+
+static void stat_add(icap_stat_t *s, uint32_t ticks) {
+    s->count++;
+    s->sum += ticks;
+    if (ticks < s->min) s->min = ticks;
+    if (ticks > s->max) s->max = ticks;
+}
+
+/**
+ * Start a 32-bit timer as a free-running timestamp counter with CR0
+ * capturing both edges of CAP0. PR = 0 gives 13.9 ns resolution; the TC
+ * wraps every ~59.6 s, which unsigned subtraction handles transparently.
+ */
+void icap_init(icap_channel_t *ch, uint32_t irqn) {
+    uint32_t base = ch->base;
+
+    ch->head = 0;
+    ch->tail = 0;
+    ch->overruns = 0;
+    ch->have_rise = 0;
+    stat_reset(&ch->period);
+    stat_reset(&ch->high);
+
+    TMR_TCR(base) = 0x02;      /* Reset */
+    TMR_CTCR(base) = CTCR_TIMER;
+    TMR_PR(base) = 0;
+    TMR_MCR(base) = 0;         /* No match actions - free running */
+    TMR_CCR(base) = CCR_CAP0RE | CCR_CAP0FE | CCR_CAP0I;
+    TMR_IR(base) = 0x1F;       /* Clear all flags */
+
+    NVIC_ISER1 = (1 << (irqn - 32));
+    TMR_TCR(base) = 0x01;      /* Start */
+}
+
+/**
+ * Drain the ring and fold new edges into the statistics.
+ *
+ * Rising-to-rising gives the period, rising-to-falling gives the high time.
+ * Called from the main loop only, so the ISR never pays for any of this.
+ */
+void icap_process(icap_channel_t *ch) {
+    uint32_t head = ch->head;
+
+    while (ch->tail != head) {
+        icap_event_t ev;
+        ev.timestamp = ch->ring[ch->tail].timestamp;
+        ev.level = ch->ring[ch->tail].level;
+        ch->tail = (ch->tail + 1) & (ICAP_RING_SIZE - 1);
+
+        if (ev.level) {
+            if (ch->have_rise) {
+                stat_add(&ch->period, ev.timestamp - ch->last_rise);
+            }
+            ch->last_rise = ev.timestamp;
+            ch->have_rise = 1;
+        } else if (ch->have_rise) {
+            stat_add(&ch->high, ev.timestamp - ch->last_rise);
+        }
+    }
+}
+
+/**
+ * Frequency in milli-Hz from the mean period of the current window
+ */
+uint32_t icap_frequency_mhz(const icap_channel_t *ch) {
+    if (ch->period.count == 0 || ch->period.sum == 0) return 0;
+    return (uint32_t)(((uint64_t)SYSTEM_CLOCK * 1000 * ch->period.count)
+                      / ch->period.sum);
+}
+
+/**
+ * Duty cycle in 0.1% units from mean high time over mean period
+ */
+uint32_t icap_duty_permille(const icap_channel_t *ch) {
+    if (ch->period.count == 0 || ch->high.count == 0) return 0;
+    uint64_t high_mean = ch->high.sum / ch->high.count;
+    uint64_t period_mean = ch->period.sum / ch->period.count;
+    return (uint32_t)((high_mean * 1000) / period_mean);
+}
+
+void icap_reset_stats(icap_channel_t *ch) {
+    stat_reset(&ch->period);
+    stat_reset(&ch->high);
+}
+
+/*******************************************************************************
+ * Counter Mode
+ ******************************************************************************/
+
+/**
+ * Clock a 32-bit timer from CAP0 edges instead of PCLK.
+ *
+ * The TC increments in hardware on every selected edge, so no interrupt is
+ * taken per edge. The input must stay below PCLK/4 (18 MHz at 72 MHz).
+ */
+void counter_init(uint32_t base, uint32_t edge_mode) {
+    TMR_TCR(base) = 0x02;
+    TMR_CTCR(base) = edge_mode;  /* Input select [3:2] = 00 -> CAP0 */
+    TMR_PR(base) = 0;
+    TMR_MCR(base) = 0;
+    TMR_CCR(base) = 0;           /* CAP0 is the clock, not a capture */
+    TMR_TCR(base) = 0x01;
+}
+
+/**
+ * Edge count since the last call - call once per gate interval
+ */
+uint32_t counter_read_delta(uint32_t base) {
+    uint32_t now = TMR_TC(base);
+    uint32_t delta = now - counter_last;
+    counter_last = now;
+    return delta;
+}
+
+/*******************************************************************************
+ * Test Signal
+ ******************************************************************************/
+
+/**
+ * 1 kHz, 25% duty on P0.8 (CT16B0_MAT0) so the example can measure
+ * itself. In PWM mode the output is LOW until TC reaches MR0, then HIGH
+ * until the period match resets the counter.
+ */
+void test_signal_init(void) {
+    SYSAHBCLKCTRL |= CT16B0_CLK;
+    IOCON_PIO0_8 = 0x02;                   /* FUNC = CT16B0_MAT0 */
+
+    TMR16B0TCR = 0x02;
+    TMR16B0PR = (SYSTEM_CLOCK / 1000000) - 1;   /* 1 MHz */
+    TMR16B0MR3 = TEST_PERIOD - 1;
+    TMR16B0MR0 = TEST_PERIOD - TEST_HIGH;
+    TMR16B0MCR = (1 << 10);                /* Reset on MR3 */
+    TMR16B0PWMC = (1 << 0);
+    TMR16B0TCR = 0x01;
+}
+
+/*******************************************************************************
+ * UART Output
+ ******************************************************************************/
+
+void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= UART_CLK;
+    UARTCLKDIV = 1;
+    IOCON_PIO1_7 = 0x01;  /* TXD */
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+void uart_putchar(char c) {
+    while (!(U0LSR & (1 << 5)));
+    U0THR = c;
+}
+
+void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+void print_number(uint32_t n) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/**
+ * Print a fixed-point value with the given number of decimal places
+ */
+void print_fixed(uint32_t value, uint32_t scale, uint8_t decimals) {
+    print_number(value / scale);
+    uart_putchar('.');
+    uint32_t frac = value % scale;
+    for (uint32_t d = scale / 10; d > 0 && decimals > 0; d /= 10, decimals--) {
+        uart_putchar('0' + (frac / d) % 10);
+    }
+}
+
+/*******************************************************************************
+ * LED Functions
+ ******************************************************************************/
+
+void leds_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO3DIR |= LED_MASK;
+    GPIO3DATA |= LED_MASK;
+}
+
+/*******************************************************************************
+ * Report
+ ******************************************************************************/
+
+void report(icap_channel_t *ch) {
+    uart_puts("CAP  f=");
+    print_fixed(icap_frequency_mhz(ch), 1000, 3);
+    uart_puts(" Hz  duty=");
+    print_fixed(icap_duty_permille(ch), 10, 1);
+    uart_puts("%  period min/max=");
+    print_number(ch->period.count ? ch->period.min : 0);
+    uart_putchar('/');
+    print_number(ch->period.max);
+    uart_puts(" ticks  edges=");
+    print_number(ch->period.count);
+    uart_puts("  overruns=");
+    print_number(ch->overruns);
+    uart_puts("\r\n");
+
+    uart_puts("CNT  f=");
+    print_number(counter_hz);
+    uart_puts(" Hz\r\n");
+}
+
+/*******************************************************************************
+ * Main Function
+ ******************************************************************************/
+
+int main(void) {
+    uint32_t last_report = 0;
+
+    SYSAHBCLKCTRL |= IOCON_CLK | CT32B0_CLK | CT32B1_CLK;
+
+    leds_init();
+    uart_init(115200);
+    test_signal_init();
+
+    /* 1 ms SysTick for the gate interval */
+    SYST_RVR = (SYSTEM_CLOCK / 1000) - 1;
+    SYST_CVR = 0;
+    SYST_CSR = 0x07;
+
+    /* P1.5 -> CT32B0_CAP0: timestamp every edge */
+    IOCON_PIO1_5 = 0x02;
+    icap_init(&icap0, CT32B0_IRQn);
+
+    /* P1.0 -> CT32B1_CAP0: count rising edges in hardware.
+     * ADMODE (bit 7) = 1 selects digital mode on this analog-capable pin. */
+    IOCON_R_PIO1_0 = 0x03 | (1 << 7);
+    counter_init(CT32B1_BASE, CTCR_RISING);
+
+    uart_puts("\r\nLPC1343 Input Capture\r\n");
+    uart_puts("Jumper P0.8 -> P1.5 and P1.0 for the 1 kHz / 25% test signal\r\n\r\n");
+
+    while (1) {
+        /* Fold new edges into the statistics whenever we have time */
+        icap_process(&icap0);
+
+        if ((ms_ticks - last_report) >= GATE_MS) {
+            last_report += GATE_MS;
+
+            counter_hz = counter_read_delta(CT32B1_BASE) * (1000 / GATE_MS);
+
+            report(&icap0);
+            icap_reset_stats(&icap0);
+
+            /* LED0 on while a signal is present */
+            if (counter_hz) {
+                GPIO3DATA &= ~(1 << 0);
+            } else {
+                GPIO3DATA |= (1 << 0);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,828 @@
+/**
+ * Chapter 4: Timers and PWM - Multi-Channel PWM Example
+ *
+ * A PWM driver that exposes match registers MR0-MR2 of all four timers
+ * (CT16B0, CT16B1, CT32B0, CT32B1) as 12 independent channels. MR3 of
+ * each timer sets the period, either shared by all timers or chosen per
+ * timer. A batch API writes any set of channels in one call.
+ *
+ * Duty updates never touch the match registers directly. They are staged
+ * in shadow values and committed by the period-match (MR3) interrupt, so
+ * a batch of channels changes together on one period boundary and no
+ * output ever sees a runt or missing pulse.
+ *
+ * The demo drives eight LEDs with a rotating brightness wave, updating
+ * all eight duty cycles with a single pwm_write_batch() call every 10 ms.
+ * Before it starts, a loopback self-test captures every edge of one
+ * channel while its duty cycle is changed at random points in the period,
+ * and reports any runt or missing pulse over the UART.
+ *
+ * Concepts demonstrated:
+ *   - Identical register layout across the four counter/timers
+ *   - Channel table: timer, match register and pin function per channel
+ *   - Prescaler selection so 16-bit timers reach low frequencies
+ *   - 16-bit duty cycle scaled to each timer's period
+ *   - 0% and 100% duty without glitches (MR > period, MR = 0)
+ *   - Batch update of many channels
+ *   - Shadow match values committed in the MR3 interrupt
+ *   - Guard band so a commit always lands before the earliest edge
+ *   - Input capture as a logic analyser for the glitch self-test
+ *
+ * Hardware (channels enabled by the demo):
+ *   - P0.8:  CT16B0_MAT0    - P0.9:  CT16B0_MAT1
+ *   - P1.9:  CT16B1_MAT0    - P1.10: CT16B1_MAT1
+ *   - P1.6:  CT32B0_MAT0    - P1.7:  CT32B0_MAT1
+ *   - P1.1:  CT32B1_MAT0    - P1.2:  CT32B1_MAT1
+ *   Connect each pin to an LED with a 330 ohm resistor to GND.
+ *
+ * Self-test (PWM_SELFTEST):
+ *   - P0.8 (CT16B0_MAT0) wired to P1.0 (CT32B1_CAP0)
+ *   - P1.7: UART TXD (115200 8N1), before the demo takes the pin over
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+
+/* IOCON - PWM-capable pins */
+#define IOCON_PIO0_1        0x40044010
+#define IOCON_PIO1_9        0x40044038
+#define IOCON_PIO0_8        0x40044060
+#define IOCON_PIO0_9        0x40044064
+#define IOCON_SWCLK_PIO0_10 0x40044068
+#define IOCON_PIO1_10       0x4004406C
+#define IOCON_R_PIO1_0      0x40044078
+#define IOCON_R_PIO1_1      0x4004407C
+#define IOCON_R_PIO1_2      0x40044080
+#define IOCON_SWDIO_PIO1_3  0x40044090
+#define IOCON_PIO1_6        0x400440A4
+#define IOCON_PIO1_7        0x400440A8
+
+#define IOCON_REG(addr)     (*((volatile uint32_t *)(addr)))
+
+/* Timer base addresses - all four share the same register layout */
+#define CT16B0_BASE    0x4000C000
+#define CT16B1_BASE    0x40010000
+#define CT32B0_BASE    0x40014000
+#define CT32B1_BASE    0x40018000
+
+#define TMR_IR(b)      (*((volatile uint32_t *)((b) + 0x00)))
+#define TMR_TCR(b)     (*((volatile uint32_t *)((b) + 0x04)))
+#define TMR_TC(b)      (*((volatile uint32_t *)((b) + 0x08)))
+#define TMR_PR(b)      (*((volatile uint32_t *)((b) + 0x0C)))
+#define TMR_MCR(b)     (*((volatile uint32_t *)((b) + 0x14)))
+#define TMR_MR(b, n)   (*((volatile uint32_t *)((b) + 0x18 + 4 * (n))))
+#define TMR_CCR(b)     (*((volatile uint32_t *)((b) + 0x28)))
+#define TMR_CR0(b)     (*((volatile uint32_t *)((b) + 0x2C)))
+#define TMR_PWMC(b)    (*((volatile uint32_t *)((b) + 0x74)))
+
+/* NVIC */
+#define NVIC_ISER1     (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+#define NVIC_IPR(irq)  (*((volatile uint8_t *)(0xE000E400 + (irq))))
+
+/* UART (self-test report) */
+#define UARTCLKDIV     (*((volatile uint32_t *)0x40048098))
+#define U0THR          (*((volatile uint32_t *)0x40008000))
+#define U0DLL          (*((volatile uint32_t *)0x40008000))
+#define U0DLM          (*((volatile uint32_t *)0x40008004))
+#define U0FCR          (*((volatile uint32_t *)0x40008008))
+#define U0LCR          (*((volatile uint32_t *)0x4000800C))
+#define U0LSR          (*((volatile uint32_t *)0x40008014))
+
+/* SysTick */
+#define SYST_CSR       (*((volatile uint32_t *)0xE000E010))
+#define SYST_RVR       (*((volatile uint32_t *)0xE000E014))
+#define SYST_CVR       (*((volatile uint32_t *)0xE000E018))
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define SYSTEM_CLOCK   72000000UL
+#define PWM_FREQUENCY  1000      /* Shared frequency for the demo */
+
+/* Clock enable bits */
+#define CT16B0_CLK     (1 << 7)
+#define CT16B1_CLK     (1 << 8)
+#define CT32B0_CLK     (1 << 9)
+#define CT32B1_CLK     (1 << 10)
+#define UART_CLK       (1 << 12)
+#define IOCON_CLK      (1 << 16)
+
+/* IOCON ADMODE bit: 1 = digital on analog-capable pins */
+#define IOCON_ADMODE   (1 << 7)
+
+/* MCR bits: interrupt and reset on MR3 */
+#define MCR_MR3I       (1 << 9)
+#define MCR_MR3R       (1 << 10)
+
+/* IR bits: MR3 match and CR0 capture flags */
+#define IR_MR3         (1 << 3)
+#define IR_CR0         (1 << 4)
+
+/* CCR bits: capture CAP0 on both edges with interrupt */
+#define CCR_CAP0_BOTH  ((1 << 0) | (1 << 1) | (1 << 2))
+
+/* UART LSR bits */
+#define LSR_THRE       (1 << 5)
+#define LSR_TEMT       (1 << 6)
+
+/* IRQ numbers */
+#define CT16B0_IRQn    41
+#define CT16B1_IRQn    42
+#define CT32B0_IRQn    43
+#define CT32B1_IRQn    44
+
+/* Commits run at the start of a period. No match value other than 0 is
+ * allowed below this many CPU cycles, so the MR3 interrupt always finishes
+ * writing before TC can reach any edge. Covers interrupt latency plus the
+ * commit loop for all 12 channels with a wide margin. */
+#define PWM_GUARD_CYCLES 256
+
+/* Duty cycle scale: 0 = always low, PWM_DUTY_FULL = always high */
+#define PWM_DUTY_FULL  0xFFFF
+
+/* Loopback glitch test before the demo. Needs P0.8 wired to P1.0; without
+ * the wire it reports that no edges were seen. 0 = straight to the demo. */
+#ifndef PWM_SELFTEST
+#define PWM_SELFTEST   1
+#endif
+
+#define ST_ROUNDS      8        /* Passes through the duty sequence */
+#define ST_HOLD        4        /* Periods each duty is held, at least */
+#define ST_TOLERANCE   4        /* Cycles of capture uncertainty */
+#define ST_MAX_EDGES   192
+
+/*******************************************************************************
+ * PWM Driver Types
+ ******************************************************************************/
+
+typedef enum {
+    PWM_CT16B0,
+    PWM_CT16B1,
+    PWM_CT32B0,
+    PWM_CT32B1,
+    PWM_NUM_TIMERS
+} pwm_timer_id_t;
+
+/* Channel = timer * 3 + match register (MR0..MR2) */
+typedef enum {
+    PWM_16B0_MAT0, PWM_16B0_MAT1, PWM_16B0_MAT2,
+    PWM_16B1_MAT0, PWM_16B1_MAT1, PWM_16B1_MAT2,
+    PWM_32B0_MAT0, PWM_32B0_MAT1, PWM_32B0_MAT2,
+    PWM_32B1_MAT0, PWM_32B1_MAT1, PWM_32B1_MAT2,
+    PWM_NUM_CHANNELS
+} pwm_channel_t;
+
+#define PWM_CHANNELS_PER_TIMER 3
+
+typedef struct {
+    uint32_t base;
+    uint32_t clk_bit;
+    uint32_t max_count;    /* 0xFFFF for 16-bit timers */
+    uint32_t irqn;
+} pwm_timer_info_t;
+
+typedef struct {
+    uint32_t iocon;        /* IOCON register address, 0 = not pinned out */
+    uint32_t func;         /* IOCON value selecting the match function */
+} pwm_pin_t;
+
+/*******************************************************************************
+ * PWM Driver Tables
+ ******************************************************************************/
+
+static const pwm_timer_info_t pwm_timers[PWM_NUM_TIMERS] = {
+    [PWM_CT16B0] = { CT16B0_BASE, CT16B0_CLK, 0xFFFF,     CT16B0_IRQn },
+    [PWM_CT16B1] = { CT16B1_BASE, CT16B1_CLK, 0xFFFF,     CT16B1_IRQn },
+    [PWM_CT32B0] = { CT32B0_BASE, CT32B0_CLK, 0xFFFFFFFF, CT32B0_IRQn },
+    [PWM_CT32B1] = { CT32B1_BASE, CT32B1_CLK, 0xFFFFFFFF, CT32B1_IRQn },
+};
+
+/* LPC1343 pin for each match output. CT16B1_MAT2 has no pin. P0.10 and
+ * P1.3 are the SWD debug pins and P0.1 is the on-board button - enabling
+ * those channels takes the pin away from its default use. */
+static const pwm_pin_t pwm_pins[PWM_NUM_CHANNELS] = {
+    [PWM_16B0_MAT0] = { IOCON_PIO0_8,        0x02 },
+    [PWM_16B0_MAT1] = { IOCON_PIO0_9,        0x02 },
+    [PWM_16B0_MAT2] = { IOCON_SWCLK_PIO0_10, 0x03 },
+    [PWM_16B1_MAT0] = { IOCON_PIO1_9,        0x01 },
+    [PWM_16B1_MAT1] = { IOCON_PIO1_10,       0x02 | IOCON_ADMODE },
+    [PWM_16B1_MAT2] = { 0,                   0 },
+    [PWM_32B0_MAT0] = { IOCON_PIO1_6,        0x02 },
+    [PWM_32B0_MAT1] = { IOCON_PIO1_7,        0x02 },
+    [PWM_32B0_MAT2] = { IOCON_PIO0_1,        0x02 },
+    [PWM_32B1_MAT0] = { IOCON_R_PIO1_1,      0x03 | IOCON_ADMODE },
+    [PWM_32B1_MAT1] = { IOCON_R_PIO1_2,      0x03 | IOCON_ADMODE },
+    [PWM_32B1_MAT2] = { IOCON_SWDIO_PIO1_3,  0x03 | IOCON_ADMODE },
+};
+
+/* Period in timer ticks (MR3 + 1) and guard band in ticks for each timer */
+uint32_t pwm_period[PWM_NUM_TIMERS];
+uint32_t pwm_guard[PWM_NUM_TIMERS];
+
+/* Channel mask of all channels on each timer */
+#define PWM_TIMER_CHANNELS(t)  (0x7u << ((t) * PWM_CHANNELS_PER_TIMER))
+
+/* Staging area, owned by the main loop */
+uint32_t pwm_staged[PWM_NUM_CHANNELS];
+uint32_t pwm_staged_mask = 0;
+
+/* Handed to the MR3 interrupt by pwm_commit() */
+volatile uint32_t pwm_pending[PWM_NUM_CHANNELS];
+volatile uint32_t pwm_pending_mask = 0;
+
+/* Channels each timer's MR3 interrupt commits. In shared mode one timer
+ * commits for all, so every channel switches on the same boundary. */
+uint32_t pwm_commit_group[PWM_NUM_TIMERS];
+
+/*******************************************************************************
+ * Interrupt Helpers
+ ******************************************************************************/
+
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/*******************************************************************************
+ * PWM Driver
+ ******************************************************************************/
+
+/**
+ * Convert a 16-bit duty cycle into a match value for a given period.
+ *
+ * A PWM output goes LOW when the timer resets and HIGH when TC reaches the
+ * match value, so the high time is (period - MR). The two ends are special:
+ *   - MR = 0 keeps the output HIGH for the whole period (100%)
+ *   - MR = period is never reached, so the output stays LOW (0%)
+ *
+ * duty + (duty >> 15) maps 0xFFFF to 0x10000 so full scale is exact and
+ * the scaling is a multiply and shift instead of a divide.
+ *
+ * Match values between 1 and the guard band are raised to the guard, so
+ * the largest duty below 100% is (period - guard) / period - 99.6% at
+ * 1 kHz. That is what makes committing at the period start safe.
+ */
+static inline uint32_t pwm_duty_to_match(pwm_timer_id_t t, uint16_t duty) {
+    uint32_t period = pwm_period[t];
+    uint32_t scale = (uint32_t)duty + (duty >> 15);
+    uint32_t high = (uint32_t)(((uint64_t)period * scale) >> 16);
+    uint32_t match = period - high;
+
+    if (match != 0 && match < pwm_guard[t]) match = pwm_guard[t];
+    return match;
+}
+
+/**
+ * Configure one timer for PWM at the given frequency.
+ *
+ * The prescaler is chosen as the smallest value that makes the period fit
+ * the counter, which keeps resolution as high as possible: 32-bit timers
+ * always run at PR = 0, 16-bit timers need PR > 0 below ~1.1 kHz.
+ * Channels keep their outputs disabled until pwm_enable_channel().
+ */
+void pwm_timer_init(pwm_timer_id_t t, uint32_t frequency) {
+    const pwm_timer_info_t *ti = &pwm_timers[t];
+    uint32_t base = ti->base;
+    uint32_t ticks = SYSTEM_CLOCK / frequency;
+    uint32_t prescale = (ticks - 1) / ti->max_count + 1;
+
+    SYSAHBCLKCTRL |= ti->clk_bit;
+
+    TMR_TCR(base) = 0x02;               /* Hold in reset */
+    TMR_PR(base) = prescale - 1;
+
+    pwm_period[t] = ticks / prescale;
+    pwm_guard[t] = PWM_GUARD_CYCLES / prescale;
+    TMR_MR(base, 3) = pwm_period[t] - 1;
+
+    /* All channels start at 0% (match never reached) */
+    for (int n = 0; n < PWM_CHANNELS_PER_TIMER; n++) {
+        TMR_MR(base, n) = pwm_period[t];
+    }
+
+    /* Reset and interrupt on MR3 - the interrupt commits staged values */
+    TMR_MCR(base) = MCR_MR3R | MCR_MR3I;
+    TMR_PWMC(base) = 0;
+    TMR_IR(base) = 0x1F;
+
+    pwm_commit_group[t] = PWM_TIMER_CHANNELS(t);
+    NVIC_ISER1 = (1 << (ti->irqn - 32));
+}
+
+/**
+ * Start a set of timers. Timers are released from reset back to back, so
+ * timers sharing a frequency stay phase-aligned within a few cycles.
+ */
+void pwm_start(uint32_t timer_mask) {
+    for (int t = 0; t < PWM_NUM_TIMERS; t++) {
+        if (timer_mask & (1 << t)) TMR_TCR(pwm_timers[t].base) = 0x02;
+    }
+    for (int t = 0; t < PWM_NUM_TIMERS; t++) {
+        if (timer_mask & (1 << t)) TMR_TCR(pwm_timers[t].base) = 0x01;
+    }
+}
+
+/**
+ * Shared-frequency mode: every timer runs at the same PWM frequency.
+ *
+ * The timers are phase-aligned, so CT32B0's period interrupt commits the
+ * channels of all four and the others don't interrupt at all. A batch that
+ * spans several timers then changes on exactly the same boundary.
+ */
+void pwm_init_shared(uint32_t frequency) {
+    for (int t = 0; t < PWM_NUM_TIMERS; t++) {
+        pwm_timer_init(t, frequency);
+        if (t != PWM_CT32B0) {
+            TMR_MCR(pwm_timers[t].base) = MCR_MR3R;
+            pwm_commit_group[t] = 0;
+        }
+    }
+    pwm_commit_group[PWM_CT32B0] = (1 << PWM_NUM_CHANNELS) - 1;
+    pwm_start((1 << PWM_NUM_TIMERS) - 1);
+}
+
+/**
+ * Period-match interrupt: move pending match values into the hardware.
+ *
+ * Runs right after TC resets, while TC is still inside the guard band, so
+ * every committed match value lies ahead of TC and takes effect in this
+ * period.
+ *
+ * Switching to 100% (MR = 0) needs care: an output only skips going LOW
+ * at reset if MR is already 0 then, and it is too late for that in this
+ * period. So the channel is given the guard value, and 0 is written once
+ * TC has passed it and the output is HIGH - it then stays HIGH through
+ * the next reset. These channels are handled last so the wait cannot
+ * delay the ordinary ones past the guard band.
+ *
+ * Leaving 100% takes effect one period late: the output is already HIGH
+ * for this period and only goes LOW again at the next reset.
+ */
+static void pwm_period_isr(pwm_timer_id_t t) {
+    TMR_IR(pwm_timers[t].base) = IR_MR3;
+
+    uint32_t pending = pwm_pending_mask & pwm_commit_group[t];
+    uint32_t to_full = 0;
+
+    pwm_pending_mask &= ~pending;
+
+    for (uint32_t m = pending; m; m &= m - 1) {
+        uint32_t ch = __builtin_ctz(m);
+        uint32_t ct = ch / PWM_CHANNELS_PER_TIMER;
+        volatile uint32_t *mr = &TMR_MR(pwm_timers[ct].base,
+                                        ch % PWM_CHANNELS_PER_TIMER);
+        uint32_t match = pwm_pending[ch];
+
+        if (match == 0 && *mr != 0) {
+            *mr = pwm_guard[ct];
+            to_full |= (1u << ch);
+        } else {
+            *mr = match;
+        }
+    }
+
+    for (uint32_t m = to_full; m; m &= m - 1) {
+        uint32_t ch = __builtin_ctz(m);
+        uint32_t ct = ch / PWM_CHANNELS_PER_TIMER;
+        uint32_t base = pwm_timers[ct].base;
+
+        while (TMR_TC(base) < pwm_guard[ct]);   /* At most the guard band */
+        TMR_MR(base, ch % PWM_CHANNELS_PER_TIMER) = 0;
+    }
+}
+
+#if PWM_SELFTEST
+static void st_capture_isr(void);
+#endif
+
+void CT16B0_IRQHandler(void) { pwm_period_isr(PWM_CT16B0); }
+void CT16B1_IRQHandler(void) { pwm_period_isr(PWM_CT16B1); }
+void CT32B0_IRQHandler(void) { pwm_period_isr(PWM_CT32B0); }
+void CT32B1_IRQHandler(void) {
+#if PWM_SELFTEST
+    if (TMR_IR(CT32B1_BASE) & IR_CR0) {
+        st_capture_isr();
+        return;
+    }
+#endif
+    pwm_period_isr(PWM_CT32B1);
+}
+
+/**
+ * Route a channel to its pin and enable PWM mode on its match output.
+ * Returns 0 if the channel has no pin on this package.
+ */
+uint8_t pwm_enable_channel(pwm_channel_t ch) {
+    const pwm_pin_t *pin = &pwm_pins[ch];
+    uint32_t base = pwm_timers[ch / PWM_CHANNELS_PER_TIMER].base;
+
+    if (pin->iocon == 0) return 0;
+
+    SYSAHBCLKCTRL |= IOCON_CLK;
+    IOCON_REG(pin->iocon) = pin->func;
+    TMR_PWMC(base) |= (1 << (ch % PWM_CHANNELS_PER_TIMER));
+    return 1;
+}
+
+/**
+ * Stage a new duty cycle (0 .. PWM_DUTY_FULL). Nothing changes on the
+ * outputs until pwm_commit().
+ */
+void pwm_stage(pwm_channel_t ch, uint16_t duty) {
+    pwm_staged[ch] = pwm_duty_to_match(ch / PWM_CHANNELS_PER_TIMER, duty);
+    pwm_staged_mask |= (1u << ch);
+}
+
+/**
+ * Hand all staged values to the period interrupt as one set.
+ *
+ * The copy runs with interrupts masked (a dozen stores), so the interrupt
+ * sees either none or all of the new values. If an earlier commit has not
+ * been applied yet, its channels are simply overwritten with newer values.
+ */
+void pwm_commit(void) {
+    uint32_t mask = pwm_staged_mask;
+    uint32_t primask = irq_save();
+
+    for (uint32_t m = mask; m; m &= m - 1) {
+        uint32_t ch = __builtin_ctz(m);
+        pwm_pending[ch] = pwm_staged[ch];
+    }
+    pwm_pending_mask |= mask;
+
+    irq_restore(primask);
+    pwm_staged_mask = 0;
+}
+
+/**
+ * Set one channel's duty cycle, effective at the next period boundary
+ */
+void pwm_set_duty(pwm_channel_t ch, uint16_t duty) {
+    pwm_stage(ch, duty);
+    pwm_commit();
+}
+
+/**
+ * Batch update: every channel whose bit is set in mask switches to its new
+ * duty cycle on the same period boundary. duty[] is indexed by channel.
+ */
+void pwm_write_batch(const uint16_t duty[PWM_NUM_CHANNELS], uint32_t mask) {
+    for (int ch = 0; ch < PWM_NUM_CHANNELS; ch++) {
+        if (mask & (1 << ch)) pwm_stage(ch, duty[ch]);
+    }
+    pwm_commit();
+}
+
+/*******************************************************************************
+ * Glitch Self-Test
+ ******************************************************************************/
+
+#if PWM_SELFTEST
+
+/* Channel under test and where it is captured */
+#define ST_CHANNEL     PWM_16B0_MAT0
+#define ST_TIMER       PWM_CT16B0
+#define ST_CT16B0_IRQn CT16B0_IRQn
+
+/**
+ * Duty sequence for one round. It starts and ends at 0%, so every round
+ * begins with a rising edge, and covers every kind of transition: 0% and
+ * 100% to and from partial duty, 0% <-> 100% directly, and both ends of
+ * the guard band (99.6% has a 282-cycle low pulse).
+ */
+static const uint16_t st_steps[] = {
+    0, 0x8000, 0, 0x4000, PWM_DUTY_FULL, 0xC000, PWM_DUTY_FULL, 0,
+    PWM_DUTY_FULL, 0xFF00, 0x0200, PWM_DUTY_FULL, 0x0200, 0,
+};
+#define ST_STEPS (sizeof(st_steps) / sizeof(st_steps[0]))
+
+/* Capture timestamps (CT32B1 TC, one per core clock). Edges alternate,
+ * starting with a rising edge. */
+uint32_t st_edges[ST_MAX_EDGES];
+volatile uint32_t st_count = 0;
+volatile uint8_t st_armed = 0;
+
+/* First bad period of the last check, for the report */
+uint32_t st_bad_period;
+uint32_t st_bad_offset;
+
+/**
+ * CAP0 interrupt, both edges. It runs above the PWM interrupts so it is
+ * never held off for longer than the shortest pulse (the guard band).
+ */
+static void st_capture_isr(void) {
+    TMR_IR(CT32B1_BASE) = IR_CR0;
+    uint32_t t = TMR_CR0(CT32B1_BASE);
+
+    if (st_armed && st_count < ST_MAX_EDGES) st_edges[st_count++] = t;
+}
+
+static uint8_t st_near(uint32_t a, uint32_t b) {
+    return (a + ST_TOLERANCE >= b) && (b + ST_TOLERANCE >= a);
+}
+
+/**
+ * Check a captured round against the duty sequence.
+ *
+ * The output falls at every period start (unless held at 100%) and rises
+ * at match x prescale cycles into the period, so each period reduces to
+ * one "rise offset": 0 for 100%, period for 0%. Periods start at the
+ * first falling edge plus multiples of the period.
+ *
+ * expect[] holds the offset of each step. The offsets must walk through
+ * expect[] in order, one step at a time; a step may last longer than
+ * planned (a commit lands one period later) but no other value may
+ * appear. The only extra value allowed is 'entry', the one period at the
+ * guard value on the way into 100%. An edge anywhere else - a runt - or
+ * a missing pulse shows up as an offset that is not in the sequence.
+ *
+ * Returns the number of bad periods.
+ */
+uint32_t st_check(const uint32_t *edge, uint32_t n, uint32_t t_end,
+                  const uint32_t *expect, uint32_t steps,
+                  uint32_t period, uint32_t entry) {
+    int32_t p = (int32_t)period;
+    int32_t first = (int32_t)(edge[1] - edge[0]);
+    int32_t b = first - ((first + p - 1) / p) * p;   /* Period of edge[0] */
+    int32_t end = (int32_t)(t_end - edge[0]);
+    uint32_t i = 0, s = 0, bad = 0, k = 0;
+    uint8_t high = 0;
+
+    for (; b + p <= end; b += p, k++) {
+        uint32_t offset;
+
+        /* Falling edge at the period start, unless held at 100% */
+        if (high && i < n && st_near(edge[i] - edge[0], (uint32_t)b)) {
+            i++;
+            high = 0;
+        }
+
+        if (high) {
+            offset = 0;
+        } else if (i < n && (int32_t)(edge[i] - edge[0]) < b + p - ST_TOLERANCE) {
+            int32_t rise = (int32_t)(edge[i] - edge[0]) - b;
+            offset = (rise > 0) ? (uint32_t)rise : 0;
+            i++;
+            high = 1;
+        } else {
+            offset = period;
+        }
+
+        /* Any further edge inside the period is a runt */
+        uint8_t runt = 0;
+        while (i < n && (int32_t)(edge[i] - edge[0]) < b + p - ST_TOLERANCE) {
+            i++;
+            high = !high;
+            runt = 1;
+        }
+
+        if (!runt && st_near(offset, expect[s])) {
+            continue;
+        }
+        if (!runt && s + 1 < steps &&
+            (st_near(offset, expect[s + 1]) ||
+             (expect[s + 1] == 0 && st_near(offset, entry)))) {
+            s++;
+            continue;
+        }
+
+        if (bad++ == 0) {
+            st_bad_period = k;
+            st_bad_offset = offset;
+        }
+    }
+
+    /* Every step seen, every edge explained */
+    if (s != steps - 1 || i != n) {
+        if (bad++ == 0) {
+            st_bad_period = k;
+            st_bad_offset = 0;
+        }
+    }
+    return bad;
+}
+
+void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= UART_CLK | IOCON_CLK;
+    UARTCLKDIV = 1;
+    IOCON_REG(IOCON_PIO1_6) = 0x01;
+    IOCON_REG(IOCON_PIO1_7) = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+void print_number(uint32_t n) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/**
+ * Run the glitch test on ST_CHANNEL.
+ *
+ * CT16B0 runs the channel on its own, committing from its own MR3
+ * interrupt. CT32B1 is borrowed as a free-running 72 MHz capture timer
+ * that timestamps both edges of the looped-back output. Each step of the
+ * sequence is committed 'ST_HOLD periods + a pseudo-random fraction'
+ * after the previous one, so over the rounds the commits land all over
+ * the period, including inside the guard band and right at its end.
+ *
+ * Everything is put back afterwards; the demo re-initialises all timers.
+ */
+void pwm_selftest(void) {
+    uint32_t expect[ST_STEPS];
+    uint32_t lcg = 12345;
+    uint32_t total_bad = 0;
+
+    uart_init(115200);
+    uart_puts("\r\nMulti-Channel PWM glitch test (P0.8 -> P1.0)\r\n");
+
+    pwm_timer_init(ST_TIMER, PWM_FREQUENCY);
+    pwm_enable_channel(ST_CHANNEL);
+
+    uint32_t prescale = TMR_PR(pwm_timers[ST_TIMER].base) + 1;
+    uint32_t period = pwm_period[ST_TIMER] * prescale;      /* Cycles */
+    uint32_t entry = pwm_guard[ST_TIMER] * prescale;
+
+    for (uint32_t s = 0; s < ST_STEPS; s++) {
+        expect[s] = pwm_duty_to_match(ST_TIMER, st_steps[s]) * prescale;
+    }
+
+    /* Capture timer: CT32B1 free-running, CAP0 on P1.0, both edges */
+    SYSAHBCLKCTRL |= CT32B1_CLK | IOCON_CLK;
+    IOCON_REG(IOCON_R_PIO1_0) = 0x03 | IOCON_ADMODE;
+    TMR_TCR(CT32B1_BASE) = 0x02;
+    TMR_PR(CT32B1_BASE) = 0;
+    TMR_MCR(CT32B1_BASE) = 0;
+    TMR_PWMC(CT32B1_BASE) = 0;
+    TMR_CCR(CT32B1_BASE) = CCR_CAP0_BOTH;
+    TMR_IR(CT32B1_BASE) = 0x1F;
+
+    NVIC_IPR(CT32B1_IRQn) = 0x00;      /* Capture preempts the commit */
+    NVIC_IPR(ST_CT16B0_IRQn) = 0x20;
+    NVIC_ISER1 = (1 << (CT32B1_IRQn - 32));
+
+    TMR_TCR(CT32B1_BASE) = 0x01;
+    pwm_start(1 << ST_TIMER);
+
+    for (uint32_t round = 0; round < ST_ROUNDS; round++) {
+        /* Output is at 0%: the first edge will be a rising one */
+        uint32_t t = TMR_TC(CT32B1_BASE);
+
+        st_count = 0;
+        st_armed = 1;
+
+        for (uint32_t s = 1; s < ST_STEPS; s++) {
+            lcg = lcg * 1103515245 + 12345;
+            t += ST_HOLD * period + (lcg >> 8) % period;
+            while ((int32_t)(TMR_TC(CT32B1_BASE) - t) < 0);
+            pwm_set_duty(ST_CHANNEL, st_steps[s]);
+        }
+
+        /* Let the final 0% take effect and hold */
+        t += (ST_HOLD + 1) * period;
+        while ((int32_t)(TMR_TC(CT32B1_BASE) - t) < 0);
+        st_armed = 0;
+
+        uart_puts("  round ");
+        print_number(round + 1);
+        uart_puts(": ");
+        print_number(st_count);
+        uart_puts(" edges, ");
+
+        if (st_count < 2) {
+            uart_puts("no pulses seen - is P0.8 wired to P1.0?\r\n");
+            total_bad = 1;
+            break;
+        }
+
+        uint32_t bad = (st_count >= ST_MAX_EDGES) ? 1 :
+                       st_check(st_edges, st_count, t, expect, ST_STEPS,
+                                period, entry);
+        if (bad == 0) {
+            uart_puts("OK\r\n");
+        } else {
+            uart_puts("GLITCH: ");
+            print_number(bad);
+            uart_puts(" bad periods, first #");
+            print_number(st_bad_period);
+            uart_puts(" rise at ");
+            print_number(st_bad_offset);
+            uart_puts(" cycles\r\n");
+        }
+        total_bad += bad;
+    }
+
+    uart_puts(total_bad ? "Glitch test: FAIL\r\n" : "Glitch test: PASS\r\n");
+    while (!(U0LSR & LSR_TEMT));        /* Demo takes P1.6/P1.7 next */
+
+    /* Put the borrowed capture timer back */
+    TMR_TCR(CT32B1_BASE) = 0x02;
+    TMR_CCR(CT32B1_BASE) = 0;
+    TMR_IR(CT32B1_BASE) = 0x1F;
+    IOCON_REG(IOCON_R_PIO1_0) = 0xD0;   /* Reset value */
+    NVIC_IPR(ST_CT16B0_IRQn) = 0x00;
+}
+
+#endif
+
+/*******************************************************************************
+ * Demo
+ ******************************************************************************/
+
+volatile uint32_t ms_ticks = 0;
+
+void SysTick_Handler(void) {
+    ms_ticks++;
+}
+
+/* Channels used by the demo, in physical LED order */
+static const pwm_channel_t demo_channels[] = {
+    PWM_16B0_MAT0, PWM_16B0_MAT1, PWM_16B1_MAT0, PWM_16B1_MAT1,
+    PWM_32B0_MAT0, PWM_32B0_MAT1, PWM_32B1_MAT0, PWM_32B1_MAT1,
+};
+#define NUM_DEMO_CHANNELS (sizeof(demo_channels) / sizeof(demo_channels[0]))
+
+/**
+ * Triangle wave 0..PWM_DUTY_FULL over 256 steps, squared for a rough
+ * perceptual (gamma 2) correction.
+ */
+static uint16_t wave(uint8_t phase) {
+    uint32_t tri = (phase < 128) ? phase * 2 : (255 - phase) * 2;  /* 0..254 */
+    return (uint16_t)((tri * tri * PWM_DUTY_FULL) / (254 * 254));
+}
+
+int main(void) {
+    uint16_t duty[PWM_NUM_CHANNELS] = { 0 };
+    uint32_t mask = 0;
+    uint8_t phase = 0;
+    uint32_t last = 0;
+
+#if PWM_SELFTEST
+    pwm_selftest();
+#endif
+
+    pwm_init_shared(PWM_FREQUENCY);
+
+    for (uint32_t i = 0; i < NUM_DEMO_CHANNELS; i++) {
+        if (pwm_enable_channel(demo_channels[i])) {
+            mask |= (1 << demo_channels[i]);
+        }
+    }
+
+    /* 1 ms SysTick for animation timing */
+    SYST_RVR = (SYSTEM_CLOCK / 1000) - 1;
+    SYST_CVR = 0;
+    SYST_CSR = 0x07;
+
+    while (1) {
+        if ((ms_ticks - last) >= 10) {
+            last += 10;
+            phase += 2;
+
+            /* Each LED is 1/8 of a cycle behind the previous one */
+            for (uint32_t i = 0; i < NUM_DEMO_CHANNELS; i++) {
+                duty[demo_channels[i]] = wave(phase - i * 32);
+            }
+
+            pwm_write_batch(duty, mask);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,546 @@
+/**
+ * Chapter 4: Timers and PWM - Multi-Servo Example
+ *
+ * Drives up to 12 hobby servos from one 32-bit timer (CT32B1).
+ * Servo-Control uses a PWM match output, so one timer gives at most three
+ * servos. Here the servo signals are ordinary GPIO pins on port 2 and the
+ * timer only schedules edges:
+ *
+ *   - MR3 ends each 20 ms frame: all servo pins go HIGH in one store
+ *   - MR0 is moved from edge to edge: at each falling edge the pins whose
+ *     pulse ends at that time go LOW in one store
+ *
+ * The falling edges are sorted once per frame, so a frame costs one
+ * interrupt per distinct pulse width plus one for the frame start.
+ *
+ * Motion profiles are also evaluated once per frame, right after the
+ * last pulse has ended. A group of servos can be given new targets with a
+ * common duration and they all start and arrive together - trapezoidal
+ * or S-curve - without any work in the main loop.
+ *
+ * Concepts demonstrated:
+ *   - Masked GPIO access: address bits select which pins a store changes
+ *   - Scheduling many edges with one match register
+ *   - Sorting a small list once per frame (insertion sort)
+ *   - Fixed-point motion profiles (Q16 progress)
+ *   - Trapezoidal and S-curve (smootherstep) velocity shapes
+ *
+ * Hardware:
+ *   - P2.0-P2.11: servo signal wires (servo 0 - servo 11)
+ *   - P3.0-P3.3: Status LEDs (current demo pose)
+ *   Power the servos from a separate 5 V supply; connect its GND to the
+ *   board GND.
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+
+/* IOCON - port 2 (servos) */
+#define IOCON_PIO2_0   0x40044008
+#define IOCON_PIO2_1   0x40044028
+#define IOCON_PIO2_2   0x4004405C
+#define IOCON_PIO2_3   0x4004408C
+#define IOCON_PIO2_4   0x40044040
+#define IOCON_PIO2_5   0x40044044
+#define IOCON_PIO2_6   0x40044000
+#define IOCON_PIO2_7   0x40044020
+#define IOCON_PIO2_8   0x40044024
+#define IOCON_PIO2_9   0x40044054
+#define IOCON_PIO2_10  0x40044058
+#define IOCON_PIO2_11  0x40044070
+
+#define IOCON_REG(addr)  (*((volatile uint32_t *)(addr)))
+
+/* IOCON - port 3 (status LEDs) */
+#define IOCON_PIO3_0   (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1   (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2   (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3   (*((volatile uint32_t *)0x400440AC))
+
+/* GPIO Port 2 (servos) */
+#define GPIO2_BASE     0x50020000
+#define GPIO2DIR       (*((volatile uint32_t *)0x50028000))
+#define GPIO2DATA      (*((volatile uint32_t *)0x50023FFC))
+
+/* Masked data access: address bits 13:2 select the pins a store affects,
+ * so writing one address changes exactly those pins - no read needed */
+#define GPIO2_MASKED(mask) (*((volatile uint32_t *)(GPIO2_BASE + ((mask) << 2))))
+
+/* GPIO Port 3 (status LEDs) */
+#define GPIO3DIR       (*((volatile uint32_t *)0x50038000))
+#define GPIO3DATA      (*((volatile uint32_t *)0x50033FFC))
+
+/* CT32B1 Timer Registers (servo scheduler) */
+#define TMR32B1IR      (*((volatile uint32_t *)0x40018000))
+#define TMR32B1TCR     (*((volatile uint32_t *)0x40018004))
+#define TMR32B1TC      (*((volatile uint32_t *)0x40018008))
+#define TMR32B1PR      (*((volatile uint32_t *)0x4001800C))
+#define TMR32B1MCR     (*((volatile uint32_t *)0x40018014))
+#define TMR32B1MR0     (*((volatile uint32_t *)0x40018018))
+#define TMR32B1MR3     (*((volatile uint32_t *)0x40018024))
+
+/* NVIC */
+#define NVIC_ISER1     (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define LED_MASK       0x0F
+
+#define SYSTEM_CLOCK   72000000UL
+
+/* Clock enable bits */
+#define GPIO_CLK       (1 << 6)
+#define CT32B1_CLK     (1 << 10)
+#define IOCON_CLK      (1 << 16)
+
+/* CT32B1 IRQ number */
+#define CT32B1_IRQn    44
+
+/* MCR bits */
+#define MCR_MR0I       (1 << 0)
+#define MCR_MR3I       (1 << 9)
+#define MCR_MR3R       (1 << 10)
+
+/* IR bits */
+#define IR_MR0         (1 << 0)
+#define IR_MR3         (1 << 3)
+
+/* Timer runs at the CPU clock (PR = 0): 72 ticks per microsecond */
+#define TICKS_PER_US   (SYSTEM_CLOCK / 1000000)
+
+/* Servo timing constants (in microseconds) */
+#define SERVO_PERIOD_US    20000   /* 50Hz = 20ms frame */
+#define SERVO_MIN_PULSE_US 1000    /* 1ms = 0 degrees */
+#define SERVO_MAX_PULSE_US 2000    /* 2ms = 180 degrees */
+#define SERVO_CENTER_US    1500    /* 1.5ms = 90 degrees */
+
+#define SERVO_MAX      12          /* P2.0 - P2.11 */
+#define FRAME_MS       (SERVO_PERIOD_US / 1000)
+
+/* An edge closer than this to TC is too close to schedule with MR0 (the
+ * interrupt would arrive late); it is waited for inside the handler. */
+#define EDGE_MIN_LEAD  ((int32_t)(2 * TICKS_PER_US))
+
+/* MR0 value that is never reached (beyond MR3) */
+#define MR_NEVER       0xFFFFFFFF
+
+/*******************************************************************************
+ * Servo Types
+ ******************************************************************************/
+
+typedef enum {
+    PROFILE_TRAPEZOID,     /* Constant accel, cruise, constant decel */
+    PROFILE_SCURVE         /* Smootherstep: accel also starts and ends at 0 */
+} servo_profile_t;
+
+typedef struct {
+    int32_t  pos;          /* Current pulse width in timer ticks */
+    int32_t  start;        /* Pulse width at the start of the move */
+    int32_t  target;
+    uint32_t frame;        /* Frames into the move */
+    uint32_t frames;       /* Length of the move, 0 = idle */
+    uint8_t  profile;
+} servo_t;
+
+/* One falling edge: the time it happens and the pins that go LOW */
+typedef struct {
+    uint32_t time;
+    uint32_t mask;
+} servo_edge_t;
+
+typedef struct {
+    servo_edge_t edges[SERVO_MAX];
+    uint32_t count;
+    uint32_t all;          /* Pins raised at frame start */
+} servo_frame_t;
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+
+static const uint32_t servo_iocon[SERVO_MAX] = {
+    IOCON_PIO2_0, IOCON_PIO2_1, IOCON_PIO2_2,  IOCON_PIO2_3,
+    IOCON_PIO2_4, IOCON_PIO2_5, IOCON_PIO2_6,  IOCON_PIO2_7,
+    IOCON_PIO2_8, IOCON_PIO2_9, IOCON_PIO2_10, IOCON_PIO2_11,
+};
+
+servo_t servos[SERVO_MAX];
+volatile uint32_t servo_attached = 0;      /* Bit n = servo n on P2.n */
+volatile uint32_t servo_moving = 0;        /* Bit n = servo n has a move */
+
+/* Frame being output and frame being prepared */
+static servo_frame_t frames[2];
+static servo_frame_t *frame_active = &frames[0];
+static servo_frame_t *frame_next = &frames[1];
+static volatile uint8_t frame_ready = 0;
+static uint32_t edge_index = 0;
+
+volatile uint32_t frame_count = 0;
+
+/*******************************************************************************
+ * Interrupt Helpers
+ ******************************************************************************/
+
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/*******************************************************************************
+ * Motion Profiles
+ *
+ * Map progress u (Q16, 0 .. 0x10000) to the fraction of the distance
+ * covered s (Q16). Both start at 0 and end at 0x10000.
+ ******************************************************************************/
+
+/**
+ * Trapezoid with 1/4 of the time accelerating, 1/2 cruising at 4/3 of
+ * the average speed and 1/4 decelerating:
+ *   u < 1/4:    s = 8/3 u^2
+ *   u <= 3/4:   s = 4/3 (u - 1/8)
+ *   u > 3/4:    s = 1 - 8/3 (1 - u)^2
+ */
+static uint32_t profile_trapezoid(uint32_t u) {
+    if (u < 0x4000) {
+        return (uint32_t)((8ULL * u * u / 3) >> 16);
+    }
+    if (u <= 0xC000) {
+        return (4 * (u - 0x2000)) / 3;
+    }
+    uint32_t v = 0x10000 - u;
+    return 0x10000 - (uint32_t)((8ULL * v * v / 3) >> 16);
+}
+
+/**
+ * Smootherstep: s = 6u^5 - 15u^4 + 10u^3 = u^3 (u (6u - 15) + 10).
+ * Velocity and acceleration are both zero at the ends, so there is no
+ * jerk when a move starts or stops.
+ */
+static uint32_t profile_scurve(uint32_t u) {
+    int64_t x = u;
+    int64_t t = 6 * x - 15 * 0x10000;
+
+    t = ((x * t) >> 16) + 10 * 0x10000;
+    t = (t * x) >> 16;
+    t = (t * x) >> 16;
+    t = (t * x) >> 16;
+    return (uint32_t)t;
+}
+
+/*******************************************************************************
+ * Frame Preparation
+ ******************************************************************************/
+
+/**
+ * Advance one servo's move by one frame
+ */
+static void servo_update(uint32_t n) {
+    servo_t *s = &servos[n];
+
+    if (s->frames == 0) return;
+
+    s->frame++;
+    if (s->frame >= s->frames) {
+        s->pos = s->target;
+        s->frames = 0;
+        servo_moving &= ~(1u << n);
+        return;
+    }
+
+    uint32_t u = (s->frame << 16) / s->frames;
+    uint32_t f = (s->profile == PROFILE_SCURVE) ? profile_scurve(u)
+                                                : profile_trapezoid(u);
+
+    s->pos = s->start
+           + (int32_t)(((int64_t)(s->target - s->start) * f) >> 16);
+}
+
+/**
+ * Update all motion and build the next frame's sorted edge list.
+ * Runs in the timer interrupt right after the last pulse of a frame ends,
+ * so it has the remaining ~17 ms of the frame to finish.
+ */
+static void servo_prepare_frame(void) {
+    servo_frame_t *f = frame_next;
+    uint32_t attached = servo_attached;
+
+    f->count = 0;
+    f->all = attached;
+
+    for (uint32_t n = 0; n < SERVO_MAX; n++) {
+        if (!(attached & (1u << n))) continue;
+
+        servo_update(n);
+
+        uint32_t time = (uint32_t)servos[n].pos;
+        uint32_t i = f->count;
+
+        /* Insertion sort; servos ending at the same tick share an edge */
+        while (i > 0 && f->edges[i - 1].time > time) i--;
+
+        if (i > 0 && f->edges[i - 1].time == time) {
+            f->edges[i - 1].mask |= (1u << n);
+            continue;
+        }
+        for (uint32_t j = f->count; j > i; j--) f->edges[j] = f->edges[j - 1];
+        f->edges[i].time = time;
+        f->edges[i].mask = (1u << n);
+        f->count++;
+    }
+
+    frame_ready = 1;
+}
+
+/*******************************************************************************
+ * Interrupt Handler
+ ******************************************************************************/
+
+/**
+ * Output falling edges until the next one is far enough away to be
+ * scheduled on MR0. After the last edge, prepare the next frame.
+ */
+static void servo_run_edges(void) {
+    servo_frame_t *f = frame_active;
+
+    while (edge_index < f->count) {
+        servo_edge_t *e = &f->edges[edge_index];
+
+        if ((int32_t)(e->time - TMR32B1TC) > EDGE_MIN_LEAD) {
+            TMR32B1MR0 = e->time;
+            return;
+        }
+
+        while ((int32_t)(e->time - TMR32B1TC) > 0);
+        GPIO2_MASKED(e->mask) = 0;
+        edge_index++;
+    }
+
+    TMR32B1MR0 = MR_NEVER;
+    servo_prepare_frame();
+}
+
+void CT32B1_IRQHandler(void) {
+    uint32_t ir = TMR32B1IR;
+
+    if (ir & IR_MR3) {
+        /* Frame start: TC has just reset to 0 */
+        TMR32B1IR = IR_MR3;
+
+        if (frame_ready) {
+            servo_frame_t *t = frame_active;
+            frame_active = frame_next;
+            frame_next = t;
+            frame_ready = 0;
+        }
+
+        GPIO2_MASKED(frame_active->all) = frame_active->all;
+        edge_index = 0;
+        frame_count++;
+        servo_run_edges();
+    } else if (ir & IR_MR0) {
+        TMR32B1IR = IR_MR0;
+        servo_run_edges();
+    }
+}
+
+/*******************************************************************************
+ * Servo API
+ ******************************************************************************/
+
+static int32_t us_to_ticks(uint32_t us) {
+    if (us < SERVO_MIN_PULSE_US) us = SERVO_MIN_PULSE_US;
+    if (us > SERVO_MAX_PULSE_US) us = SERVO_MAX_PULSE_US;
+    return (int32_t)(us * TICKS_PER_US);
+}
+
+uint32_t angle_to_us(uint16_t angle) {
+    if (angle > 180) angle = 180;
+    return SERVO_MIN_PULSE_US +
+           ((uint32_t)angle * (SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US)) / 180;
+}
+
+/**
+ * Start the frame timer. Servos are added with servo_attach().
+ */
+void servo_init(void) {
+    SYSAHBCLKCTRL |= CT32B1_CLK | GPIO_CLK | IOCON_CLK;
+
+    TMR32B1TCR = 0x02;
+    TMR32B1PR = 0;
+    TMR32B1MR3 = SERVO_PERIOD_US * TICKS_PER_US - 1;
+    TMR32B1MR0 = MR_NEVER;
+    TMR32B1MCR = MCR_MR0I | MCR_MR3I | MCR_MR3R;
+    TMR32B1IR = 0x1F;
+
+    servo_prepare_frame();
+    NVIC_ISER1 = (1 << (CT32B1_IRQn - 32));
+    TMR32B1TCR = 0x01;
+}
+
+/**
+ * Configure P2.n as an output and start pulsing it at pulse_us from the
+ * next frame
+ */
+void servo_attach(uint32_t n, uint32_t pulse_us) {
+    if (n >= SERVO_MAX) return;
+
+    IOCON_REG(servo_iocon[n]) = 0x00;   /* GPIO, no pull resistor */
+    GPIO2_MASKED(1u << n) = 0;
+    GPIO2DIR |= (1u << n);
+
+    uint32_t primask = irq_save();
+    servos[n].pos = us_to_ticks(pulse_us);
+    servos[n].frames = 0;
+    servo_moving &= ~(1u << n);
+    servo_attached |= (1u << n);
+    irq_restore(primask);
+}
+
+/**
+ * Move one servo to pulse_us over time_ms using a motion profile
+ */
+void servo_move(uint32_t n, uint32_t pulse_us, uint32_t time_ms,
+                servo_profile_t profile) {
+    uint32_t nframes = time_ms / FRAME_MS;
+    uint32_t primask = irq_save();
+    servo_t *s = &servos[n];
+
+    s->start = s->pos;
+    s->target = us_to_ticks(pulse_us);
+    s->frame = 0;
+    s->frames = nframes ? nframes : 1;
+    s->profile = profile;
+    servo_moving |= (1u << n);
+
+    irq_restore(primask);
+}
+
+/**
+ * Coordinated move: every servo in mask goes to its entry in pulse_us[]
+ * over the same time. All start in the same frame and arrive together.
+ */
+void servo_move_group(uint32_t mask, const uint16_t pulse_us[SERVO_MAX],
+                      uint32_t time_ms, servo_profile_t profile) {
+    uint32_t primask = irq_save();
+
+    for (uint32_t n = 0; n < SERVO_MAX; n++) {
+        if (mask & (1u << n)) servo_move(n, pulse_us[n], time_ms, profile);
+    }
+
+    irq_restore(primask);
+}
+
+/**
+ * Returns 1 while any servo in mask is still moving
+ */
+uint8_t servo_busy(uint32_t mask) {
+    return (servo_moving & mask) != 0;
+}
+
+/*******************************************************************************
+ * LED Functions
+ ******************************************************************************/
+
+void leds_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO3DIR |= LED_MASK;
+    GPIO3DATA |= LED_MASK;
+}
+
+void set_leds(uint8_t pattern) {
+    uint32_t current = GPIO3DATA;
+    current |= LED_MASK;
+    current &= ~(pattern & LED_MASK);
+    GPIO3DATA = current;
+}
+
+/*******************************************************************************
+ * Main Function
+ ******************************************************************************/
+
+#define DEMO_SERVOS    SERVO_MAX
+#define DEMO_MASK      ((1u << DEMO_SERVOS) - 1)
+
+/**
+ * Wait until the move is done, then hold for a number of frames
+ */
+static void wait_moves(uint32_t hold_frames) {
+    while (servo_busy(DEMO_MASK)) __asm volatile ("wfi");
+
+    uint32_t start = frame_count;
+    while ((frame_count - start) < hold_frames) __asm volatile ("wfi");
+}
+
+int main(void) {
+    uint16_t pose[SERVO_MAX];
+    uint8_t step = 0;
+
+    leds_init();
+    servo_init();
+
+    for (uint32_t n = 0; n < DEMO_SERVOS; n++) {
+        servo_attach(n, SERVO_CENTER_US);
+    }
+
+    while (1) {
+        set_leds(1 << (step & 3));
+
+        switch (step & 3) {
+            case 0:
+                /* Fan out: servo n to n * 180 / 11 degrees */
+                for (uint32_t n = 0; n < DEMO_SERVOS; n++) {
+                    pose[n] = angle_to_us(n * 180 / (DEMO_SERVOS - 1));
+                }
+                servo_move_group(DEMO_MASK, pose, 1500, PROFILE_SCURVE);
+                break;
+            case 1:
+                /* Mirror image of the fan */
+                for (uint32_t n = 0; n < DEMO_SERVOS; n++) {
+                    pose[n] = angle_to_us(180 - n * 180 / (DEMO_SERVOS - 1));
+                }
+                servo_move_group(DEMO_MASK, pose, 2000, PROFILE_TRAPEZOID);
+                break;
+            case 2:
+                /* Alternate 0 / 180 degrees */
+                for (uint32_t n = 0; n < DEMO_SERVOS; n++) {
+                    pose[n] = angle_to_us((n & 1) ? 180 : 0);
+                }
+                servo_move_group(DEMO_MASK, pose, 1000, PROFILE_SCURVE);
+                break;
+            default:
+                /* All back to the centre */
+                for (uint32_t n = 0; n < DEMO_SERVOS; n++) {
+                    pose[n] = SERVO_CENTER_US;
+                }
+                servo_move_group(DEMO_MASK, pose, 1000, PROFILE_TRAPEZOID);
+                break;
+        }
+
+        wait_moves(25);             /* Hold 0.5 s */
+        step++;
+    }
+
+    return 0;
+}
@@ -0,0 +1,328 @@
+/**
+ * Chapter 4: Timers and PWM - Multiplexed Display Example
+ *
+ * A display engine for multiplexed LEDs: four 7-segment digits (or a 4x8
+ * LED matrix) on twelve port 2 pins, refreshed entirely from a timer
+ * interrupt. The application only writes segment patterns and per-digit
+ * brightness into a framebuffer and swaps it in.
+ *
+ * Binary-Counter and Running-Light write their LED patterns from the main
+ * loop between busy-wait delays. That cannot drive a multiplexed display:
+ * only one digit is lit at a time, so the digits must be scanned hundreds
+ * of times per second, and every delay or slow calculation in the main
+ * loop would show as flicker. Here CT16B0 scans the display on its own.
+ *
+ * Brightness uses bit-angle modulation (BAM). Each digit's time slot is
+ * split into 4 sub-slots of 1, 2, 4 and 8 units; the digit is lit during
+ * sub-slot n only if bit n of its 4-bit level is set. Level 5 (0101) is
+ * lit for 1 + 4 = 5 of 15 units. Unlike PWM with a fixed tick, this needs
+ * only 4 interrupts per digit for 16 levels instead of 15.
+ *
+ * The framebuffer is double-buffered: display_swap() asks the interrupt
+ * to switch buffers at the start of the next frame, so a half-written
+ * frame is never shown.
+ *
+ * Concepts demonstrated:
+ *   - Row (digit) multiplexing from a timer interrupt
+ *   - Bit-angle modulation with a variable match period
+ *   - Double-buffered framebuffer, swapped at a frame boundary
+ *   - Driving segments and digit select with one masked GPIO store
+ *   - 7-segment font table
+ *
+ * Hardware:
+ *   - P2.0-P2.7:  Segments a-g, dp (220 ohm resistor to each anode)
+ *   - P2.8-P2.11: Digit 0-3 select (NPN transistor to each common
+ *                 cathode, 1k base resistor)
+ *   - Common-anode displays with PNP transistors: set DISPLAY_INVERT
+ *   - An 8x4 LED matrix works the same way: columns on P2.0-P2.7,
+ *     rows on P2.8-P2.11
+ *
+ * Note: This example assumes 72 MHz system clock (PLL configured)
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+
+/* IOCON - port 2 (segments and digit select) */
+#define IOCON_PIO2_0   0x40044008
+#define IOCON_PIO2_1   0x40044028
+#define IOCON_PIO2_2   0x4004405C
+#define IOCON_PIO2_3   0x4004408C
+#define IOCON_PIO2_4   0x40044040
+#define IOCON_PIO2_5   0x40044044
+#define IOCON_PIO2_6   0x40044000
+#define IOCON_PIO2_7   0x40044020
+#define IOCON_PIO2_8   0x40044024
+#define IOCON_PIO2_9   0x40044054
+#define IOCON_PIO2_10  0x40044058
+#define IOCON_PIO2_11  0x40044070
+
+#define IOCON_REG(addr)  (*((volatile uint32_t *)(addr)))
+
+/* GPIO Port 2 */
+#define GPIO2_BASE     0x50020000
+#define GPIO2DIR       (*((volatile uint32_t *)0x50028000))
+
+/* Masked DATA access: only the pins in mask are read or written */
+#define GPIO2_MASKED(mask) (*((volatile uint32_t *)(GPIO2_BASE + ((mask) << 2))))
+
+/* 16-bit Timer 0 (CT16B0) */
+#define TMR16B0IR      (*((volatile uint32_t *)0x4000C000))
+#define TMR16B0TCR     (*((volatile uint32_t *)0x4000C004))
+#define TMR16B0TC      (*((volatile uint32_t *)0x4000C008))
+#define TMR16B0PR      (*((volatile uint32_t *)0x4000C00C))
+#define TMR16B0MCR     (*((volatile uint32_t *)0x4000C014))
+#define TMR16B0MR0     (*((volatile uint32_t *)0x4000C018))
+
+/* NVIC */
+#define NVIC_ISER1     (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define SYSTEM_CLOCK   72000000UL
+
+/* Clock enable bits */
+#define GPIO_CLK       (1 << 6)
+#define CT16B0_CLK     (1 << 7)
+#define IOCON_CLK      (1 << 16)
+
+/* CT16B0 IRQ number */
+#define CT16B0_IRQn    41
+
+/* MCR bits: interrupt and reset on MR0 */
+#define MCR_MR0I       (1 << 0)
+#define MCR_MR0R       (1 << 1)
+
+/* IR bit: MR0 match flag */
+#define IR_MR0         (1 << 0)
+
+/* Display geometry: 4 rows (digits) of 8 columns (segments) */
+#define DISPLAY_ROWS   4
+#define SEG_MASK       0x0FF     /* P2.0-P2.7 */
+#define DIGIT_SHIFT    8         /* P2.8-P2.11 */
+#define DISPLAY_MASK   0xFFF
+
+/* Pins driven low for "on": 0 for the wiring above, DISPLAY_MASK for
+ * common-anode digits with PNP transistors */
+#define DISPLAY_INVERT 0x000
+
+/* Bit-angle modulation: 4 bits = 16 brightness levels.
+ * Sub-slot n lasts BAM_UNIT_US << n; one digit takes 15 units.
+ * Frame = 4 digits * 15 * 64 us = 3.84 ms (260 Hz, no flicker) */
+#define BAM_BITS       4
+#define BAM_UNIT_US    64
+#define DISPLAY_LEVEL_MAX ((1 << BAM_BITS) - 1)
+#define DISPLAY_FRAME_US  (DISPLAY_ROWS * DISPLAY_LEVEL_MAX * BAM_UNIT_US)
+
+/* Segment bits */
+#define SEG_A          (1 << 0)
+#define SEG_B          (1 << 1)
+#define SEG_C          (1 << 2)
+#define SEG_D          (1 << 3)
+#define SEG_E          (1 << 4)
+#define SEG_F          (1 << 5)
+#define SEG_G          (1 << 6)
+#define SEG_DP         (1 << 7)
+
+/*******************************************************************************
+ * 7-Segment Font
+ *
+ *      a
+ *    f   b
+ *      g
+ *    e   c
+ *      d   dp
+ ******************************************************************************/
+
+static const uint8_t seg7_font[16] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07,   /* 0-7 */
+    0x7F, 0x6F, 0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71    /* 8-9, A-F */
+};
+
+/*******************************************************************************
+ * Display Engine
+ ******************************************************************************/
+
+typedef struct {
+    uint8_t seg[DISPLAY_ROWS];     /* Lit segments / columns per row */
+    uint8_t level[DISPLAY_ROWS];   /* Brightness 0-15 per row */
+} display_frame_t;
+
+static display_frame_t display_frames[2];
+static volatile uint8_t display_front = 0;     /* Buffer being shown */
+static volatile uint8_t display_swap_pending = 0;
+
+/* Scan position */
+static uint8_t scan_row = DISPLAY_ROWS - 1;
+static uint8_t scan_bit = BAM_BITS - 1;
+
+volatile uint32_t display_frame_count = 0;
+
+/**
+ * CT16B0 MR0 interrupt: start the next BAM sub-slot.
+ *
+ * TC has just been reset by the match. The new MR0 is written within a
+ * few microseconds, long before TC can reach it, so it sets the length
+ * of the sub-slot that starts now.
+ */
+void CT16B0_IRQHandler(void) {
+    TMR16B0IR = IR_MR0;
+
+    if (++scan_bit == BAM_BITS) {
+        scan_bit = 0;
+
+        if (++scan_row == DISPLAY_ROWS) {
+            scan_row = 0;
+
+            /* Frame boundary: the only place buffers change */
+            if (display_swap_pending) {
+                display_front ^= 1;
+                display_swap_pending = 0;
+            }
+            display_frame_count++;
+        }
+    }
+
+    const display_frame_t *f = &display_frames[display_front];
+    uint32_t out = 0;                            /* Digit dark */
+
+    if (f->level[scan_row] & (1 << scan_bit)) {
+        out = f->seg[scan_row] | (1 << (DIGIT_SHIFT + scan_row));
+    }
+
+    /* Segments and digit select change in the same store */
+    GPIO2_MASKED(DISPLAY_MASK) = out ^ DISPLAY_INVERT;
+
+    TMR16B0MR0 = (BAM_UNIT_US << scan_bit) - 1;
+}
+
+void display_init(void) {
+    static const uint32_t pins[12] = {
+        IOCON_PIO2_0, IOCON_PIO2_1, IOCON_PIO2_2,  IOCON_PIO2_3,
+        IOCON_PIO2_4, IOCON_PIO2_5, IOCON_PIO2_6,  IOCON_PIO2_7,
+        IOCON_PIO2_8, IOCON_PIO2_9, IOCON_PIO2_10, IOCON_PIO2_11
+    };
+
+    SYSAHBCLKCTRL |= GPIO_CLK | CT16B0_CLK | IOCON_CLK;
+
+    for (uint8_t i = 0; i < 12; i++) {
+        IOCON_REG(pins[i]) = 0x00;               /* GPIO, no pull resistor */
+    }
+
+    GPIO2_MASKED(DISPLAY_MASK) = DISPLAY_INVERT; /* All dark */
+    GPIO2DIR |= DISPLAY_MASK;
+
+    /* 1 MHz timer tick, MR0 interrupts and restarts each sub-slot */
+    TMR16B0TCR = 0x02;                           /* Reset */
+    TMR16B0PR = SYSTEM_CLOCK / 1000000 - 1;
+    TMR16B0MR0 = BAM_UNIT_US - 1;
+    TMR16B0MCR = MCR_MR0I | MCR_MR0R;
+
+    NVIC_ISER1 = (1 << (CT16B0_IRQn - 32));
+
+    TMR16B0TCR = 0x01;                           /* Start */
+}
+
+/**
+ * The buffer to draw the next frame into
+ */
+display_frame_t *display_back(void) {
+    return &display_frames[display_front ^ 1];
+}
+
+/**
+ * Show the back buffer from the next frame on. Waits for the switch (at
+ * most one frame, 3.84 ms), then copies the new front buffer into the
+ * back buffer so the application can keep updating it piece by piece.
+ */
+void display_swap(void) {
+    /* Back buffer writes must land before the interrupt can swap */
+    __asm volatile ("" ::: "memory");
+    display_swap_pending = 1;
+
+    while (display_swap_pending) {
+        __asm volatile ("wfi");
+    }
+
+    display_frames[display_front ^ 1] = display_frames[display_front];
+}
+
+/*******************************************************************************
+ * 7-Segment Helpers
+ ******************************************************************************/
+
+void display_put_digit(display_frame_t *f, uint8_t row, uint8_t value, uint8_t dp) {
+    f->seg[row] = seg7_font[value & 0x0F] | (dp ? SEG_DP : 0);
+}
+
+/**
+ * Show value (0-9999) right-aligned with leading zeros blanked. Digits
+ * up to min_digits from the right are always shown.
+ */
+void display_put_number(display_frame_t *f, uint16_t value, uint8_t min_digits) {
+    for (int8_t row = DISPLAY_ROWS - 1; row >= 0; row--) {
+        uint8_t pos = DISPLAY_ROWS - 1 - row;   /* 0 = rightmost */
+
+        if (value == 0 && pos >= min_digits) {
+            f->seg[row] = 0;
+        } else {
+            display_put_digit(f, row, value % 10, 0);
+        }
+        value /= 10;
+    }
+}
+
+/*******************************************************************************
+ * Main Program
+ ******************************************************************************/
+
+/* Triangle wave 0..15..0 over 32 steps */
+static uint8_t triangle(uint8_t phase) {
+    phase &= 31;
+    return (phase < 16) ? phase : 31 - phase;
+}
+
+int main(void) {
+    uint16_t tenths = 0;
+    uint32_t elapsed_us = 0;
+    uint8_t wave = 0;
+
+    display_init();
+
+    /* Stopwatch "999.9" with a brightness wave rolling across the digits.
+     * display_swap() returns once per frame, so it also paces the loop. */
+    while (1) {
+        display_frame_t *f = display_back();
+
+        display_put_number(f, tenths, 2);
+        f->seg[DISPLAY_ROWS - 2] |= SEG_DP;
+
+        for (uint8_t row = 0; row < DISPLAY_ROWS; row++) {
+            /* Never fully dark, so the digits stay readable */
+            uint8_t level = triangle(wave / 4 + row * 4);
+            f->level[row] = level < 2 ? 2 : level;
+        }
+
+        display_swap();
+        wave++;
+
+        elapsed_us += DISPLAY_FRAME_US;
+        if (elapsed_us >= 100000) {
+            elapsed_us -= 100000;
+            tenths = (tenths + 1) % 10000;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,748 @@
+/**
+ * Chapter 4: Timers and PWM - Note Sequencer Example
+ *
+ * A non-blocking music sequencer with a packed note-stream format.
+ * Tone-Generator stores every note as a 4-byte Note struct and plays the
+ * song from the main loop with delay_ms(). Here a note is one byte, the
+ * sequencer advances from a 1 ms timer interrupt, and the song is streamed
+ * through a small double buffer - from internal flash or from a W25Q16 SPI
+ * flash chip - so songs can be far larger than RAM. The main loop is free;
+ * in this demo it just sleeps.
+ *
+ * Stream format (one byte per note or rest):
+ *
+ *   bit  7  6  5  4  3  2  1  0
+ *       [ duration ][   pitch    ]
+ *
+ *   duration: 0-7 -> 1, 2, 3, 4, 6, 8, 12, 16 sixteenth notes
+ *   pitch:    0 = rest, 1-30 = semitones from the base note,
+ *             31 = control event, duration field selects the command:
+ *               0 END              end of song (repeat or stop)
+ *               1 TEMPO, <bpm>     quarter notes per minute
+ *               2 BASE, <midi>     pitch p plays MIDI note <midi> + p
+ *
+ * Concepts demonstrated:
+ *   - Bit-packed data formats
+ *   - Event-driven playback from a timer interrupt
+ *   - Double-buffered streaming refilled from a low-priority PendSV
+ *   - Interrupt priorities (tick preempts the refill)
+ *   - Equal-tempered pitch from a 12-entry period table
+ *   - SPI flash as bulk storage
+ *
+ * Hardware:
+ *   - P1.6: Tone output (CT32B0_MAT0) - piezo buzzer or speaker
+ *   - P3.0-P3.3: LEDs show the pitch of the current note
+ *   - Optional W25Q16 SPI flash (wired as in Chapter 9):
+ *       CLK -> P0.6, DO -> P0.8, DI -> P0.9, /CS -> P0.2
+ *     If it is present the song is copied to it once and then streamed
+ *     from it; otherwise the song streams from internal flash.
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL  (*((volatile uint32_t *)0x40048080))
+#define PRESETCTRL     (*((volatile uint32_t *)0x40048004))
+#define SSP0CLKDIV     (*((volatile uint32_t *)0x40048094))
+
+/* IOCON */
+#define IOCON_PIO0_2   (*((volatile uint32_t *)0x4004401C))
+#define IOCON_PIO0_6   (*((volatile uint32_t *)0x4004404C))
+#define IOCON_PIO0_8   (*((volatile uint32_t *)0x40044060))
+#define IOCON_PIO0_9   (*((volatile uint32_t *)0x40044064))
+#define IOCON_SCK_LOC  (*((volatile uint32_t *)0x400440B0))
+#define IOCON_PIO1_6   (*((volatile uint32_t *)0x400440A4))
+#define IOCON_PIO3_0   (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1   (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2   (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3   (*((volatile uint32_t *)0x400440AC))
+
+/* GPIO Port 0 (SPI chip select) */
+#define GPIO0DIR       (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA      (*((volatile uint32_t *)0x50003FFC))
+
+/* GPIO Port 3 (status LEDs) */
+#define GPIO3DIR       (*((volatile uint32_t *)0x50038000))
+#define GPIO3DATA      (*((volatile uint32_t *)0x50033FFC))
+
+/* SSP0 Registers (SPI) */
+#define SSP0CR0        (*((volatile uint32_t *)0x40040000))
+#define SSP0CR1        (*((volatile uint32_t *)0x40040004))
+#define SSP0DR         (*((volatile uint32_t *)0x40040008))
+#define SSP0SR         (*((volatile uint32_t *)0x4004000C))
+#define SSP0CPSR       (*((volatile uint32_t *)0x40040010))
+
+/* CT32B0 Timer Registers (tone generation) */
+#define TMR32B0TCR     (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR      (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR     (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0     (*((volatile uint32_t *)0x40014018))
+#define TMR32B0MR3     (*((volatile uint32_t *)0x40014024))
+#define TMR32B0PWMC    (*((volatile uint32_t *)0x40014074))
+
+/* CT32B1 Timer Registers (sequencer tick) */
+#define TMR32B1IR      (*((volatile uint32_t *)0x40018000))
+#define TMR32B1TCR     (*((volatile uint32_t *)0x40018004))
+#define TMR32B1PR      (*((volatile uint32_t *)0x4001800C))
+#define TMR32B1MCR     (*((volatile uint32_t *)0x40018014))
+#define TMR32B1MR0     (*((volatile uint32_t *)0x40018018))
+
+/* NVIC and System Control Block */
+#define NVIC_ISER1     (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+#define SCB_ICSR       (*((volatile uint32_t *)0xE000ED04))
+#define SCB_SHPR3      (*((volatile uint32_t *)0xE000ED20))
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define LED_MASK       0x0F
+#define SPI_CS_PIN     (1 << 2)
+
+#define SYSTEM_CLOCK   72000000UL
+
+/* Clock enable bits */
+#define GPIO_CLK       (1 << 6)
+#define CT32B0_CLK     (1 << 9)
+#define CT32B1_CLK     (1 << 10)
+#define SSP0_CLK       (1 << 11)
+#define IOCON_CLK      (1 << 16)
+
+/* CT32B1 IRQ number */
+#define CT32B1_IRQn    44
+
+/* ICSR: set PendSV pending */
+#define ICSR_PENDSVSET (1 << 28)
+
+/* SSP status bits */
+#define SSP_TNF        (1 << 1)
+#define SSP_RNE        (1 << 2)
+#define SSP_BSY        (1 << 4)
+
+/* W25Q16 commands and status */
+#define W25Q_WRITE_ENABLE   0x06
+#define W25Q_READ_STATUS1   0x05
+#define W25Q_READ_DATA      0x03
+#define W25Q_PAGE_PROGRAM   0x02
+#define W25Q_SECTOR_ERASE   0x20
+#define W25Q_JEDEC_ID       0x9F
+#define W25Q_BUSY           (1 << 0)
+
+/* Where the demo song lives in SPI flash (sector 16) */
+#define SONG_FLASH_ADDR     0x010000
+
+/*******************************************************************************
+ * Note Stream Format
+ ******************************************************************************/
+
+#define SEQ_PITCH_MASK 0x1F
+#define SEQ_DUR_SHIFT  5
+#define SEQ_REST       0
+#define SEQ_CTRL       31
+
+/* Duration codes (in sixteenth notes: 1, 2, 3, 4, 6, 8, 12, 16) */
+#define DUR_16 0       /* Sixteenth */
+#define DUR_8  1       /* Eighth */
+#define DUR_8D 2       /* Dotted eighth */
+#define DUR_4  3       /* Quarter */
+#define DUR_4D 4       /* Dotted quarter */
+#define DUR_2  5       /* Half */
+#define DUR_2D 6       /* Dotted half */
+#define DUR_1  7       /* Whole */
+
+static const uint8_t seq_units[8] = { 1, 2, 3, 4, 6, 8, 12, 16 };
+
+/* Control commands (in the duration field of a pitch-31 byte) */
+#define SEQ_CMD_END    0
+#define SEQ_CMD_TEMPO  1
+#define SEQ_CMD_BASE   2
+
+/* Build stream bytes. SEQ_NOTE takes a MIDI note number and the base
+ * note currently in effect, so songs read like sheet music. */
+#define SEQ_NOTE(midi, base, d)  ((uint8_t)(((d) << SEQ_DUR_SHIFT) | ((midi) - (base))))
+#define SEQ_PAUSE(d)             ((uint8_t)(((d) << SEQ_DUR_SHIFT) | SEQ_REST))
+#define SEQ_CMD(c)               ((uint8_t)(((c) << SEQ_DUR_SHIFT) | SEQ_CTRL))
+#define SEQ_END                  SEQ_CMD(SEQ_CMD_END)
+#define SEQ_TEMPO(bpm)           SEQ_CMD(SEQ_CMD_TEMPO), (bpm)
+#define SEQ_BASE(base)           SEQ_CMD(SEQ_CMD_BASE), (base)
+
+/* Defaults until the stream says otherwise */
+#define SEQ_DEFAULT_BPM   120
+#define SEQ_DEFAULT_BASE  54        /* Pitch 1 = G3 */
+
+/*******************************************************************************
+ * Demo Song
+ ******************************************************************************/
+
+/* MIDI note numbers */
+#define MIDI_G3 55
+#define MIDI_C4 60
+#define MIDI_D4 62
+#define MIDI_E4 64
+#define MIDI_F4 65
+#define MIDI_G4 67
+
+#define N(m, d)  SEQ_NOTE(m, SEQ_DEFAULT_BASE, d)
+
+/* "Mary Had a Little Lamb", then "Ode to Joy": 96 bytes for 88 notes and
+ * 3 rests. As Tone-Generator's Note structs they would take 364 bytes. */
+const uint8_t song[] = {
+    SEQ_TEMPO(200),
+    N(MIDI_E4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_C4, DUR_4), N(MIDI_D4, DUR_4),
+    N(MIDI_E4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_E4, DUR_2),
+    N(MIDI_D4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_D4, DUR_2),
+    N(MIDI_E4, DUR_4), N(MIDI_G4, DUR_4), N(MIDI_G4, DUR_2),
+    N(MIDI_E4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_C4, DUR_4), N(MIDI_D4, DUR_4),
+    N(MIDI_E4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_E4, DUR_4),
+    N(MIDI_D4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_D4, DUR_4),
+    N(MIDI_C4, DUR_2D), SEQ_PAUSE(DUR_1),
+
+    SEQ_TEMPO(120),
+    /* A */
+    N(MIDI_E4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_F4, DUR_4), N(MIDI_G4, DUR_4),
+    N(MIDI_G4, DUR_4), N(MIDI_F4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_D4, DUR_4),
+    N(MIDI_C4, DUR_4), N(MIDI_C4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_E4, DUR_4),
+    N(MIDI_E4, DUR_4D), N(MIDI_D4, DUR_8), N(MIDI_D4, DUR_2),
+    /* A' */
+    N(MIDI_E4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_F4, DUR_4), N(MIDI_G4, DUR_4),
+    N(MIDI_G4, DUR_4), N(MIDI_F4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_D4, DUR_4),
+    N(MIDI_C4, DUR_4), N(MIDI_C4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_E4, DUR_4),
+    N(MIDI_D4, DUR_4D), N(MIDI_C4, DUR_8), N(MIDI_C4, DUR_2),
+    /* B */
+    N(MIDI_D4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_C4, DUR_4),
+    N(MIDI_D4, DUR_4), N(MIDI_E4, DUR_8), N(MIDI_F4, DUR_8),
+    N(MIDI_E4, DUR_4), N(MIDI_C4, DUR_4),
+    N(MIDI_D4, DUR_4), N(MIDI_E4, DUR_8), N(MIDI_F4, DUR_8),
+    N(MIDI_E4, DUR_4), N(MIDI_D4, DUR_4),
+    N(MIDI_C4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_G3, DUR_2),
+    /* A' */
+    N(MIDI_E4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_F4, DUR_4), N(MIDI_G4, DUR_4),
+    N(MIDI_G4, DUR_4), N(MIDI_F4, DUR_4), N(MIDI_E4, DUR_4), N(MIDI_D4, DUR_4),
+    N(MIDI_C4, DUR_4), N(MIDI_C4, DUR_4), N(MIDI_D4, DUR_4), N(MIDI_E4, DUR_4),
+    N(MIDI_D4, DUR_4D), N(MIDI_C4, DUR_8), N(MIDI_C4, DUR_2),
+    SEQ_PAUSE(DUR_1), SEQ_PAUSE(DUR_1),
+
+    SEQ_END
+};
+
+#undef N
+
+/*******************************************************************************
+ * Sequencer Types and State
+ ******************************************************************************/
+
+/* Stream buffer: two halves, one being played while the other is refilled */
+#define SEQ_BUF_SIZE   64
+#define SEQ_HALF       (SEQ_BUF_SIZE / 2)
+
+/* A stream source copies len bytes at offset addr into buf */
+typedef struct {
+    void (*read)(uint32_t addr, uint8_t *buf, uint32_t len);
+    uint32_t start;
+    uint8_t repeat;            /* 1 = start over at END */
+} seq_source_t;
+
+/* Called from the tick interrupt at every note (MIDI number) or rest (0) */
+void (*seq_event_cb)(uint8_t midi) = 0;
+
+static const seq_source_t *seq_src;
+
+/* Buffer - the tick interrupt reads, PendSV fills */
+static uint8_t seq_buf[SEQ_BUF_SIZE];
+static volatile uint8_t seq_valid[2];
+static uint32_t seq_rd;
+
+/* Refill requests, changed only with interrupts masked */
+static volatile uint32_t seq_fill_addr;
+static volatile uint32_t seq_fill_next;
+static volatile uint32_t seq_fill_count;
+static volatile uint32_t seq_gen;          /* Bumped on every seek */
+
+/* Playback state, owned by the tick interrupt */
+static uint32_t seq_wait_ms;
+static uint32_t seq_gate_ms;
+static uint32_t seq_ms_per_unit;
+static uint32_t seq_base;
+
+volatile uint8_t seq_running = 0;
+volatile uint32_t seq_stall_ms = 0;        /* Ticks spent waiting for data */
+
+/*******************************************************************************
+ * Interrupt Helpers
+ ******************************************************************************/
+
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/*******************************************************************************
+ * Tone Output
+ ******************************************************************************/
+
+/* CT32B0 period for MIDI notes 0-11 (C-1 to B-1). Every octave up halves
+ * the period, so period(n) = note_period[n % 12] >> (n / 12). */
+static const uint32_t note_period[12] = {
+    8806479, 8312209, 7845681, 7405336, 6989707, 6597405,
+    6227121, 5877619, 5547734, 5236364, 4942469, 4665070
+};
+
+void tone_init(void) {
+    SYSAHBCLKCTRL |= CT32B0_CLK;
+
+    /* Configure P1.6 as CT32B0_MAT0 */
+    IOCON_PIO1_6 = 0x02;
+
+    TMR32B0TCR = 0x02;
+    TMR32B0PR = 0;
+    TMR32B0MR3 = 0xFFFFFFFF;
+    TMR32B0MR0 = 0;
+    TMR32B0MCR = (1 << 10);  /* Reset on MR3 */
+    TMR32B0PWMC = 0;
+    TMR32B0TCR = 0x01;
+}
+
+/**
+ * Start a square wave at a MIDI note. The counter is restarted so a new
+ * MR3 below the current count can't send TC on a trip to 2^32.
+ */
+static void tone_on(uint8_t midi) {
+    uint32_t period = note_period[midi % 12] >> (midi / 12);
+
+    TMR32B0TCR = 0x02;
+    TMR32B0MR3 = period - 1;
+    TMR32B0MR0 = period / 2;
+    TMR32B0PWMC = (1 << 0);
+    TMR32B0TCR = 0x01;
+}
+
+static void tone_off(void) {
+    TMR32B0PWMC = 0;
+}
+
+/*******************************************************************************
+ * Sequencer - Stream Buffer
+ ******************************************************************************/
+
+static inline void seq_request_refill(void) {
+    SCB_ICSR = ICSR_PENDSVSET;
+}
+
+/**
+ * Byte at seq_rd + offset, or -1 if that half hasn't been filled yet
+ */
+static int seq_peek(uint32_t offset) {
+    uint32_t pos = (seq_rd + offset) & (SEQ_BUF_SIZE - 1);
+
+    if (!seq_valid[pos / SEQ_HALF]) return -1;
+    return seq_buf[pos];
+}
+
+/**
+ * Consume n bytes. Each half that is used up is handed back for refill.
+ */
+static void seq_consume(uint32_t n) {
+    while (n--) {
+        uint32_t half = seq_rd / SEQ_HALF;
+
+        seq_rd = (seq_rd + 1) & (SEQ_BUF_SIZE - 1);
+        if ((seq_rd % SEQ_HALF) == 0) {
+            seq_valid[half] = 0;
+            seq_fill_count++;
+            seq_request_refill();
+        }
+    }
+}
+
+/**
+ * Restart the stream at the beginning of the source.
+ * Called with interrupts masked or from the tick interrupt.
+ */
+static void seq_seek_start(void) {
+    seq_gen++;
+    seq_valid[0] = 0;
+    seq_valid[1] = 0;
+    seq_rd = 0;
+    seq_fill_addr = seq_src->start;
+    seq_fill_next = 0;
+    seq_fill_count = 2;
+    seq_request_refill();
+}
+
+/**
+ * PendSV runs at the lowest priority: the sequencer tick (and everything
+ * else) preempts it, so a slow SPI read never delays a note. The buffer
+ * bookkeeping is done with interrupts masked; the read itself is not.
+ *
+ * If a seek happens while a read is in progress, the generation number
+ * has changed and the stale data is dropped.
+ */
+void PendSV_Handler(void) {
+    while (1) {
+        uint32_t primask = irq_save();
+
+        if (seq_fill_count == 0) {
+            irq_restore(primask);
+            break;
+        }
+
+        uint32_t half = seq_fill_next;
+        uint32_t addr = seq_fill_addr;
+        uint32_t gen = seq_gen;
+        const seq_source_t *src = seq_src;
+
+        irq_restore(primask);
+
+        src->read(addr, &seq_buf[half * SEQ_HALF], SEQ_HALF);
+
+        primask = irq_save();
+        if (gen == seq_gen) {
+            seq_valid[half] = 1;
+            seq_fill_next = half ^ 1;
+            seq_fill_addr = addr + SEQ_HALF;
+            seq_fill_count--;
+        }
+        irq_restore(primask);
+    }
+}
+
+/*******************************************************************************
+ * Sequencer - Playback
+ ******************************************************************************/
+
+static void seq_set_tempo(uint32_t bpm) {
+    if (bpm == 0) bpm = SEQ_DEFAULT_BPM;
+    seq_ms_per_unit = 15000 / bpm;      /* ms per sixteenth note */
+}
+
+/**
+ * Run events until one takes time (a note or rest).
+ * Returns 0 if the stream stalled because the next bytes aren't loaded.
+ */
+static uint8_t seq_next_event(void) {
+    while (seq_wait_ms == 0) {
+        int b = seq_peek(0);
+        if (b < 0) return 0;
+
+        uint32_t pitch = b & SEQ_PITCH_MASK;
+        uint32_t code = (uint32_t)b >> SEQ_DUR_SHIFT;
+
+        if (pitch == SEQ_CTRL) {
+            int arg;
+
+            switch (code) {
+                case SEQ_CMD_END:
+                    tone_off();
+                    if (seq_event_cb) seq_event_cb(0);
+                    if (seq_src->repeat) {
+                        seq_set_tempo(SEQ_DEFAULT_BPM);
+                        seq_base = SEQ_DEFAULT_BASE;
+                        seq_seek_start();
+                    } else {
+                        seq_running = 0;
+                    }
+                    return 1;
+                case SEQ_CMD_TEMPO:
+                case SEQ_CMD_BASE:
+                    arg = seq_peek(1);
+                    if (arg < 0) return 0;
+                    seq_consume(2);
+                    if (code == SEQ_CMD_TEMPO) seq_set_tempo(arg);
+                    else seq_base = arg;
+                    break;
+                default:
+                    seq_consume(1);     /* Unknown: skip */
+                    break;
+            }
+            continue;
+        }
+
+        seq_consume(1);
+
+        uint32_t duration = seq_units[code] * seq_ms_per_unit;
+
+        if (pitch == SEQ_REST) {
+            tone_off();
+            seq_gate_ms = 0;
+            if (seq_event_cb) seq_event_cb(0);
+        } else {
+            uint8_t midi = seq_base + pitch;
+
+            /* Short silence at the end of every note to separate repeats */
+            uint32_t gap = seq_ms_per_unit / 2;
+            tone_on(midi);
+            seq_gate_ms = (duration > gap) ? duration - gap : 1;
+            if (seq_event_cb) seq_event_cb(midi);
+        }
+        seq_wait_ms = duration;
+    }
+    return 1;
+}
+
+/**
+ * One millisecond of sequencer time. Usually just two counters; the
+ * stream is only decoded when the current event ends.
+ */
+static void seq_tick(void) {
+    if (!seq_running) return;
+
+    if (seq_gate_ms && --seq_gate_ms == 0) tone_off();
+
+    if (seq_wait_ms && --seq_wait_ms) return;
+
+    if (!seq_next_event()) seq_stall_ms++;
+}
+
+void CT32B1_IRQHandler(void) {
+    if (TMR32B1IR & (1 << 0)) {
+        TMR32B1IR = (1 << 0);
+        seq_tick();
+    }
+}
+
+/**
+ * 1 ms tick on CT32B1, PendSV at the lowest priority
+ */
+void seq_init(void) {
+    SYSAHBCLKCTRL |= CT32B1_CLK;
+
+    SCB_SHPR3 = (SCB_SHPR3 & ~(0xFFu << 16)) | (0xFFu << 16);
+
+    TMR32B1TCR = 0x02;
+    TMR32B1PR = 71;      /* 1 MHz */
+    TMR32B1MR0 = 999;    /* 1 ms */
+    TMR32B1MCR = (1 << 0) | (1 << 1);
+    TMR32B1IR = 0x1F;
+
+    NVIC_ISER1 = (1 << (CT32B1_IRQn - 32));
+    TMR32B1TCR = 0x01;
+}
+
+/**
+ * Start playing a stream. Returns immediately; playback and streaming
+ * run in interrupts until END (or forever if the source repeats).
+ */
+void seq_play(const seq_source_t *src) {
+    uint32_t primask = irq_save();
+
+    tone_off();
+    seq_src = src;
+    seq_wait_ms = 0;
+    seq_gate_ms = 0;
+    seq_stall_ms = 0;
+    seq_set_tempo(SEQ_DEFAULT_BPM);
+    seq_base = SEQ_DEFAULT_BASE;
+    seq_seek_start();
+    seq_running = 1;
+
+    irq_restore(primask);
+}
+
+void seq_stop(void) {
+    uint32_t primask = irq_save();
+    seq_running = 0;
+    tone_off();
+    irq_restore(primask);
+}
+
+/*******************************************************************************
+ * SPI Flash (W25Q16)
+ ******************************************************************************/
+
+static void cs_low(void)  { GPIO0DATA &= ~SPI_CS_PIN; }
+static void cs_high(void) { GPIO0DATA |= SPI_CS_PIN; }
+
+void spi_init(void) {
+    SYSAHBCLKCTRL |= SSP0_CLK | GPIO_CLK | IOCON_CLK;
+    SSP0CLKDIV = 1;
+    PRESETCTRL |= (1 << 0);
+
+    IOCON_SCK_LOC = 0x02;       /* SCK0 on P0.6 */
+    IOCON_PIO0_6 = 0x02;        /* SCK0 */
+    IOCON_PIO0_8 = 0x01;        /* MISO0 */
+    IOCON_PIO0_9 = 0x01;        /* MOSI0 */
+
+    IOCON_PIO0_2 = 0x00;        /* GPIO for /CS */
+    GPIO0DIR |= SPI_CS_PIN;
+    cs_high();
+
+    /* 8-bit, SPI mode 0, 72 MHz / (2 * 4) = 9 MHz */
+    SSP0CR0 = 0x07 | (3 << 8);
+    SSP0CPSR = 2;
+    SSP0CR1 = (1 << 1);
+}
+
+static uint8_t spi_transfer(uint8_t data) {
+    while ((SSP0SR & SSP_TNF) == 0);
+    SSP0DR = data;
+    while (SSP0SR & SSP_BSY);
+    while ((SSP0SR & SSP_RNE) == 0);
+    return SSP0DR;
+}
+
+static void w25q_command_addr(uint8_t cmd, uint32_t addr) {
+    spi_transfer(cmd);
+    spi_transfer((addr >> 16) & 0xFF);
+    spi_transfer((addr >> 8) & 0xFF);
+    spi_transfer(addr & 0xFF);
+}
+
+static void w25q_wait_busy(void) {
+    uint8_t status;
+
+    do {
+        cs_low();
+        spi_transfer(W25Q_READ_STATUS1);
+        status = spi_transfer(0xFF);
+        cs_high();
+    } while (status & W25Q_BUSY);
+}
+
+static void w25q_write_enable(void) {
+    cs_low();
+    spi_transfer(W25Q_WRITE_ENABLE);
+    cs_high();
+}
+
+uint8_t w25q_present(void) {
+    uint8_t mfr, type, cap;
+
+    cs_low();
+    spi_transfer(W25Q_JEDEC_ID);
+    mfr = spi_transfer(0xFF);
+    type = spi_transfer(0xFF);
+    cap = spi_transfer(0xFF);
+    cs_high();
+
+    return (mfr == 0xEF) && (type == 0x40) && (cap == 0x15);
+}
+
+void w25q_read(uint32_t addr, uint8_t *buf, uint32_t len) {
+    cs_low();
+    w25q_command_addr(W25Q_READ_DATA, addr);
+    while (len--) *buf++ = spi_transfer(0xFF);
+    cs_high();
+}
+
+/**
+ * Store data at a sector-aligned address, one 256-byte page at a time.
+ * Skipped when the flash already holds the same bytes, so the sector is
+ * not erased on every reset.
+ */
+void w25q_store(uint32_t addr, const uint8_t *data, uint32_t len) {
+    uint8_t same = 1;
+
+    cs_low();
+    w25q_command_addr(W25Q_READ_DATA, addr);
+    for (uint32_t i = 0; i < len; i++) {
+        if (spi_transfer(0xFF) != data[i]) same = 0;
+    }
+    cs_high();
+    if (same) return;
+
+    w25q_write_enable();
+    cs_low();
+    w25q_command_addr(W25Q_SECTOR_ERASE, addr);
+    cs_high();
+    w25q_wait_busy();
+
+    for (uint32_t done = 0; done < len; done += 256) {
+        uint32_t n = (len - done < 256) ? len - done : 256;
+
+        w25q_write_enable();
+        cs_low();
+        w25q_command_addr(W25Q_PAGE_PROGRAM, addr + done);
+        for (uint32_t i = 0; i < n; i++) spi_transfer(data[done + i]);
+        cs_high();
+        w25q_wait_busy();
+    }
+}
+
+/*******************************************************************************
+ * Stream Sources
+ ******************************************************************************/
+
+static void internal_read(uint32_t addr, uint8_t *buf, uint32_t len) {
+    /* Past the end: pad with END so a short final half is harmless */
+    while (len--) {
+        *buf++ = (addr < sizeof(song)) ? song[addr] : SEQ_END;
+        addr++;
+    }
+}
+
+static const seq_source_t internal_source = { internal_read, 0, 1 };
+static const seq_source_t spi_source = { w25q_read, SONG_FLASH_ADDR, 1 };
+
+/*******************************************************************************
+ * LED Functions
+ ******************************************************************************/
+
+void leds_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO3DIR |= LED_MASK;
+    GPIO3DATA |= LED_MASK;
+}
+
+/**
+ * Sequencer callback: higher notes light more LEDs
+ */
+static void show_note(uint8_t midi) {
+    uint8_t pattern = 0;
+
+    if (midi >= MIDI_G4) pattern = 0x0F;
+    else if (midi >= MIDI_E4) pattern = 0x07;
+    else if (midi >= MIDI_C4) pattern = 0x03;
+    else if (midi > 0) pattern = 0x01;
+
+    uint32_t current = GPIO3DATA;
+    current |= LED_MASK;
+    current &= ~pattern;
+    GPIO3DATA = current;
+}
+
+/*******************************************************************************
+ * Main Function
+ ******************************************************************************/
+
+int main(void) {
+    const seq_source_t *src = &internal_source;
+
+    leds_init();
+    tone_init();
+    spi_init();
+
+    /* Copy the song to SPI flash and stream it from there if possible */
+    if (w25q_present()) {
+        w25q_store(SONG_FLASH_ADDR, song, sizeof(song));
+        src = &spi_source;
+    }
+
+    seq_event_cb = show_note;
+    seq_init();
+    seq_play(src);
+
+    /* Playback needs nothing from the main loop */
+    while (1) {
+        __asm volatile ("wfi");
+    }
+
+    return 0;
+}
@@ -0,0 +1,596 @@
+/**
+ * Chapter 6: Interrupts and Clocks - Cycle Profiler Example
+ *
+ * Measures how many CPU cycles code regions take using the Cortex-M3 DWT
+ * (Data Watchpoint and Trace) cycle counter. Each named region keeps a
+ * call count, min/max/mean and a log2 histogram, and a small serial CLI
+ * dumps the results with the `prof` command.
+ *
+ * Profiled regions:
+ *   - calc_temp  : BMP280 temperature compensation (fixed-point math)
+ *   - command    : process_command() for one CLI line
+ *   - uart_isr   : UART0_IRQHandler (receive into ring buffer)
+ *
+ * Concepts demonstrated:
+ *   - DEMCR.TRCENA and DWT_CTRL.CYCCNTENA to start the cycle counter
+ *   - A SysTick-based virtual cycle counter for cores without CYCCNT
+ *   - Begin/end markers that compile away when PROFILING is 0
+ *   - Runtime enable/disable costing one load and branch per region
+ *   - Subtracting the measured overhead of the markers themselves
+ *   - log2 histogram buckets using the CLZ instruction
+ *   - Profiling an interrupt handler from inside the handler
+ *
+ * Hardware:
+ *   - P1.6: UART RXD
+ *   - P1.7: UART TXD (115200 8N1)
+ *   - P3.0-P3.3: LEDs (LED0 on while profiling is enabled)
+ *
+ * Note: This example assumes 72 MHz system clock (PLL configured)
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/* IOCON for UART and LED pins */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))
+#define IOCON_PIO3_0    (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1    (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2    (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3    (*((volatile uint32_t *)0x400440AC))
+
+/* UART Registers */
+#define U0RBR           (*((volatile uint32_t *)0x40008000))
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0IER           (*((volatile uint32_t *)0x40008004))
+#define U0IIR           (*((volatile uint32_t *)0x40008008))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/* GPIO Port 3 (LEDs) */
+#define GPIO3DIR        (*((volatile uint32_t *)0x50038000))
+#define GPIO3DATA       (*((volatile uint32_t *)0x50033FFC))
+
+/* NVIC */
+#define NVIC_ISER1      (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+#define NVIC_ICER1      (*((volatile uint32_t *)0xE000E184))
+
+/* Debug and Trace (ARM Cortex-M3 core) */
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))  /* Debug Exception and Monitor Control */
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))  /* DWT Control */
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))  /* Cycle Counter */
+
+/* SysTick and interrupt control (virtual cycle counter) */
+#define SYST_CSR        (*((volatile uint32_t *)0xE000E010))  /* Control and Status */
+#define SYST_RVR        (*((volatile uint32_t *)0xE000E014))  /* Reload Value */
+#define SYST_CVR        (*((volatile uint32_t *)0xE000E018))  /* Current Value */
+#define ICSR            (*((volatile uint32_t *)0xE000ED04))  /* Interrupt Control and State */
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define GPIO_CLK        (1 << 6)
+#define UART_CLK        (1 << 12)
+#define IOCON_CLK       (1 << 16)
+
+#define LED_MASK        0x0F
+#define UART_IRQn       46
+
+#define SYSTEM_CLOCK    72000000UL
+
+/* DWT enable bits */
+#define DEMCR_TRCENA        (1 << 24)
+#define DWT_CTRL_CYCCNTENA  (1 << 0)
+#define DWT_CTRL_NOCYCCNT   (1 << 25)   /* No cycle counter implemented */
+
+/* SysTick bits */
+#define SYST_ENABLE         (1 << 0)
+#define SYST_TICKINT        (1 << 1)
+#define SYST_CLKSOURCE      (1 << 2)    /* Core clock */
+#define ICSR_PENDSTSET      (1 << 26)
+
+/* UART bits */
+#define LSR_RDR         (1 << 0)
+#define LSR_THRE        (1 << 5)
+#define IER_RBR         (1 << 0)
+#define IIR_PEND        (1 << 0)
+
+/* Receive ring buffer - must be power of 2 */
+#define RX_BUF_SIZE     64
+#define CMD_BUF_SIZE    64
+
+/* Set to 0 to compile every PROF_BEGIN/PROF_END marker away completely */
+#ifndef PROFILING
+#define PROFILING       1
+#endif
+
+/* Set to 1 to use the SysTick virtual counter even if CYCCNT exists. It
+ * is also selected at run time when DWT_CTRL.NOCYCCNT reads 1. */
+#ifndef PROF_SYSTICK
+#define PROF_SYSTICK    0
+#endif
+
+/* log2 histogram: bucket n counts samples in [2^n, 2^(n+1)) cycles,
+ * the last bucket also collects everything above it. */
+#define PROF_BUCKETS    24
+
+/*******************************************************************************
+ * Profiler
+ ******************************************************************************/
+
+typedef enum {
+    PROF_CALC_TEMP,
+    PROF_COMMAND,
+    PROF_UART_ISR,
+    PROF_NUM_REGIONS
+} prof_id_t;
+
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROF_BUCKETS];
+} prof_region_t;
+
+prof_region_t prof_regions[PROF_NUM_REGIONS] = {
+    [PROF_CALC_TEMP] = { .name = "calc_temp" },
+    [PROF_COMMAND]   = { .name = "command" },
+    [PROF_UART_ISR]  = { .name = "uart_isr" },
+};
+
+volatile uint8_t prof_enabled = 1;
+uint32_t prof_overhead = 0;     /* Cycles an empty begin/end pair costs */
+uint8_t prof_virtual = PROF_SYSTICK;    /* Counting with SysTick */
+volatile uint32_t prof_systick_wraps = 0;
+
+#if PROFILING
+#define PROF_BEGIN(id)  uint32_t prof_t0_##id = prof_now()
+#define PROF_END(id)    prof_record((id), prof_now() - prof_t0_##id)
+#else
+#define PROF_BEGIN(id)  do { } while (0)
+#define PROF_END(id)    do { } while (0)
+#endif
+
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/**
+ * Virtual cycle counter: SysTick counts the core clock down from 2^24 - 1,
+ * and its interrupt counts the wraps. Reads are done with interrupts
+ * masked, and a wrap whose interrupt is still pending (we are in a
+ * higher-priority handler, or masked) is added by hand. Wraps are lost
+ * only if interrupts stay masked for more than 2^24 cycles (233 ms).
+ */
+void SysTick_Handler(void) {
+    prof_systick_wraps++;
+}
+
+static uint32_t prof_systick_now(void) {
+    uint32_t primask = irq_save();
+    uint32_t hi = prof_systick_wraps;
+    uint32_t lo = SYST_CVR;
+
+    if (ICSR & ICSR_PENDSTSET) {
+        lo = SYST_CVR;          /* Surely after the wrap now */
+        hi++;
+    }
+    irq_restore(primask);
+
+    return (hi << 24) | (0x00FFFFFF - lo);
+}
+
+/**
+ * Current cycle count from whichever counter prof_init() picked. Both
+ * wrap at 2^32 cycles, so unsigned subtraction works for either.
+ */
+static inline uint32_t prof_now(void) {
+    if (prof_virtual) return prof_systick_now();
+    return DWT_CYCCNT;
+}
+
+/**
+ * Start the DWT cycle counter. It runs at the core clock and wraps every
+ * 2^32 / 72 MHz = 59.6 s; unsigned subtraction handles the wrap.
+ * Without CYCCNT (or with PROF_SYSTICK) SysTick is used instead.
+ */
+void prof_init(void) {
+    DEMCR |= DEMCR_TRCENA;
+
+    if (DWT_CTRL & DWT_CTRL_NOCYCCNT) prof_virtual = 1;
+
+    if (prof_virtual) {
+        SYST_RVR = 0x00FFFFFF;
+        SYST_CVR = 0;
+        SYST_CSR = SYST_CLKSOURCE | SYST_TICKINT | SYST_ENABLE;
+    } else {
+        DWT_CYCCNT = 0;
+        DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+    }
+}
+
+/**
+ * Fold one measurement into a region. Called from thread and interrupt
+ * context, so the update is done with interrupts masked - otherwise an
+ * ISR sample for the same region could land between the read and write.
+ */
+void prof_record(prof_id_t id, uint32_t cycles) {
+    if (!prof_enabled) return;
+
+    cycles = (cycles > prof_overhead) ? cycles - prof_overhead : 0;
+
+    /* Bucket = index of highest set bit (CLZ is one cycle on the M3) */
+    uint32_t bucket = cycles ? 31 - __builtin_clz(cycles) : 0;
+    if (bucket >= PROF_BUCKETS) bucket = PROF_BUCKETS - 1;
+
+    prof_region_t *r = &prof_regions[id];
+    uint32_t primask = irq_save();
+
+    if (r->count == 0 || cycles < r->min) r->min = cycles;
+    if (cycles > r->max) r->max = cycles;
+    r->sum += cycles;
+    r->count++;
+    r->hist[bucket]++;
+
+    irq_restore(primask);
+}
+
+void prof_reset(void) {
+    uint32_t primask = irq_save();
+    for (int i = 0; i < PROF_NUM_REGIONS; i++) {
+        prof_region_t *r = &prof_regions[i];
+        r->count = 0;
+        r->min = 0;
+        r->max = 0;
+        r->sum = 0;
+        for (int b = 0; b < PROF_BUCKETS; b++) r->hist[b] = 0;
+    }
+    irq_restore(primask);
+}
+
+/**
+ * Measure what an empty PROF_BEGIN/PROF_END pair costs so it can be
+ * subtracted from every sample. Keep the minimum of several runs.
+ */
+void prof_calibrate(void) {
+    uint32_t best = 0xFFFFFFFF;
+
+    prof_overhead = 0;
+    for (int i = 0; i < 16; i++) {
+        uint32_t t0 = prof_now();
+        __asm volatile ("" ::: "memory");
+        uint32_t t1 = prof_now();
+        if (t1 - t0 < best) best = t1 - t0;
+    }
+    prof_overhead = best;
+}
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+
+volatile uint8_t rx_buffer[RX_BUF_SIZE];
+volatile uint16_t rx_head = 0;
+volatile uint16_t rx_tail = 0;
+
+/* BMP280 datasheet example calibration, so no sensor is needed */
+static uint16_t dig_T1 = 27504;
+static int16_t dig_T2 = 26435;
+static int16_t dig_T3 = -1000;
+
+/*******************************************************************************
+ * Interrupt Handlers
+ ******************************************************************************/
+
+void UART0_IRQHandler(void) {
+    PROF_BEGIN(PROF_UART_ISR);
+
+    if (!(U0IIR & IIR_PEND)) {
+        while (U0LSR & LSR_RDR) {
+            uint8_t c = U0RBR;
+            uint16_t next = (rx_head + 1) & (RX_BUF_SIZE - 1);
+            if (next != rx_tail) {
+                rx_buffer[rx_head] = c;
+                rx_head = next;
+            }
+        }
+    }
+
+    PROF_END(PROF_UART_ISR);
+}
+
+/*******************************************************************************
+ * UART Functions
+ ******************************************************************************/
+
+void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= UART_CLK | IOCON_CLK;
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x01;
+
+    U0IER = IER_RBR;
+    NVIC_ISER1 = (1 << (UART_IRQn - 32));
+}
+
+void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+int16_t uart_read(void) {
+    if (rx_head == rx_tail) return -1;
+    uint8_t c = rx_buffer[rx_tail];
+    rx_tail = (rx_tail + 1) & (RX_BUF_SIZE - 1);
+    return c;
+}
+
+/**
+ * Collect a line from the ring buffer with echo and backspace.
+ * Returns 1 when a complete line is in buf.
+ */
+uint8_t uart_poll_line(char *buf, uint32_t max, uint32_t *len) {
+    int16_t c;
+
+    while ((c = uart_read()) >= 0) {
+        if (c == '\r' || c == '\n') {
+            uart_puts("\r\n");
+            buf[*len] = '\0';
+            *len = 0;
+            return 1;
+        }
+        if (c == '\b' || c == 0x7F) {
+            if (*len > 0) {
+                (*len)--;
+                uart_puts("\b \b");
+            }
+            continue;
+        }
+        if (c >= 32 && *len < max - 1) {
+            uart_putchar(c);
+            buf[(*len)++] = c;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Print an unsigned number right-aligned in a field of the given width
+ */
+void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+void print_padded(const char *s, uint8_t width) {
+    while (*s) {
+        uart_putchar(*s++);
+        if (width) width--;
+    }
+    while (width--) uart_putchar(' ');
+}
+
+/*******************************************************************************
+ * LED Functions
+ ******************************************************************************/
+
+void led_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO3DIR |= LED_MASK;
+    GPIO3DATA |= LED_MASK;
+}
+
+void led_set(uint8_t led, uint8_t on) {
+    if (on) {
+        GPIO3DATA &= ~(1 << led);
+    } else {
+        GPIO3DATA |= (1 << led);
+    }
+}
+
+/*******************************************************************************
+ * Workload: BMP280 Temperature Compensation
+ ******************************************************************************/
+
+/**
+ * Bosch compensation formula from the BMP280 datasheet (same as the
+ * BMP280-Read example). Returns temperature in 0.01 degrees C.
+ */
+int32_t bmp280_calc_temp(int32_t adc_T) {
+    PROF_BEGIN(PROF_CALC_TEMP);
+
+    int32_t var1, var2, T;
+
+    var1 = ((((adc_T >> 3) - ((int32_t)dig_T1 << 1))) * ((int32_t)dig_T2)) >> 11;
+    var2 = (((((adc_T >> 4) - ((int32_t)dig_T1)) *
+              ((adc_T >> 4) - ((int32_t)dig_T1))) >> 12) *
+            ((int32_t)dig_T3)) >> 14;
+
+    T = (var1 + var2) * 5 + 128;
+    T = T >> 8;
+
+    PROF_END(PROF_CALC_TEMP);
+    return T;
+}
+
+/*******************************************************************************
+ * Command Processing
+ ******************************************************************************/
+
+int str_equal(const char *s1, const char *s2) {
+    while (*s1 && *s2) {
+        if (*s1 != *s2) return 0;
+        s1++;
+        s2++;
+    }
+    return (*s1 == *s2);
+}
+
+/**
+ * Dump every region: count, min/max/mean in cycles, then the non-empty
+ * histogram buckets.
+ */
+void prof_dump(void) {
+    uart_puts("region       count      min      max     mean\r\n");
+
+    for (int i = 0; i < PROF_NUM_REGIONS; i++) {
+        prof_region_t snap;
+
+        /* Copy with interrupts masked so the ISR can't tear the snapshot */
+        uint32_t primask = irq_save();
+        snap = prof_regions[i];
+        irq_restore(primask);
+
+        print_padded(snap.name, 10);
+        print_number(snap.count, 8);
+        print_number(snap.min, 9);
+        print_number(snap.max, 9);
+        print_number(snap.count ? (uint32_t)(snap.sum / snap.count) : 0, 9);
+        uart_puts("\r\n");
+
+        for (int b = 0; b < PROF_BUCKETS; b++) {
+            if (snap.hist[b] == 0) continue;
+            uart_puts("    >=2^");
+            print_number(b, 2);
+            uart_puts(b == PROF_BUCKETS - 1 ? "+ : " : "  : ");
+            print_number(snap.hist[b], 8);
+            uart_puts("\r\n");
+        }
+    }
+
+    uart_puts("(marker overhead ");
+    print_number(prof_overhead, 0);
+    uart_puts(prof_virtual ? " cycles subtracted, SysTick counter, profiling "
+                           : " cycles subtracted, DWT counter, profiling ");
+    uart_puts(prof_enabled ? "on)\r\n" : "off)\r\n");
+}
+
+void process_command(char *cmd) {
+    uint8_t reset = 0;
+
+    PROF_BEGIN(PROF_COMMAND);
+
+    while (*cmd == ' ') cmd++;
+
+    if (*cmd == '\0') {
+        /* Nothing to do */
+    } else if (str_equal(cmd, "help") || str_equal(cmd, "?")) {
+        uart_puts("Available Commands:\r\n");
+        uart_puts("  temp        - Run bmp280_calc_temp 100 times\r\n");
+        uart_puts("  prof        - Dump profiling results\r\n");
+        uart_puts("  prof reset  - Clear all regions\r\n");
+        uart_puts("  prof on     - Enable profiling\r\n");
+        uart_puts("  prof off    - Disable profiling\r\n");
+    } else if (str_equal(cmd, "temp")) {
+        int32_t t = 0;
+        for (int32_t i = 0; i < 100; i++) {
+            t = bmp280_calc_temp(519888 + i * 16);
+        }
+        uart_puts("Last result: ");
+        print_number((uint32_t)t / 100, 0);
+        uart_putchar('.');
+        print_number((uint32_t)t % 100 / 10, 0);
+        print_number((uint32_t)t % 10, 0);
+        uart_puts(" C\r\n");
+    } else if (str_equal(cmd, "prof")) {
+        prof_dump();
+    } else if (str_equal(cmd, "prof reset")) {
+        reset = 1;
+    } else if (str_equal(cmd, "prof on")) {
+        prof_enabled = 1;
+        led_set(0, 1);
+        uart_puts("Profiling enabled\r\n");
+    } else if (str_equal(cmd, "prof off")) {
+        prof_enabled = 0;
+        led_set(0, 0);
+        uart_puts("Profiling disabled\r\n");
+    } else {
+        uart_puts("Unknown command. Type 'help'.\r\n");
+    }
+
+    PROF_END(PROF_COMMAND);
+
+    /* After PROF_END, so the reset command is not the first sample */
+    if (reset) {
+        prof_reset();
+        uart_puts("Profiler reset\r\n");
+    }
+}
+
+/*******************************************************************************
+ * Main Function
+ ******************************************************************************/
+
+int main(void) {
+    char cmd_buf[CMD_BUF_SIZE];
+    uint32_t cmd_len = 0;
+
+    prof_init();
+    prof_calibrate();
+
+    led_init();
+    led_set(0, prof_enabled);
+    uart_init(115200);
+
+    uart_puts("\r\nLPC1343 Cycle Profiler\r\n");
+    uart_puts("Type 'help' for available commands.\r\n> ");
+
+    while (1) {
+        if (uart_poll_line(cmd_buf, CMD_BUF_SIZE, &cmd_len)) {
+            process_command(cmd_buf);
+            uart_puts("> ");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+/**
+ * Chapter 6: Interrupts and Clocks - GPIO Dispatcher Example
+ *
+ * One interrupt API for every pin of PIO0-PIO3.
+ *
+ * Instead of hand-coding `if (GPIO0MIS & BUTTON_PIN)` in each example,
+ * a callback is attached to a pin together with its trigger:
+ *
+ *   gpio_irq_attach(0, 1, GPIO_IRQ_BOTH, on_button);
+ *
+ * The four port handlers share one dispatcher. It reads GPIOnMIS once,
+ * clears all pending edges with one GPIOnIC write, then walks only the
+ * set bits using CLZ (count leading zeros) - the cost grows with the
+ * number of pins that fired, not with the number of pins on the port.
+ *
+ * Demo (one pin on each port):
+ *   - P0.1 both edges:   LED0 follows the board button
+ *   - P1.5 falling edge: LED1 toggles
+ *   - P2.0 rising edge:  LED2 toggles
+ *   - P3.4 level:        LED3 on while LOW; the callback flips the pin
+ *                        between LOW and HIGH level triggering
+ *
+ * Concepts demonstrated:
+ *   - Edge (single/both) and level GPIO interrupt configuration
+ *   - Callback tables indexed by port and pin
+ *   - Finding set bits with __builtin_clz (the CLZ instruction)
+ *   - Clearing several edge flags with one write
+ *   - Handling level interrupts by changing the trigger
+ *
+ * Hardware:
+ *   - P0.1: Button (active-low, on the board)
+ *   - P1.5, P2.0, P3.4: Optional buttons to GND (internal pull-ups)
+ *   - P3.0-P3.3: LEDs (active-low)
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/* ARM Cortex-M3 intrinsic for Wait For Interrupt */
+#define __WFI() __asm volatile ("wfi")
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+
+/* IOCON */
+#define IOCON_PIO0_1    (*((volatile uint32_t *)0x40044010))
+#define IOCON_PIO1_5    (*((volatile uint32_t *)0x400440A0))
+#define IOCON_PIO2_0    (*((volatile uint32_t *)0x40044008))
+#define IOCON_PIO3_4    (*((volatile uint32_t *)0x4004403C))
+#define IOCON_PIO3_0    (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1    (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2    (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3    (*((volatile uint32_t *)0x400440AC))
+
+/* GPIO Port n: 0x50000000 + n * 0x10000 */
+#define GPIO_BASE(port)         (0x50000000UL + ((uint32_t)(port) << 16))
+#define GPIO_REG(port, offset)  (*((volatile uint32_t *)(GPIO_BASE(port) + (offset))))
+
+/* Masked DATA access (address bits 13:2 select the pins) */
+#define GPIO_MASKED(port, mask) GPIO_REG(port, (uint32_t)(mask) << 2)
+
+/* Register offsets within a port */
+#define GPIO_DIR        0x8000
+#define GPIO_IS         0x8004  /* Interrupt sense: 0 = edge, 1 = level */
+#define GPIO_IBE        0x8008  /* Both edges: 1 = both (IEV ignored) */
+#define GPIO_IEV        0x800C  /* Event: 1 = rising / HIGH, 0 = falling / LOW */
+#define GPIO_IE         0x8010  /* Interrupt mask: 1 = enabled */
+#define GPIO_RIS        0x8014
+#define GPIO_MIS        0x8018  /* Masked interrupt status */
+#define GPIO_IC         0x801C  /* Write 1 to clear an edge */
+
+/* NVIC */
+#define NVIC_ISER1      (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define GPIO_CLK        (1 << 6)
+#define IOCON_CLK       (1 << 16)
+
+#define LED_MASK        0x0F
+#define LED_PORT        3
+
+/* PIO3 = 53 ... PIO0 = 56 */
+#define PIO0_IRQn       56
+#define GPIO_IRQn(port) (PIO0_IRQn - (port))
+
+#define GPIO_PORTS      4
+#define GPIO_PINS       12
+
+/* IOCON: GPIO function, pull-up, hysteresis */
+#define IOCON_BUTTON    ((0x02 << 3) | (0x01 << 5))
+
+/*******************************************************************************
+ * GPIO Interrupt Dispatcher
+ ******************************************************************************/
+
+typedef enum {
+    GPIO_IRQ_FALLING,
+    GPIO_IRQ_RISING,
+    GPIO_IRQ_BOTH,
+    GPIO_IRQ_LOW,       /* Level: keeps firing while LOW */
+    GPIO_IRQ_HIGH       /* Level: keeps firing while HIGH */
+} gpio_irq_mode_t;
+
+typedef void (*gpio_irq_handler_t)(uint8_t port, uint8_t pin);
+
+static gpio_irq_handler_t gpio_handlers[GPIO_PORTS][GPIO_PINS];
+
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/**
+ * Set a pin's trigger. May be called from its own callback.
+ */
+void gpio_irq_mode(uint8_t port, uint8_t pin, gpio_irq_mode_t mode) {
+    uint32_t bit = 1u << pin;
+    uint32_t primask = irq_save();
+
+    if (mode >= GPIO_IRQ_LOW) GPIO_REG(port, GPIO_IS) |= bit;
+    else GPIO_REG(port, GPIO_IS) &= ~bit;
+
+    if (mode == GPIO_IRQ_BOTH) GPIO_REG(port, GPIO_IBE) |= bit;
+    else GPIO_REG(port, GPIO_IBE) &= ~bit;
+
+    if (mode == GPIO_IRQ_RISING || mode == GPIO_IRQ_HIGH) GPIO_REG(port, GPIO_IEV) |= bit;
+    else GPIO_REG(port, GPIO_IEV) &= ~bit;
+
+    /* Changing the sense can latch a false edge */
+    GPIO_REG(port, GPIO_IC) = bit;
+
+    irq_restore(primask);
+}
+
+/**
+ * Make a pin an input and call handler when its trigger occurs.
+ * The pin's IOCON (function, pull resistor) must already be set up.
+ */
+void gpio_irq_attach(uint8_t port, uint8_t pin, gpio_irq_mode_t mode,
+                     gpio_irq_handler_t handler) {
+    uint32_t bit = 1u << pin;
+
+    if (port >= GPIO_PORTS || pin >= GPIO_PINS) return;
+
+    SYSAHBCLKCTRL |= GPIO_CLK;
+
+    gpio_handlers[port][pin] = handler;
+    GPIO_REG(port, GPIO_DIR) &= ~bit;
+    gpio_irq_mode(port, pin, mode);
+
+    uint32_t primask = irq_save();
+    GPIO_REG(port, GPIO_IE) |= bit;
+    irq_restore(primask);
+
+    NVIC_ISER1 = (1 << (GPIO_IRQn(port) - 32));
+}
+
+void gpio_irq_detach(uint8_t port, uint8_t pin) {
+    uint32_t primask = irq_save();
+    GPIO_REG(port, GPIO_IE) &= ~(1u << pin);
+    gpio_handlers[port][pin] = 0;
+    irq_restore(primask);
+}
+
+/**
+ * Shared body of the four port handlers.
+ *
+ * Edge flags are cleared before the callbacks run, so an edge that
+ * arrives during a callback is latched again and not lost. Level
+ * interrupts cannot be cleared: the callback must remove the condition,
+ * change the trigger or detach, or the handler runs again at once.
+ */
+static void gpio_dispatch(uint8_t port) {
+    uint32_t pending = GPIO_REG(port, GPIO_MIS);
+
+    GPIO_REG(port, GPIO_IC) = pending;
+
+    while (pending) {
+        uint8_t pin = 31 - __builtin_clz(pending);
+        pending &= ~(1u << pin);
+
+        gpio_irq_handler_t handler = gpio_handlers[port][pin];
+        if (handler) handler(port, pin);
+    }
+}
+
+void PIO0_IRQHandler(void) { gpio_dispatch(0); }
+void PIO1_IRQHandler(void) { gpio_dispatch(1); }
+void PIO2_IRQHandler(void) { gpio_dispatch(2); }
+void PIO3_IRQHandler(void) { gpio_dispatch(3); }
+
+/*******************************************************************************
+ * LED Functions
+ ******************************************************************************/
+
+void led_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK | IOCON_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO_MASKED(LED_PORT, LED_MASK) = LED_MASK;   /* All off */
+    GPIO_REG(LED_PORT, GPIO_DIR) |= LED_MASK;
+}
+
+void led_write(uint8_t led, uint8_t on) {
+    GPIO_MASKED(LED_PORT, 1u << led) = on ? 0 : LED_MASK;
+}
+
+void led_toggle(uint8_t led) {
+    GPIO_MASKED(LED_PORT, 1u << led) = ~GPIO_MASKED(LED_PORT, 1u << led);
+}
+
+/*******************************************************************************
+ * Pin Callbacks
+ ******************************************************************************/
+
+/* P0.1, both edges: LED0 on while the button is held */
+void on_button(uint8_t port, uint8_t pin) {
+    led_write(0, GPIO_MASKED(port, 1u << pin) == 0);
+}
+
+/* P1.5, falling edge */
+void on_falling(uint8_t port, uint8_t pin) {
+    (void)port;
+    (void)pin;
+    led_toggle(1);
+}
+
+/* P2.0, rising edge */
+void on_rising(uint8_t port, uint8_t pin) {
+    (void)port;
+    (void)pin;
+    led_toggle(2);
+}
+
+/* P3.4, level: fires once per change by waiting for the opposite level */
+void on_level(uint8_t port, uint8_t pin) {
+    if (GPIO_MASKED(port, 1u << pin) == 0) {
+        led_write(3, 1);
+        gpio_irq_mode(port, pin, GPIO_IRQ_HIGH);
+    } else {
+        led_write(3, 0);
+        gpio_irq_mode(port, pin, GPIO_IRQ_LOW);
+    }
+}
+
+/*******************************************************************************
+ * Main Program
+ ******************************************************************************/
+
+int main(void) {
+    led_init();
+
+    IOCON_PIO0_1 = IOCON_BUTTON;
+    IOCON_PIO1_5 = IOCON_BUTTON;
+    IOCON_PIO2_0 = IOCON_BUTTON;
+    IOCON_PIO3_4 = IOCON_BUTTON;
+
+    gpio_irq_attach(0, 1, GPIO_IRQ_BOTH, on_button);
+    gpio_irq_attach(1, 5, GPIO_IRQ_FALLING, on_falling);
+    gpio_irq_attach(2, 0, GPIO_IRQ_RISING, on_rising);
+    gpio_irq_attach(3, 4, GPIO_IRQ_LOW, on_level);
+
+    /* Everything happens in the callbacks */
+    while (1) {
+        __WFI();
+    }
+
+    return 0;
+}
@@ -0,0 +1,497 @@
+/**
+ * Chapter 6: Interrupts and Clocks - Input Events Example
+ *
+ * Splits button handling into a tiny interrupt and a main-loop classifier.
+ *
+ * The GPIO interrupt fires on both edges of every button pin. It only
+ * records which pins changed, their new level and a microsecond timestamp
+ * into a lock-free queue, then returns - a few dozen cycles, well under
+ * 1 µs at 72 MHz.
+ *
+ * The main loop drains the queue, debounces each button using the
+ * timestamps, and turns presses and releases into gestures:
+ *
+ *   CLICK        press + release, no second press within 300 ms
+ *   DOUBLE_CLICK second press within 300 ms of a release
+ *   LONG_PRESS   held for 600 ms
+ *   REPEAT       every 200 ms while still held after a long press
+ *
+ * Buttons are listed in a table, so the same code serves any number of
+ * pins on port 0.
+ *
+ * Concepts demonstrated:
+ *   - Keeping interrupt handlers short: record, don't process
+ *   - Single-producer/single-consumer ring buffer without locks
+ *   - Both-edge GPIO interrupts
+ *   - Free-running 1 MHz timer for timestamps
+ *   - Debouncing and gesture timing from timestamps in the main loop
+ *
+ * Hardware:
+ *   - P0.1: Button (active-low, on the board)
+ *   - P0.2: Optional second button to GND
+ *   - P3.0-P3.3: LEDs (active-low)
+ *   - P1.7: UART TXD (115200 8N1) - event log
+ *
+ * Note: This example assumes 72 MHz system clock (PLL configured)
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/* IOCON */
+#define IOCON_PIO0_1    (*((volatile uint32_t *)0x40044010))
+#define IOCON_PIO0_2    (*((volatile uint32_t *)0x4004401C))
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))
+#define IOCON_PIO3_0    (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1    (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2    (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3    (*((volatile uint32_t *)0x400440AC))
+
+/* GPIO Port 0 (buttons) */
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+#define GPIO0IS         (*((volatile uint32_t *)0x50008004))
+#define GPIO0IBE        (*((volatile uint32_t *)0x50008008))
+#define GPIO0IE         (*((volatile uint32_t *)0x50008010))
+#define GPIO0MIS        (*((volatile uint32_t *)0x50008018))
+#define GPIO0IC         (*((volatile uint32_t *)0x5000801C))
+
+/* GPIO Port 3 (LEDs) */
+#define GPIO3DIR        (*((volatile uint32_t *)0x50038000))
+#define GPIO3DATA       (*((volatile uint32_t *)0x50033FFC))
+
+/* CT32B0 (free-running µs timestamp) */
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0TC       (*((volatile uint32_t *)0x40014008))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+
+/* UART Registers */
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/* SysTick Registers */
+#define SYST_CSR        (*((volatile uint32_t *)0xE000E010))
+#define SYST_RVR        (*((volatile uint32_t *)0xE000E014))
+#define SYST_CVR        (*((volatile uint32_t *)0xE000E018))
+
+/* NVIC */
+#define NVIC_ISER1      (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+
+/* Debug and Trace (ARM Cortex-M3 core) */
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define GPIO_CLK        (1 << 6)
+#define CT32B0_CLK      (1 << 9)
+#define UART_CLK        (1 << 12)
+#define IOCON_CLK       (1 << 16)
+
+#define LED_MASK        0x0F
+#define PIO0_IRQn       56
+
+#define SYSTEM_CLOCK    72000000UL
+
+/* DWT enable bits */
+#define DEMCR_TRCENA        (1 << 24)
+#define DWT_CTRL_CYCCNTENA  (1 << 0)
+
+#define LSR_THRE        (1 << 5)
+
+/* IOCON: GPIO function, pull-up, hysteresis */
+#define IOCON_BUTTON    ((0x02 << 3) | (0x01 << 5))
+
+/* Raw edge queue - must be power of 2 */
+#define EDGE_QUEUE_SIZE 32
+
+/* Gesture timing (microseconds) */
+#define DEBOUNCE_US     10000   /* Level must be stable this long */
+#define DOUBLE_US       300000  /* Max gap between release and 2nd press */
+#define LONG_US         600000  /* Hold time for LONG_PRESS */
+#define REPEAT_US       200000  /* REPEAT interval after LONG_PRESS */
+
+/* The main loop wakes at least this often to check timeouts */
+#define POLL_MS         10
+
+/*******************************************************************************
+ * Raw Edge Queue (interrupt -> main loop)
+ ******************************************************************************/
+
+typedef struct {
+    uint32_t time_us;      /* CT32B0 timestamp */
+    uint16_t pins;         /* Pins that caused the interrupt */
+    uint16_t level;        /* Port 0 level after the edge */
+} edge_record_t;
+
+/* Written only by the interrupt (head) or only by the main loop (tail),
+ * so no lock is needed. */
+static edge_record_t edge_queue[EDGE_QUEUE_SIZE];
+static volatile uint8_t edge_head = 0;
+static volatile uint8_t edge_tail = 0;
+
+volatile uint32_t edge_dropped = 0;    /* Records lost to a full queue */
+volatile uint32_t edge_isr_max = 0;    /* Longest handler body, cycles */
+
+/**
+ * GPIO Port 0 Handler - record and return
+ */
+void PIO0_IRQHandler(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    uint32_t time = TMR32B0TC;
+    uint32_t pins = GPIO0MIS;
+
+    /* Clear first: an edge after the level is read raises a new record */
+    GPIO0IC = pins;
+    uint32_t level = GPIO0DATA;
+
+    uint8_t head = edge_head;
+    uint8_t next = (head + 1) & (EDGE_QUEUE_SIZE - 1);
+
+    if (next == edge_tail) {
+        edge_dropped++;
+    } else {
+        edge_queue[head].time_us = time;
+        edge_queue[head].pins = pins;
+        edge_queue[head].level = level;
+        __asm volatile ("" ::: "memory");   /* Record complete before publish */
+        edge_head = next;
+    }
+
+    uint32_t cycles = DWT_CYCCNT - t0;
+    if (cycles > edge_isr_max) edge_isr_max = cycles;
+}
+
+static uint8_t edge_pop(edge_record_t *rec) {
+    uint8_t tail = edge_tail;
+
+    if (tail == edge_head) return 0;
+
+    __asm volatile ("" ::: "memory");       /* Read record after head */
+    *rec = edge_queue[tail];
+    edge_tail = (tail + 1) & (EDGE_QUEUE_SIZE - 1);
+    return 1;
+}
+
+/*******************************************************************************
+ * Gesture Classifier (main loop)
+ ******************************************************************************/
+
+typedef enum {
+    INPUT_CLICK,
+    INPUT_DOUBLE_CLICK,
+    INPUT_LONG_PRESS,
+    INPUT_REPEAT
+} input_type_t;
+
+typedef enum {
+    BTN_IDLE,
+    BTN_DOWN,           /* First press, waiting for release or long */
+    BTN_WAIT_SECOND,    /* Released, waiting for a second press */
+    BTN_DOWN_SECOND,    /* Double click reported, waiting for release */
+    BTN_HELD            /* Long press reported, repeating */
+} button_state_t;
+
+typedef struct {
+    uint16_t pin;           /* Port 0 pin mask */
+    uint8_t raw;            /* Last recorded level, 1 = pressed */
+    uint8_t stable;         /* Debounced level, 1 = pressed */
+    uint32_t edge_time;     /* First edge away from the stable level */
+    uint32_t last_edge;     /* Most recent edge */
+    button_state_t state;
+    uint32_t mark;          /* Press, release or next repeat time */
+} button_t;
+
+/* Callback for every gesture: button index, type, time in µs */
+typedef void (*input_handler_t)(uint8_t button, input_type_t type, uint32_t time_us);
+
+static button_t buttons[] = {
+    { .pin = (1 << 1) },    /* P0.1 - board button */
+    { .pin = (1 << 2) },    /* P0.2 - optional */
+};
+
+#define NUM_BUTTONS     (sizeof(buttons) / sizeof(buttons[0]))
+
+static input_handler_t input_handler;
+
+static inline uint8_t time_reached(uint32_t now, uint32_t deadline) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+static void input_emit(uint8_t index, input_type_t type, uint32_t time) {
+    if (input_handler) input_handler(index, type, time);
+}
+
+/* Timeouts up to t have already run, so WAIT_SECOND here means the
+ * second press is inside the double-click window */
+static void input_press(uint8_t i, button_t *b, uint32_t t) {
+    if (b->state == BTN_WAIT_SECOND) {
+        input_emit(i, INPUT_DOUBLE_CLICK, t);
+        b->state = BTN_DOWN_SECOND;
+        return;
+    }
+    b->state = BTN_DOWN;
+    b->mark = t;
+}
+
+static void input_release(button_t *b, uint32_t t) {
+    if (b->state == BTN_DOWN) {
+        b->state = BTN_WAIT_SECOND;
+        b->mark = t;
+    } else {
+        b->state = BTN_IDLE;
+    }
+}
+
+/**
+ * Fire the timed gestures that are due by 'now'
+ */
+static void input_timeouts(uint8_t i, button_t *b, uint32_t now) {
+    switch (b->state) {
+        case BTN_DOWN:
+            if (time_reached(now, b->mark + LONG_US)) {
+                input_emit(i, INPUT_LONG_PRESS, b->mark + LONG_US);
+                b->state = BTN_HELD;
+                b->mark += LONG_US + REPEAT_US;
+            }
+            break;
+        case BTN_HELD:
+            while (time_reached(now, b->mark)) {
+                input_emit(i, INPUT_REPEAT, b->mark);
+                b->mark += REPEAT_US;
+            }
+            break;
+        case BTN_WAIT_SECOND:
+            if (time_reached(now, b->mark + DOUBLE_US)) {
+                input_emit(i, INPUT_CLICK, b->mark + DOUBLE_US);
+                b->state = BTN_IDLE;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Drain the edge queue and run every button's state machine up to 'now'.
+ * Call often - at least every few tens of milliseconds.
+ */
+void input_poll(uint32_t now) {
+    edge_record_t rec;
+
+    while (edge_pop(&rec)) {
+        for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+            button_t *b = &buttons[i];
+
+            if (!(rec.pins & b->pin)) continue;
+
+            uint8_t pressed = (rec.level & b->pin) ? 0 : 1;
+            if (b->raw == b->stable && pressed != b->stable) {
+                b->edge_time = rec.time_us;
+            }
+            b->raw = pressed;
+            b->last_edge = rec.time_us;
+        }
+    }
+
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+        button_t *b = &buttons[i];
+        uint32_t until = now;
+
+        if (b->raw != b->stable) {
+            if (time_reached(now, b->last_edge + DEBOUNCE_US)) {
+                /* Stable long enough: the change happened at the first edge */
+                input_timeouts(i, b, b->edge_time);
+                b->stable = b->raw;
+                if (b->stable) input_press(i, b, b->edge_time);
+                else input_release(b, b->edge_time);
+            } else {
+                /* Change still bouncing: don't time out past its start */
+                until = b->edge_time;
+            }
+        }
+        input_timeouts(i, b, until);
+    }
+}
+
+/**
+ * Configure the button pins for both-edge interrupts and start the
+ * timestamp timer
+ */
+void input_init(input_handler_t handler) {
+    uint32_t mask = 0;
+
+    input_handler = handler;
+
+    SYSAHBCLKCTRL |= GPIO_CLK | CT32B0_CLK | IOCON_CLK;
+
+    /* 1 MHz free-running timestamp */
+    TMR32B0TCR = 0x02;
+    TMR32B0PR = (SYSTEM_CLOCK / 1000000) - 1;
+    TMR32B0TCR = 0x01;
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    IOCON_PIO0_1 = IOCON_BUTTON;
+    IOCON_PIO0_2 = IOCON_BUTTON;
+
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++) mask |= buttons[i].pin;
+
+    GPIO0DIR &= ~mask;
+    GPIO0IS &= ~mask;       /* Edge sensitive */
+    GPIO0IBE |= mask;       /* Both edges */
+    GPIO0IC = mask;
+    GPIO0IE |= mask;
+
+    NVIC_ISER1 = (1 << (PIO0_IRQn - 32));
+}
+
+uint32_t input_now(void) {
+    return TMR32B0TC;
+}
+
+/*******************************************************************************
+ * UART Functions (transmit only)
+ ******************************************************************************/
+
+void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= UART_CLK | IOCON_CLK;
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar('0');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*******************************************************************************
+ * LED Functions
+ ******************************************************************************/
+
+void led_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK | IOCON_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO3DIR |= LED_MASK;
+    GPIO3DATA |= LED_MASK;
+}
+
+void led_toggle(uint8_t led) {
+    GPIO3DATA ^= (1 << led);
+}
+
+/*******************************************************************************
+ * Application
+ ******************************************************************************/
+
+static const char *const input_names[] = {
+    "CLICK", "DOUBLE_CLICK", "LONG_PRESS", "REPEAT"
+};
+
+/**
+ * Gesture handler: log it and toggle the LED for that gesture
+ */
+void on_input(uint8_t button, input_type_t type, uint32_t time_us) {
+    print_number(time_us / 1000000, 1);
+    uart_putchar('.');
+    print_number(time_us % 1000000, 6);
+    uart_puts("  btn");
+    print_number(button, 1);
+    uart_puts("  ");
+    uart_puts(input_names[type]);
+    uart_puts("\r\n");
+
+    led_toggle(type);
+}
+
+/**
+ * SysTick Handler - only wakes the main loop for timeouts
+ */
+void SysTick_Handler(void) {
+}
+
+int main(void) {
+    uint32_t dropped = 0;
+    uint32_t isr_max = 0;
+
+    led_init();
+    uart_init(115200);
+    input_init(on_input);
+
+    SYST_RVR = (SYSTEM_CLOCK / 1000) * POLL_MS - 1;
+    SYST_CVR = 0;
+    SYST_CSR = 0x07;
+
+    uart_puts("\r\nInput Events - click, double-click or hold the button\r\n");
+
+    while (1) {
+        __asm volatile ("wfi");
+
+        input_poll(input_now());
+
+        /* Report queue health when it changes */
+        if (edge_isr_max != isr_max || edge_dropped != dropped) {
+            isr_max = edge_isr_max;
+            dropped = edge_dropped;
+            uart_puts("  isr max ");
+            print_number(isr_max, 1);
+            uart_puts(" cycles, dropped ");
+            print_number(dropped, 1);
+            uart_puts("\r\n");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,379 @@
+/**
+ * Chapter 6: Interrupts and Clocks - Quadrature Encoder Example
+ *
+ * Decodes a rotary (quadrature) encoder on two GPIO pins.
+ *
+ * Channels A and B are square waves 90° apart. Every edge of either one
+ * is a count, and which channel leads gives the direction:
+ *
+ *   A  __|‾‾‾‾‾|_____|‾‾‾‾‾|__
+ *   B  _____|‾‾‾‾‾|_____|‾‾‾‾‾|     A leads B = +1 per edge
+ *
+ * Both pins interrupt on both edges (GPIO2IBE). The handler reads A and B
+ * together, looks up (previous state, new state) in a 16-entry table and
+ * adds -1, 0 or +1 to the position without testing the direction. A
+ * jump of both channels at once (a missed edge) is counted as an error.
+ *
+ * The handler also stores the CT32B0 time of the edge (72 MHz). The main
+ * loop turns counts and edge times into a velocity that stays accurate
+ * at low speed, where counting edges per fixed interval would be coarse.
+ *
+ * Concepts demonstrated:
+ *   - Both-edge GPIO interrupts on two pins
+ *   - Table-driven state machine
+ *   - Wrap-around-safe 32-bit counters (unsigned difference)
+ *   - Velocity from edge timestamps (count / time between edges)
+ *   - Measuring handler cost to find the maximum edge rate
+ *
+ * Hardware:
+ *   - P2.0: Encoder A
+ *   - P2.1: Encoder B (encoder common to GND, internal pull-ups)
+ *   - P3.0-P3.3: LEDs show the detent count (position / 4) in binary
+ *   - P1.7: UART TXD (115200 8N1)
+ *
+ * Note: This example assumes 72 MHz system clock (PLL configured)
+ *
+ * Build: make
+ * Flash: make flash
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Register Definitions
+ ******************************************************************************/
+
+/* System Control */
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/* IOCON */
+#define IOCON_PIO2_0    (*((volatile uint32_t *)0x40044008))
+#define IOCON_PIO2_1    (*((volatile uint32_t *)0x40044028))
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))
+#define IOCON_PIO3_0    (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1    (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2    (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3    (*((volatile uint32_t *)0x400440AC))
+
+/* GPIO Port 2 (encoder) */
+#define GPIO2DIR        (*((volatile uint32_t *)0x50028000))
+#define GPIO2IS         (*((volatile uint32_t *)0x50028004))
+#define GPIO2IBE        (*((volatile uint32_t *)0x50028008))
+#define GPIO2IE         (*((volatile uint32_t *)0x50028010))
+#define GPIO2IC         (*((volatile uint32_t *)0x5002801C))
+#define GPIO2_AB        (*((volatile uint32_t *)0x5002000C))  /* Masked: P2.0-P2.1 only */
+
+/* GPIO Port 3 (LEDs) */
+#define GPIO3DIR        (*((volatile uint32_t *)0x50038000))
+#define GPIO3_LEDS      (*((volatile uint32_t *)0x5003003C))  /* Masked: P3.0-P3.3 only */
+
+/* CT32B0 (edge timestamps) */
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0TC       (*((volatile uint32_t *)0x40014008))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+
+/* UART Registers */
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/* SysTick Registers */
+#define SYST_CSR        (*((volatile uint32_t *)0xE000E010))
+#define SYST_RVR        (*((volatile uint32_t *)0xE000E014))
+#define SYST_CVR        (*((volatile uint32_t *)0xE000E018))
+
+/* NVIC */
+#define NVIC_ISER1      (*((volatile uint32_t *)0xE000E104))  /* Enables IRQ 32-63 */
+
+/* Debug and Trace (ARM Cortex-M3 core) */
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+#define GPIO_CLK        (1 << 6)
+#define CT32B0_CLK      (1 << 9)
+#define UART_CLK        (1 << 12)
+#define IOCON_CLK       (1 << 16)
+
+#define LED_MASK        0x0F
+#define ENC_PINS        0x03     /* P2.0 = A, P2.1 = B */
+#define PIO2_IRQn       54
+
+#define SYSTEM_CLOCK    72000000UL
+
+/* DWT enable bits */
+#define DEMCR_TRCENA        (1 << 24)
+#define DWT_CTRL_CYCCNTENA  (1 << 0)
+
+#define LSR_THRE        (1 << 5)
+
+/* IOCON: GPIO function, pull-up, hysteresis */
+#define IOCON_ENC       ((0x02 << 3) | (0x01 << 5))
+
+/* Encoder: pulses per revolution per channel; 4 counts per pulse */
+#define ENCODER_PPR     24
+#define ENCODER_CPR     (ENCODER_PPR * 4)
+
+/* Velocity: sample every 50 ms, report 0 after 500 ms without edges */
+#define SAMPLE_MS       50
+#define VEL_TIMEOUT     (SYSTEM_CLOCK / 2)
+
+/* Cortex-M3 exception entry + exit, added to the measured handler body */
+#define IRQ_OVERHEAD_CYCLES  24
+
+/*******************************************************************************
+ * Quadrature Decoder
+ ******************************************************************************/
+
+/*
+ * Index = (previous << 2) | current, state = (B << 1) | A.
+ * Forward (A leads B) is 0 -> 1 -> 3 -> 2 -> 0.
+ */
+static const int8_t quad_table[16] = {
+/* cur:  0   1   2   3         prev */
+         0, +1, -1,  0,     /* 0 */
+        -1,  0,  0, +1,     /* 1 */
+        +1,  0,  0, -1,     /* 2 */
+         0, -1, +1,  0,     /* 3 */
+};
+
+/* Bit n set = index n is a double step (both channels changed) */
+#define QUAD_ERROR_MASK 0x1248     /* Indices 3, 6, 9, 12 */
+
+typedef struct {
+    uint32_t count;         /* Position; wraps, compare with differences */
+    uint32_t edge_time;     /* CT32B0 time of the last counted edge */
+    uint32_t errors;        /* Double steps (missed edges) */
+    uint8_t state;
+} encoder_t;
+
+static volatile encoder_t enc;
+
+volatile uint32_t enc_isr_cycles = 0;    /* Longest handler body */
+
+/**
+ * GPIO Port 2 Handler - one table lookup per edge
+ */
+void PIO2_IRQHandler(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    uint32_t time = TMR32B0TC;
+
+    GPIO2IC = ENC_PINS;
+    uint32_t state = GPIO2_AB;
+    uint32_t index = (enc.state << 2) | state;
+
+    enc.count += quad_table[index];
+    enc.errors += (QUAD_ERROR_MASK >> index) & 1;
+    if (state != enc.state) enc.edge_time = time;
+    enc.state = state;
+
+    uint32_t cycles = DWT_CYCCNT - t0;
+    if (cycles > enc_isr_cycles) enc_isr_cycles = cycles;
+}
+
+void encoder_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK | CT32B0_CLK | IOCON_CLK;
+
+    /* Free-running 72 MHz timestamp */
+    TMR32B0TCR = 0x02;
+    TMR32B0PR = 0;
+    TMR32B0TCR = 0x01;
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    IOCON_PIO2_0 = IOCON_ENC;
+    IOCON_PIO2_1 = IOCON_ENC;
+
+    GPIO2DIR &= ~ENC_PINS;
+    GPIO2IS &= ~ENC_PINS;     /* Edge sensitive */
+    GPIO2IBE |= ENC_PINS;     /* Both edges */
+
+    enc.state = GPIO2_AB;
+    enc.edge_time = TMR32B0TC;
+
+    GPIO2IC = ENC_PINS;
+    GPIO2IE |= ENC_PINS;
+    NVIC_ISER1 = (1 << (PIO2_IRQn - 32));
+}
+
+/**
+ * Take a consistent copy of count and edge time
+ */
+static void encoder_snapshot(uint32_t *count, uint32_t *edge_time) {
+    __asm volatile ("cpsid i" ::: "memory");
+    *count = enc.count;
+    *edge_time = enc.edge_time;
+    __asm volatile ("cpsie i" ::: "memory");
+}
+
+int32_t encoder_position(void) {
+    return (int32_t)enc.count;
+}
+
+/*******************************************************************************
+ * Velocity Estimate
+ ******************************************************************************/
+
+static uint32_t vel_count;
+static uint32_t vel_time;
+static int32_t velocity = 0;     /* Counts per second */
+
+/**
+ * Called every SAMPLE_MS. Divides the counts since the last sample by
+ * the time between the last edges of the two samples, not by SAMPLE_MS -
+ * so a single count over 30 ms gives 33 counts/s, not 20.
+ */
+void velocity_update(void) {
+    uint32_t count, edge_time;
+
+    encoder_snapshot(&count, &edge_time);
+
+    int32_t counts = (int32_t)(count - vel_count);
+    uint32_t dt = edge_time - vel_time;
+
+    if (counts != 0 && dt != 0) {
+        velocity = (int32_t)(((int64_t)counts * SYSTEM_CLOCK) / dt);
+        vel_count = count;
+        vel_time = edge_time;
+        return;
+    }
+
+    /* No new edges: the speed can be at most one count per time since
+     * the last edge, so shrink toward 0 */
+    uint32_t since = TMR32B0TC - vel_time;
+    if (since >= VEL_TIMEOUT) {
+        velocity = 0;
+        vel_time = TMR32B0TC - VEL_TIMEOUT;   /* Keep 'since' from wrapping */
+    } else {
+        int32_t bound = (int32_t)(SYSTEM_CLOCK / since);
+        if (velocity > bound) velocity = bound;
+        if (velocity < -bound) velocity = -bound;
+    }
+}
+
+/*******************************************************************************
+ * UART Functions (transmit only)
+ ******************************************************************************/
+
+void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= UART_CLK | IOCON_CLK;
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+void print_int(int32_t value) {
+    char temp[12];
+    int j = 0;
+    uint32_t n = (value < 0) ? -(uint32_t)value : (uint32_t)value;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    if (value < 0) uart_putchar('-');
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*******************************************************************************
+ * LED Functions
+ ******************************************************************************/
+
+void led_init(void) {
+    SYSAHBCLKCTRL |= GPIO_CLK | IOCON_CLK;
+
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO3_LEDS = LED_MASK;
+    GPIO3DIR |= LED_MASK;
+}
+
+/*******************************************************************************
+ * Main Program
+ ******************************************************************************/
+
+volatile uint32_t sample_due = 0;
+
+/**
+ * SysTick Handler - velocity sample clock
+ */
+void SysTick_Handler(void) {
+    sample_due = 1;
+}
+
+int main(void) {
+    uint32_t ticks = 0;
+
+    led_init();
+    uart_init(115200);
+    encoder_init();
+
+    SYST_RVR = (SYSTEM_CLOCK / 1000) * SAMPLE_MS - 1;
+    SYST_CVR = 0;
+    SYST_CSR = 0x07;
+
+    uart_puts("\r\nQuadrature Encoder\r\n");
+
+    while (1) {
+        __asm volatile ("wfi");
+        if (!sample_due) continue;
+        sample_due = 0;
+
+        velocity_update();
+
+        int32_t pos = encoder_position();
+        GPIO3_LEDS = ~(pos >> 2);            /* Detents, active-low */
+
+        /* Print every 500 ms */
+        if (++ticks < 10) continue;
+        ticks = 0;
+
+        uint32_t isr = enc_isr_cycles + IRQ_OVERHEAD_CYCLES;
+
+        uart_puts("pos ");
+        print_int(pos);
+        uart_puts("  vel ");
+        print_int(velocity);
+        uart_puts(" cnt/s  ");
+        print_int((velocity * 60) / ENCODER_CPR);
+        uart_puts(" rpm  err ");
+        print_int(enc.errors);
+        uart_puts("  isr ");
+        print_int(isr);
+        uart_puts(" cyc (max ");
+        print_int(SYSTEM_CLOCK / isr);
+        uart_puts(" edges/s)\r\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,456 @@
+/**************************************************
+ * LPC1343 ADC Example: AC Metrics (RMS / Peak)
+ * Chapter 7: Analog to Digital Conversion
+ *
+ * Measures an AC current with a current
+ * transformer: mean, RMS, peak, crest factor and
+ * (apparent) energy over a configurable window.
+ *
+ * The ADC interrupt is the one of ADC-Interrupt,
+ * extended by a few accumulators. Per sample it
+ * only adds:
+ *
+ *   sum    += x         (32 bit)
+ *   sumsq  += x * x     (64 bit: ADDS + ADC)
+ *   min, max
+ *
+ * Samples are never stored. At the end of each
+ * window the ISR publishes the accumulators as a
+ * snapshot (double-buffered with a sequence
+ * number, as in ADC-Multi-Channel) and starts
+ * again. The main loop turns a snapshot into
+ * results with exact integer maths:
+ *
+ *   N^2 * variance = N * sumsq - sum^2
+ *   RMS (AC part)  = sqrt(N * sumsq - sum^2) / N
+ *
+ * which removes the DC bias of the CT circuit
+ * without knowing it in advance.
+ *
+ * At 10 kHz the ISR has 7200 cycles per sample.
+ * It measures itself with the DWT cycle counter
+ * and the budget is printed with every result.
+ *
+ * Hardware (CT, e.g. SCT-013-030, 30 A / 1 V):
+ *
+ *   3.3V ──[10K]──┬──[10K]── GND     bias 1.65 V
+ *                 ├── 10uF ── GND
+ *                 │
+ *                CT (burden inside)
+ *                 │
+ *                 └──────────► P0.11 (AD0)
+ *
+ *   UART TXD → P1.7 (115200 8N1) - results
+ *   LED: P0.7 (onboard, active low) - windows
+ *
+ * Key Concepts:
+ *   - Streaming statistics, no sample buffer
+ *   - 64-bit sum of squares on a 32-bit CPU
+ *   - DC removal from sum and sum of squares
+ *   - Windows of whole mains cycles
+ *   - Cycle budget per sample
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_R_PIO0_11 (*((volatile uint32_t *)0x40044074))  /* AD0 */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+
+/*--------------------------------------------------
+ * 32-bit Timer 0 (CT32B0) Registers
+ *------------------------------------------------*/
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR      (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0      (*((volatile uint32_t *)0x40014018))
+#define TMR32B0EMR      (*((volatile uint32_t *)0x4001403C))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR0          (*((volatile uint32_t *)0x4001C010))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * Core Registers (NVIC, DWT)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define LED_PIN         7
+#define ADC_IRQn        49      /* ADC interrupt number */
+
+#define ADC_OVERRUN     (1UL << 30)
+#define ADC_CLKDIV      15      /* 4.5 MHz */
+#define ADC_START_CT32B0_MAT0   (4 << 24)
+
+#define ADC_SAMPLE_RATE_HZ  10000
+#define SAMPLE_HALF_PERIOD  (SYSTEM_CLOCK / (2 * ADC_SAMPLE_RATE_HZ))
+#define CYCLES_PER_SAMPLE   (SYSTEM_CLOCK / ADC_SAMPLE_RATE_HZ)
+
+#if (SYSTEM_CLOCK / ADC_SAMPLE_RATE_HZ) % (2 * (ADC_CLKDIV + 1)) != 0
+#error "Sample period must be a multiple of two ADC clocks for zero jitter"
+#endif
+
+/* Window length in samples. Use whole mains
+ * cycles, or the RMS ripples with the phase at
+ * which a window starts: 2000 samples = 10 cycles
+ * at 50 Hz, 12 cycles at 60 Hz. At most 65535. */
+#define AC_WINDOW_DEFAULT   2000
+
+/* Scaling: ADC counts → current. SCT-013-030
+ * gives 1 V rms at 30 A; one count is
+ * 3.3 V / 1024 = 3.223 mV = 96.68 mA. */
+#define CT_UA_PER_COUNT     96680
+
+/* For the energy estimate (apparent power = V x I) */
+#define MAINS_VOLTS_RMS     230
+
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Window Accumulators
+ *
+ * ac_acc belongs to the ISR. Completed windows are
+ * published in ac_buf[seq & 1]: the ISR writes
+ * window seq + 1 into the other buffer while a
+ * reader copies window seq.
+ *------------------------------------------------*/
+typedef struct {
+    uint32_t count;             /* Samples */
+    uint32_t sum;               /* Sum of x */
+    uint64_t sumsq;             /* Sum of x^2 */
+    uint16_t min, max;
+} ac_window_t;
+
+static ac_window_t ac_acc = { 0, 0, 0, 0x3FF, 0 };
+static ac_window_t ac_buf[2];
+static volatile uint32_t ac_seq = 0;
+
+static volatile uint32_t ac_window = AC_WINDOW_DEFAULT;
+
+volatile uint32_t adc_overruns = 0;   /* ISR too late, sample lost */
+
+/* ISR cycle counts, for the budget */
+volatile uint32_t isr_cycles_max = 0;
+volatile uint32_t isr_cycles_sum = 0;
+volatile uint32_t isr_calls = 0;
+
+/*--------------------------------------------------
+ * ADC Interrupt Handler
+ *
+ * One call per conversion. Reading AD0DR0 clears
+ * its DONE flag and the interrupt.
+ *------------------------------------------------*/
+void ADC_IRQHandler(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    uint32_t data = AD0DR0;
+    uint32_t x = (data >> 6) & 0x3FF;
+
+    if (data & ADC_OVERRUN) adc_overruns++;
+
+    ac_acc.sum += x;
+    ac_acc.sumsq += x * x;
+    if (x < ac_acc.min) ac_acc.min = x;
+    if (x > ac_acc.max) ac_acc.max = x;
+
+    if (++ac_acc.count >= ac_window) {
+        /* Publish into the buffer readers are not using */
+        uint32_t next = ac_seq + 1;
+
+        ac_buf[next & 1] = ac_acc;
+
+        __asm volatile ("" ::: "memory");
+        ac_seq = next;
+
+        ac_acc.count = 0;
+        ac_acc.sum = 0;
+        ac_acc.sumsq = 0;
+        ac_acc.min = 0x3FF;
+        ac_acc.max = 0;
+    }
+
+    uint32_t cycles = DWT_CYCCNT - t0;
+    isr_cycles_sum += cycles;
+    isr_calls++;
+    if (cycles > isr_cycles_max) isr_cycles_max = cycles;
+}
+
+/*--------------------------------------------------
+ * Start Sampling at ADC_SAMPLE_RATE_HZ
+ *------------------------------------------------*/
+static void adc_sampling_start(void) {
+    /* Enable ADC and CT32B0 clocks, power up ADC */
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 9) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    IOCON_R_PIO0_11 = 0x02;             /* AD0, analog mode */
+
+    AD0CR = (1 << 0)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;      /* Rising MAT0 edge */
+    AD0INTEN = (1 << 0);
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    TMR32B0TCR = 0x02;                  /* Reset */
+    TMR32B0PR = 0;
+    TMR32B0MR0 = SAMPLE_HALF_PERIOD - 1;
+    TMR32B0MCR = (1 << 1);              /* MR0R: reset on MR0 */
+    TMR32B0EMR = (3 << 4);              /* EMC0 = toggle, EM0 = 0 */
+    TMR32B0TCR = 0x01;                  /* Start */
+}
+
+/*--------------------------------------------------
+ * Change the Window Length
+ *
+ * Takes effect with the window being summed now.
+ *------------------------------------------------*/
+static void ac_set_window(uint16_t samples) {
+    ac_window = samples ? samples : 1;
+}
+
+/*--------------------------------------------------
+ * Copy the Latest Complete Window
+ *
+ * Returns its sequence number; 0 means no window
+ * has finished yet.
+ *------------------------------------------------*/
+static uint32_t ac_read(ac_window_t *w) {
+    uint32_t seq;
+
+    do {
+        seq = ac_seq;
+        __asm volatile ("" ::: "memory");
+
+        *w = ac_buf[seq & 1];
+
+        __asm volatile ("" ::: "memory");
+    } while (ac_seq - seq > 1);        /* Buffer reused meanwhile */
+
+    return seq;
+}
+
+/*--------------------------------------------------
+ * Results of One Window
+ *------------------------------------------------*/
+typedef struct {
+    uint32_t mean_16;           /* Counts, x16 */
+    uint32_t rms_16;            /* AC part, counts x16 */
+    uint32_t peak_16;           /* Largest |x - mean|, x16 */
+    uint32_t rms_ma;            /* AC part, mA */
+    uint32_t peak_ma;
+    uint32_t crest_100;         /* Peak / RMS, x100 */
+    uint32_t energy_mj;         /* V x I x t, mJ */
+} ac_metrics_t;
+
+static uint32_t isqrt64(uint64_t x) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > x) bit >>= 2;
+
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static void ac_compute(const ac_window_t *w, ac_metrics_t *m) {
+    uint64_t n = w->count;
+
+    /* N^2 * variance, exact: N * sumsq >= sum^2 */
+    uint64_t var_n2 = n * w->sumsq - (uint64_t)w->sum * w->sum;
+
+    /* x16 resolution: sqrt(256 * var * N^2) / N */
+    m->rms_16 = isqrt64(var_n2 << 8) / w->count;
+    m->mean_16 = (uint32_t)((((uint64_t)w->sum << 4) + n / 2) / n);
+
+    uint32_t up = ((uint32_t)w->max << 4) - m->mean_16;
+    uint32_t down = m->mean_16 - ((uint32_t)w->min << 4);
+    m->peak_16 = (up > down) ? up : down;
+
+    m->rms_ma = (uint32_t)(((uint64_t)m->rms_16 * CT_UA_PER_COUNT + 8000) / 16000);
+    m->peak_ma = (uint32_t)(((uint64_t)m->peak_16 * CT_UA_PER_COUNT + 8000) / 16000);
+    m->crest_100 = m->rms_16 ? (m->peak_16 * 100 + m->rms_16 / 2) / m->rms_16 : 0;
+
+    /* mJ = V * mA * samples / fs */
+    m->energy_mj = (uint32_t)((uint64_t)MAINS_VOLTS_RMS * m->rms_ma * w->count
+                              / ADC_SAMPLE_RATE_HZ);
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/* value / divisor with 'decimals' digits (1-3) */
+static void print_decimal(uint32_t value, uint32_t divisor, uint8_t decimals,
+                          uint8_t width) {
+    uint32_t frac = value % divisor;
+    uint32_t digits = 1;
+
+    for (uint8_t i = 0; i < decimals; i++) digits *= 10;
+    frac = (frac * digits + divisor / 2) / divisor;
+
+    uint32_t whole = value / divisor;
+    if (frac == digits) {
+        whole++;
+        frac = 0;
+    }
+
+    print_number(whole, width);
+    uart_putchar('.');
+    for (uint32_t d = digits / 10; d > 0; d /= 10) {
+        print_number(frac / d % 10, 1);
+    }
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    ac_window_t w;
+    ac_metrics_t m;
+    uint32_t last_seq = 0;
+    uint64_t energy_mj = 0;
+    uint32_t last_cycles = 0, last_calls = 0;
+
+    /* Enable GPIO clock */
+    SYSAHBCLKCTRL |= (1 << 6);
+
+    GPIO0DIR |= (1 << LED_PIN);
+
+    DEMCR |= (1 << 24);                 /* TRCENA */
+    DWT_CTRL |= (1 << 0);               /* CYCCNTENA */
+
+    uart_init(115200);
+    uart_puts("\r\nAC Metrics: 10 kHz, window ");
+    print_number(AC_WINDOW_DEFAULT, 0);
+    uart_puts(" samples\r\n");
+    uart_puts("  mean     rms    peak  crest   I rms A  I peak A"
+              "   energy Wh  isr avg/max of ");
+    print_number(CYCLES_PER_SAMPLE, 0);
+    uart_puts(" cycles\r\n");
+
+    ac_set_window(AC_WINDOW_DEFAULT);
+    adc_sampling_start();
+
+    while (1) {
+        /* Sleep until the next window is published */
+        while (ac_seq == last_seq) {
+            __asm volatile ("wfi");
+        }
+
+        uint32_t seq = ac_read(&w);
+        if (seq - last_seq > 1) {
+            uart_puts("  (windows skipped)\r\n");
+        }
+        last_seq = seq;
+
+        ac_compute(&w, &m);
+        energy_mj += m.energy_mj;
+
+        GPIO0DATA ^= (1 << LED_PIN);
+
+        print_decimal(m.mean_16, 16, 1, 6);
+        print_decimal(m.rms_16, 16, 2, 6);
+        print_decimal(m.peak_16, 16, 2, 6);
+        print_decimal(m.crest_100, 100, 2, 4);
+        print_decimal(m.rms_ma, 1000, 3, 7);
+        print_decimal(m.peak_ma, 1000, 3, 7);
+        print_decimal((uint32_t)(energy_mj / 3600), 1000, 3, 9);
+        /* Average over the last window(s) */
+        uint32_t cycles = isr_cycles_sum, calls = isr_calls;
+        print_number((cycles - last_cycles) / (calls - last_calls), 8);
+        last_cycles = cycles;
+        last_calls = calls;
+        uart_putchar('/');
+        print_number(isr_cycles_max, 0);
+        if (adc_overruns) {
+            uart_puts("  overruns ");
+            print_number(adc_overruns, 0);
+        }
+        uart_puts("\r\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,585 @@
+/**************************************************
+ * LPC1343 ADC Example: Calibration and Linearization
+ * Chapter 7: Analog to Digital Conversion
+ *
+ * The other ADC examples use raw counts and treat
+ * 0-1023 as an exact 0-3.3 V. Real parts have an
+ * offset and a gain error of a few counts, and
+ * many sensors are not linear at all.
+ *
+ * Two-point calibration, per channel: apply two
+ * known voltages, read the raw counts, and
+ * compute the straight line through both points:
+ *
+ *   ideal = (raw * gain + offset) >> 16
+ *
+ * gain and offset are Q16, so the ISR corrects
+ * each sample with one multiply-add and a shift.
+ * The coefficients are kept in the last internal
+ * flash sector (written through the IAP ROM
+ * routines) and loaded at start-up.
+ *
+ * Linearization: a 17-point piecewise-linear
+ * table turns the corrected count into the
+ * sensor's unit - here an NTC thermistor into
+ * 0.1 degC. Also one multiply and a shift.
+ *
+ * Commands (UART, 115200 8N1):
+ *   0 / 1  select channel
+ *   l      measure the LOW reference  (CAL_LOW_MV)
+ *   h      measure the HIGH reference (CAL_HIGH_MV)
+ *   s      save coefficients to flash
+ *   r      reset channel to "no correction"
+ *
+ * Hardware:
+ *   AD0 (P0.11): voltage to measure / calibrate.
+ *     For calibration connect 0.5 V and 2.5 V
+ *     (e.g. TL431 reference + divider)
+ *   AD1 (P1.0): NTC 10K (B 3950) to GND,
+ *     10K from 3.3 V
+ *   UART TXD → P1.7, RXD → P1.6
+ *   LED: P0.7 (onboard, active low) - calibrated
+ *
+ * Note: This example assumes 72 MHz system clock.
+ * Its linker script keeps flash sector 7 and the
+ * top 32 bytes of RAM (used by IAP) free.
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_R_PIO0_11 (*((volatile uint32_t *)0x40044074))  /* AD0 */
+#define IOCON_R_PIO1_0  (*((volatile uint32_t *)0x40044078))  /* AD1 */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+
+/*--------------------------------------------------
+ * 32-bit Timer 0 (CT32B0) Registers
+ *------------------------------------------------*/
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR      (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0      (*((volatile uint32_t *)0x40014018))
+#define TMR32B0EMR      (*((volatile uint32_t *)0x4001403C))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR(n)        (*((volatile uint32_t *)(0x4001C010 + 4 * (n))))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0RBR           (*((volatile uint32_t *)0x40008000))
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * Core Registers (NVIC, DWT)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*--------------------------------------------------
+ * IAP (In-Application Programming) ROM Routines
+ *------------------------------------------------*/
+#define IAP_LOCATION    0x1FFF1FF1
+#define IAP_PREPARE     50      /* Unlock sectors */
+#define IAP_COPY_RAM    51      /* RAM → flash, 256 B minimum */
+#define IAP_ERASE       52
+#define IAP_SUCCESS     0
+#define IAP_CCLK_KHZ    72000
+
+typedef void (*iap_entry_t)(uint32_t *command, uint32_t *result);
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define LED_PIN         7
+#define ADC_IRQn        49      /* ADC interrupt number */
+
+#define ADC_CLKDIV      15      /* 4.5 MHz */
+#define ADC_START_CT32B0_MAT0   (4 << 24)
+
+#define ADC_CHANNELS    2       /* AD0, AD1, in turn */
+
+/* 1000 conversions/s, 500 per channel */
+#define CONVERSION_RATE_HZ  1000
+#define SAMPLE_HALF_PERIOD  (SYSTEM_CLOCK / (2 * CONVERSION_RATE_HZ))
+
+#if (SYSTEM_CLOCK / CONVERSION_RATE_HZ) % (2 * (ADC_CLKDIV + 1)) != 0
+#error "Sample period must be a multiple of two ADC clocks for zero jitter"
+#endif
+
+/* Reference voltages for the two points */
+#define ADC_VREF_MV     3300
+#define CAL_LOW_MV      500
+#define CAL_HIGH_MV     2500
+#define CAL_SAMPLES     256     /* Averaged per point */
+
+/* Calibration record: last sector of the 32 KB */
+#define CAL_SECTOR      7
+#define CAL_ADDR        0x00007000
+#define CAL_MAGIC       0x43414C31  /* "CAL1" */
+
+#define LSR_RDR         (1 << 0)
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Calibration Record
+ *
+ * ideal = (raw * gain + offset) >> 16
+ *
+ * Identity: gain = 1 << 16, offset = 1 << 15 (the
+ * rounding half). Stored as one 256-byte block,
+ * the smallest unit IAP can write.
+ *------------------------------------------------*/
+typedef struct {
+    int32_t gain;               /* Q16 */
+    int32_t offset;             /* Q16, includes rounding */
+} adc_cal_t;
+
+typedef struct {
+    uint32_t magic;
+    adc_cal_t cal[ADC_CHANNELS];
+    uint32_t checksum;          /* Sum of the words above, negated */
+    uint32_t pad[64 - 2 - 2 * ADC_CHANNELS];
+} cal_record_t;
+
+static adc_cal_t adc_cal[ADC_CHANNELS];
+
+/*--------------------------------------------------
+ * Linearization Table
+ *
+ * 17 points, one every 64 counts (0, 64 ... 1024).
+ * NTC 10K, B = 3950, to GND with 10K from 3.3 V:
+ * temperature in 0.1 degC, clamped to -40..125.
+ *------------------------------------------------*/
+#define LIN_POINTS      17
+#define LIN_SHIFT       6       /* 64 counts per segment */
+
+typedef int16_t lin_table_t[LIN_POINTS];
+
+static const lin_table_t ntc_table = {
+    1250, 1016,  763,  621,  520,  439,  370,  308,
+     250,  194,  139,   83,   22,  -47, -132, -256,
+    -400,
+};
+
+/* Linearization per channel (0 = none) */
+static const int16_t *const adc_lin[ADC_CHANNELS] = {
+    0,
+    ntc_table,
+};
+
+static inline int32_t lin_lookup(const int16_t *table, uint32_t code) {
+    uint32_t i = code >> LIN_SHIFT;
+    int32_t frac = code & ((1 << LIN_SHIFT) - 1);
+    int32_t y0 = table[i];
+
+    return y0 + (((table[i + 1] - y0) * frac) >> LIN_SHIFT);
+}
+
+/*--------------------------------------------------
+ * ADC Results (written by the ISR)
+ *------------------------------------------------*/
+volatile uint16_t adc_raw[ADC_CHANNELS];      /* Counts as read */
+volatile uint16_t adc_value[ADC_CHANNELS];    /* Calibrated counts */
+volatile int32_t adc_unit[ADC_CHANNELS];      /* Linearized */
+volatile uint32_t adc_samples[ADC_CHANNELS];  /* Conversions */
+volatile uint32_t isr_cycles_max = 0;
+
+static uint8_t adc_channel = 0;               /* Being converted */
+
+/*--------------------------------------------------
+ * ADC Interrupt Handler
+ *
+ * One call per conversion; then the next channel
+ * is selected for the next MAT0 edge.
+ *------------------------------------------------*/
+void ADC_IRQHandler(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    uint8_t ch = adc_channel;
+    int32_t raw = (AD0DR(ch) >> 6) & 0x3FF;
+
+    adc_channel = (ch + 1 < ADC_CHANNELS) ? ch + 1 : 0;
+    AD0CR = (1 << adc_channel)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;
+    AD0INTEN = (1 << adc_channel);
+
+    /* Offset and gain: one multiply-add, one shift */
+    int32_t value = (raw * adc_cal[ch].gain + adc_cal[ch].offset) >> 16;
+
+    if (value < 0) value = 0;
+    if (value > 1023) value = 1023;
+
+    adc_raw[ch] = raw;
+    adc_value[ch] = value;
+    if (adc_lin[ch]) adc_unit[ch] = lin_lookup(adc_lin[ch], value);
+    adc_samples[ch]++;
+
+    uint32_t cycles = DWT_CYCCNT - t0;
+    if (cycles > isr_cycles_max) isr_cycles_max = cycles;
+}
+
+/*--------------------------------------------------
+ * Start the Timer-Triggered Conversions
+ *------------------------------------------------*/
+static void adc_start(void) {
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 9) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    IOCON_R_PIO0_11 = 0x02;             /* AD0, analog mode */
+    IOCON_R_PIO1_0 = 0x02;              /* AD1, analog mode */
+
+    adc_channel = 0;
+    AD0CR = (1 << 0)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;      /* Rising MAT0 edge */
+    AD0INTEN = (1 << 0);
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    TMR32B0TCR = 0x02;                  /* Reset */
+    TMR32B0PR = 0;
+    TMR32B0MR0 = SAMPLE_HALF_PERIOD - 1;
+    TMR32B0MCR = (1 << 1);              /* MR0R: reset on MR0 */
+    TMR32B0EMR = (3 << 4);              /* EMC0 = toggle, EM0 = 0 */
+    TMR32B0TCR = 0x01;                  /* Start */
+}
+
+/*--------------------------------------------------
+ * Two-Point Calibration
+ *------------------------------------------------*/
+static void cal_identity(adc_cal_t *c) {
+    c->gain = 1L << 16;
+    c->offset = 1L << 15;
+}
+
+/* Gain and offset must change together for the ISR */
+static void cal_set(uint8_t ch, const adc_cal_t *c) {
+    __asm volatile ("cpsid i" ::: "memory");
+    adc_cal[ch] = *c;
+    __asm volatile ("cpsie i" ::: "memory");
+}
+
+/* Ideal count of a voltage, x16 */
+static int32_t mv_to_count16(int32_t mv) {
+    return (mv * 1024 * 16 + ADC_VREF_MV / 2) / ADC_VREF_MV;
+}
+
+/* Average raw count of a channel, x16 */
+static int32_t measure_raw16(uint8_t ch) {
+    uint32_t sum = 0;
+
+    for (uint32_t n = 0; n < CAL_SAMPLES; n++) {
+        uint32_t count = adc_samples[ch];
+
+        while (adc_samples[ch] == count);   /* Next conversion */
+        sum += adc_raw[ch];
+    }
+    return (int32_t)((sum * 16 + CAL_SAMPLES / 2) / CAL_SAMPLES);
+}
+
+/*
+ * Straight line through (raw_lo, ideal_lo) and
+ * (raw_hi, ideal_hi), all x16:
+ *
+ *   gain   = (ideal_hi - ideal_lo) / (raw_hi - raw_lo)
+ *   offset = ideal_lo - gain * raw_lo
+ */
+static uint8_t cal_compute(adc_cal_t *c, int32_t raw_lo, int32_t raw_hi) {
+    int32_t ideal_lo = mv_to_count16(CAL_LOW_MV);
+    int32_t ideal_hi = mv_to_count16(CAL_HIGH_MV);
+
+    if (raw_hi - raw_lo < 16 * 64) return 0;   /* Points too close */
+
+    int64_t gain = ((int64_t)(ideal_hi - ideal_lo) << 16) / (raw_hi - raw_lo);
+    int64_t offset = ((int64_t)ideal_lo << 16) - gain * raw_lo;
+
+    c->gain = (int32_t)gain;
+    c->offset = (int32_t)(offset / 16) + (1L << 15);
+    return 1;
+}
+
+/*--------------------------------------------------
+ * Calibration Record in Flash
+ *------------------------------------------------*/
+static uint32_t record_checksum(const cal_record_t *r) {
+    const uint32_t *w = (const uint32_t *)r;
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < 1 + 2 * ADC_CHANNELS; i++) sum += w[i];
+    return ~sum + 1;
+}
+
+static uint8_t cal_load(void) {
+    const cal_record_t *r = (const cal_record_t *)CAL_ADDR;
+
+    if (r->magic != CAL_MAGIC) return 0;
+    if (r->checksum != record_checksum(r)) return 0;
+
+    for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+        adc_cal[ch] = r->cal[ch];
+    }
+    return 1;
+}
+
+/*
+ * Erase sector 7 and write the record. Flash can
+ * not be read while it is programmed, and the
+ * vector table is in flash, so interrupts are off
+ * during each IAP call (erase: up to ~100 ms).
+ */
+static uint32_t iap_call(uint32_t *command) {
+    uint32_t result[5];
+
+    __asm volatile ("cpsid i" ::: "memory");
+    ((iap_entry_t)IAP_LOCATION)(command, result);
+    __asm volatile ("cpsie i" ::: "memory");
+
+    return result[0];
+}
+
+static uint8_t cal_save(void) {
+    static cal_record_t record __attribute__((aligned(4)));
+    uint32_t cmd[5];
+
+    record.magic = CAL_MAGIC;
+    for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+        record.cal[ch] = adc_cal[ch];
+    }
+    record.checksum = record_checksum(&record);
+
+    cmd[0] = IAP_PREPARE; cmd[1] = CAL_SECTOR; cmd[2] = CAL_SECTOR;
+    if (iap_call(cmd) != IAP_SUCCESS) return 0;
+
+    cmd[0] = IAP_ERASE; cmd[1] = CAL_SECTOR; cmd[2] = CAL_SECTOR;
+    cmd[3] = IAP_CCLK_KHZ;
+    if (iap_call(cmd) != IAP_SUCCESS) return 0;
+
+    cmd[0] = IAP_PREPARE; cmd[1] = CAL_SECTOR; cmd[2] = CAL_SECTOR;
+    if (iap_call(cmd) != IAP_SUCCESS) return 0;
+
+    cmd[0] = IAP_COPY_RAM;
+    cmd[1] = CAL_ADDR;
+    cmd[2] = (uint32_t)&record;
+    cmd[3] = sizeof(record);
+    cmd[4] = IAP_CCLK_KHZ;
+    if (iap_call(cmd) != IAP_SUCCESS) return 0;
+
+    return cal_load();                  /* Read back */
+}
+
+/*--------------------------------------------------
+ * UART
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+/* Returns -1 if nothing was received */
+static int uart_getchar(void) {
+    if (!(U0LSR & LSR_RDR)) return -1;
+    return U0RBR & 0xFF;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/* n / 10 with one decimal, signed */
+static void print_tenths(int32_t n) {
+    if (n < 0) {
+        uart_putchar('-');
+        n = -n;
+    }
+    print_number(n / 10, 0);
+    uart_putchar('.');
+    print_number(n % 10, 1);
+}
+
+/* Q16 as x.xxxx */
+static void print_q16(int32_t q) {
+    if (q < 0) {
+        uart_putchar('-');
+        q = -q;
+    }
+    print_number(q >> 16, 0);
+    uart_putchar('.');
+    print_number((uint32_t)(((q & 0xFFFF) * 10000UL + 32768) >> 16), 4);
+}
+
+static void print_cal(uint8_t ch) {
+    uart_puts("AD");
+    print_number(ch, 0);
+    uart_puts(": gain ");
+    print_q16(adc_cal[ch].gain);
+    uart_puts("  offset ");
+    print_q16(adc_cal[ch].offset - (1L << 15));
+    uart_puts(" counts\r\n");
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    uint8_t ch = 0;
+    int32_t raw_lo = -1, raw_hi = -1;
+    uint32_t last_print = 0;
+
+    /* Enable GPIO clock */
+    SYSAHBCLKCTRL |= (1 << 6);
+
+    GPIO0DIR |= (1 << LED_PIN);
+    GPIO0DATA |= (1 << LED_PIN);
+
+    DEMCR |= (1 << 24);                 /* TRCENA */
+    DWT_CTRL |= (1 << 0);               /* CYCCNTENA */
+
+    uart_init(115200);
+    uart_puts("\r\nADC Calibration\r\n");
+
+    for (uint8_t i = 0; i < ADC_CHANNELS; i++) cal_identity(&adc_cal[i]);
+
+    if (cal_load()) {
+        uart_puts("Calibration loaded from flash\r\n");
+        GPIO0DATA &= ~(1 << LED_PIN);
+    } else {
+        uart_puts("No calibration in flash, using raw counts\r\n");
+    }
+    for (uint8_t i = 0; i < ADC_CHANNELS; i++) print_cal(i);
+    uart_puts("Keys: 0/1 channel, l = low ref, h = high ref, s = save, r = reset\r\n");
+
+    adc_start();
+
+    while (1) {
+        int c = uart_getchar();
+
+        if (c == '0' || c == '1') {
+            ch = c - '0';
+            raw_lo = raw_hi = -1;
+            uart_puts("Channel AD");
+            print_number(ch, 0);
+            uart_puts("\r\n");
+        } else if (c == 'l' || c == 'h') {
+            int32_t raw16 = measure_raw16(ch);
+
+            if (c == 'l') raw_lo = raw16;
+            else raw_hi = raw16;
+
+            uart_puts(c == 'l' ? "Low " : "High ");
+            print_number(c == 'l' ? CAL_LOW_MV : CAL_HIGH_MV, 0);
+            uart_puts(" mV: raw ");
+            print_tenths((raw16 * 10 + 8) / 16);
+            uart_puts(", ideal ");
+            print_tenths((mv_to_count16(c == 'l' ? CAL_LOW_MV : CAL_HIGH_MV) * 10 + 8) / 16);
+            uart_puts("\r\n");
+
+            if (raw_lo >= 0 && raw_hi >= 0) {
+                adc_cal_t cal;
+
+                if (cal_compute(&cal, raw_lo, raw_hi)) {
+                    cal_set(ch, &cal);
+                    print_cal(ch);
+                    uart_puts("Press s to save\r\n");
+                } else {
+                    uart_puts("Points too close - check the references\r\n");
+                }
+                raw_lo = raw_hi = -1;
+            }
+        } else if (c == 's') {
+            if (cal_save()) {
+                uart_puts("Saved\r\n");
+                GPIO0DATA &= ~(1 << LED_PIN);   /* LED on = saved */
+            } else {
+                uart_puts("Flash write FAILED\r\n");
+                GPIO0DATA |= (1 << LED_PIN);    /* Old record may be erased */
+            }
+        } else if (c == 'r') {
+            adc_cal_t cal;
+
+            cal_identity(&cal);
+            cal_set(ch, &cal);
+            print_cal(ch);
+        }
+
+        /* Readings twice per second */
+        if (adc_samples[0] - last_print >= CONVERSION_RATE_HZ / ADC_CHANNELS / 2) {
+            last_print = adc_samples[0];
+
+            uart_puts("AD0 raw ");
+            print_number(adc_raw[0], 4);
+            uart_puts(" cal ");
+            print_number(adc_value[0], 4);
+            uart_puts(" = ");
+            print_number((adc_value[0] * ADC_VREF_MV + 512) / 1024, 4);
+            uart_puts(" mV   AD1 raw ");
+            print_number(adc_raw[1], 4);
+            uart_puts(" cal ");
+            print_number(adc_value[1], 4);
+            uart_puts(" = ");
+            print_tenths(adc_unit[1]);
+            uart_puts(" C   isr max ");
+            print_number(isr_cycles_max, 0);
+            uart_puts(" cycles\r\n");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,361 @@
+/**************************************************
+ * LPC1343 ADC Example: Multi-Channel Burst Scan
+ * Chapter 7: Analog to Digital Conversion
+ *
+ * Scans any subset of AD0-AD7 continuously in
+ * burst mode. The ADC interrupts once per scan,
+ * when the highest selected channel is done, and
+ * the ISR publishes all channels together as one
+ * snapshot with a sequence number.
+ *
+ * Snapshots are double-buffered: the ISR always
+ * writes the buffer the reader is NOT supposed to
+ * use. The reader copies the latest buffer and
+ * checks the sequence number afterwards - if the
+ * ISR finished more than one scan meanwhile, the
+ * copy may be torn and is simply taken again.
+ * Interrupts are never disabled.
+ *
+ * Hardware:
+ *   Potentiometer   → P0.11 (AD0)
+ *   LDR divider     → P1.0  (AD1)  (or joystick X)
+ *   Joystick Y      → P1.4  (AD5)  (optional)
+ *   LED → P0.7 (onboard, active low)
+ *   UART TXD → P1.7 (115200 8N1) - readings
+ *
+ * Key Concepts:
+ *   - Burst mode across several channels
+ *   - One interrupt per scan (last channel's DONE)
+ *   - OVERRUN: detecting a late ISR
+ *   - Lock-free double-buffered snapshots
+ *   - ADC interrupt (IRQ 49)
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_REG(addr) (*((volatile uint32_t *)(addr)))
+
+#define IOCON_R_PIO0_11     0x40044074  /* AD0 */
+#define IOCON_R_PIO1_0      0x40044078  /* AD1 */
+#define IOCON_R_PIO1_1      0x4004407C  /* AD2 */
+#define IOCON_R_PIO1_2      0x40044080  /* AD3 */
+#define IOCON_SWDIO_PIO1_3  0x40044090  /* AD4 (disables SWD!) */
+#define IOCON_PIO1_4        0x40044094  /* AD5 */
+#define IOCON_PIO1_10       0x4004406C  /* AD6 */
+#define IOCON_PIO1_11       0x40044098  /* AD7 */
+
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR(n)        (*((volatile uint32_t *)(0x4001C010 + 4 * (n))))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * NVIC Registers (Interrupt Controller)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define LED_PIN         7
+#define ADC_IRQn        49      /* ADC interrupt number */
+
+#define ADC_CHANNELS    8
+
+/* AD0DRn bits */
+#define ADC_OVERRUN     (1UL << 30)
+#define ADC_DONE        (1UL << 31)
+
+/* ADC clock = 72 MHz / 144 = 500 kHz (max 4.5 MHz).
+ * A 10-bit conversion takes 11 clocks = 22 us,
+ * so the ISR has 22 us after the scan completes
+ * before the first channel is converted again. */
+#define ADC_CLKDIV      143
+
+/* Channels to scan: AD0, AD1, AD5 */
+#define ADC_SCAN_MASK   ((1 << 0) | (1 << 1) | (1 << 5))
+
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Pin Table: IOCON register and ADC function
+ *------------------------------------------------*/
+static const struct {
+    uint32_t iocon;
+    uint8_t func;
+} adc_pins[ADC_CHANNELS] = {
+    { IOCON_R_PIO0_11,    0x02 },
+    { IOCON_R_PIO1_0,     0x02 },
+    { IOCON_R_PIO1_1,     0x02 },
+    { IOCON_R_PIO1_2,     0x02 },
+    { IOCON_SWDIO_PIO1_3, 0x02 },
+    { IOCON_PIO1_4,       0x01 },
+    { IOCON_PIO1_10,      0x01 },
+    { IOCON_PIO1_11,      0x01 },
+};
+
+/*--------------------------------------------------
+ * Snapshot Buffers
+ *
+ * adc_seq counts published scans. Scan s lives in
+ * adc_buf[s & 1], so the ISR writes scan s + 1 into
+ * the other buffer while a reader copies scan s.
+ *------------------------------------------------*/
+typedef struct {
+    uint32_t seq;                      /* Scan number */
+    uint16_t value[ADC_CHANNELS];      /* 10-bit results */
+} adc_snapshot_t;
+
+static uint16_t adc_buf[2][ADC_CHANNELS];
+static volatile uint32_t adc_seq = 0;
+
+static uint8_t adc_mask;               /* Channels in the scan */
+
+volatile uint32_t adc_dropped = 0;     /* Scans mixed with the next one */
+
+/*--------------------------------------------------
+ * Simple Delay Function
+ *------------------------------------------------*/
+static void delay(volatile uint32_t count) {
+    while (count--) {
+        __asm volatile ("nop");
+    }
+}
+
+/*--------------------------------------------------
+ * ADC Interrupt Handler
+ *
+ * Runs when the last channel of a scan is done.
+ * Reading each AD0DRn clears its DONE flag; the
+ * read of the last channel clears the interrupt.
+ *
+ * If the ISR comes late, the first channels may
+ * already hold the next scan. Their OVERRUN bit
+ * shows that a result was lost, and the scan is
+ * not published.
+ *------------------------------------------------*/
+void ADC_IRQHandler(void) {
+    uint16_t result[ADC_CHANNELS];
+    uint32_t pending = adc_mask;
+    uint32_t overrun = 0;
+
+    while (pending) {
+        uint32_t ch = __builtin_ctz(pending);
+        uint32_t data = AD0DR(ch);
+
+        pending &= pending - 1;
+        overrun |= data;
+        result[ch] = (data >> 6) & 0x3FF;
+    }
+
+    if (overrun & ADC_OVERRUN) {
+        adc_dropped++;
+        return;
+    }
+
+    /* Publish into the buffer readers are not using */
+    uint32_t next = adc_seq + 1;
+    uint16_t *buf = adc_buf[next & 1];
+
+    for (pending = adc_mask; pending; pending &= pending - 1) {
+        uint32_t ch = __builtin_ctz(pending);
+        buf[ch] = result[ch];
+    }
+
+    /* Results must be in memory before the new
+     * sequence number makes them visible */
+    __asm volatile ("" ::: "memory");
+    adc_seq = next;
+}
+
+/*--------------------------------------------------
+ * Start Scanning the Channels in mask
+ *------------------------------------------------*/
+static void adc_scan_start(uint8_t mask) {
+    /* Enable ADC clock and power */
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    /* Analog function, no pull resistor, ADMODE = 0 */
+    for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+        if (mask & (1 << ch)) {
+            IOCON_REG(adc_pins[ch].iocon) = adc_pins[ch].func;
+        }
+    }
+
+    adc_mask = mask;
+
+    /* Interrupt only on the highest channel: burst
+     * mode converts from the lowest channel up, so
+     * that is the end of each scan */
+    AD0INTEN = 1 << (31 - __builtin_clz(mask));
+
+    /* Enable ADC interrupt in NVIC */
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    /* AD0CR bit fields:
+     *   [7:0]   SEL    = channels to scan
+     *   [15:8]  CLKDIV = 143 (500 kHz)
+     *   [16]    BURST  = 1 (continuous scan)
+     *   [19:17] CLKS   = 000 (11 clocks, 10 bits)
+     *   [26:24] START  = 000 (required in burst mode)
+     */
+    AD0CR = mask
+          | (ADC_CLKDIV << 8)
+          | (1 << 16);
+}
+
+/*--------------------------------------------------
+ * Copy the Latest Complete Scan
+ *
+ * Safe from the main loop while the ISR runs.
+ * Returns the snapshot's sequence number; 0 means
+ * no scan has finished yet.
+ *------------------------------------------------*/
+static uint32_t adc_scan_read(adc_snapshot_t *snap) {
+    uint32_t seq;
+
+    do {
+        seq = adc_seq;
+        __asm volatile ("" ::: "memory");
+
+        for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+            snap->value[ch] = adc_buf[seq & 1][ch];
+        }
+
+        __asm volatile ("" ::: "memory");
+
+        /* One newer scan went to the other buffer and
+         * is harmless; two or more reused this one */
+    } while (adc_seq - seq > 1);
+
+    snap->seq = seq;
+    return seq;
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    adc_snapshot_t snap;
+    uint32_t last_seq = 0;
+
+    /* Enable GPIO clock */
+    SYSAHBCLKCTRL |= (1 << 6);
+
+    /* Configure LED pin as output */
+    GPIO0DIR |= (1 << LED_PIN);
+
+    uart_init(115200);
+    uart_puts("\r\nADC Multi-Channel - AD0 AD1 AD5\r\n");
+
+    adc_scan_start(ADC_SCAN_MASK);
+
+    /* Roughly 4 reports per second. The scan count
+     * shows the burst rate: 500 kHz / 11 / 3 channels
+     * = ~15150 scans/s, ~3800 per report. */
+    while (1) {
+        delay(1500000);
+
+        adc_scan_read(&snap);
+
+        /* LED on while the pot is above the light level */
+        if (snap.value[0] > snap.value[1]) {
+            GPIO0DATA &= ~(1 << LED_PIN);
+        } else {
+            GPIO0DATA |= (1 << LED_PIN);
+        }
+
+        uart_puts("AD0 ");
+        print_number(snap.value[0], 4);
+        uart_puts("  AD1 ");
+        print_number(snap.value[1], 4);
+        uart_puts("  AD5 ");
+        print_number(snap.value[5], 4);
+        uart_puts("  scans ");
+        print_number(snap.seq - last_seq, 5);
+        uart_puts("  dropped ");
+        print_number(adc_dropped, 0);
+        uart_puts("\r\n");
+
+        last_seq = snap.seq;
+    }
+
+    return 0;
+}
@@ -0,0 +1,501 @@
+/**************************************************
+ * LPC1343 ADC Example: Oversampling & Decimation
+ * Chapter 7: Analog to Digital Conversion
+ *
+ * Gets 12-13 bit readings out of the 10-bit ADC.
+ * The ADC samples at 15625 Hz (timer-triggered,
+ * as in ADC-Timer-Sampling) and the ISR adds up
+ * 4^n samples per output. The sum of 4^n samples
+ * has 2n more bits; keeping n of them gives n
+ * extra bits at 1/4^n of the sample rate:
+ *
+ *   n = 1:  11 bits,  4 samples, 3906 Hz
+ *   n = 2:  12 bits, 16 samples,  977 Hz
+ *   n = 3:  13 bits, 64 samples,  244 Hz
+ *
+ * This only works if the input has about 1 LSB
+ * of noise (or dither): a perfectly clean input
+ * gives the same 10-bit code every time, and the
+ * average of identical codes has no new bits.
+ *
+ * The accumulator is a CIC (cascaded integrator-
+ * comb) decimator. Order 1 is the plain sum of
+ * 4^n samples; orders 2 and 3 cost one addition
+ * per sample and stage, average over a longer,
+ * weighted window and reject interference near
+ * the output rate (mains hum, for example) much
+ * better.
+ *
+ * At start-up a self-test feeds synthetic input
+ * (known DC levels in 1/16 LSB steps plus ~1 LSB
+ * of noise) through the same decimator, and
+ * prints the measured error and resolution gain
+ * for every n and order.
+ *
+ * Hardware:
+ *   Thermistor divider → P0.11 (AD0)
+ *   UART TXD → P1.7 (115200 8N1) - results
+ *
+ * Key Concepts:
+ *   - Oversampling: 4^n samples per extra bit
+ *   - Noise as a requirement (dither)
+ *   - CIC decimator: integrators at the input rate,
+ *     combs at the output rate, wrap-around safe
+ *   - Rounding the final shift
+ *   - Measuring effective resolution
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_R_PIO0_11 (*((volatile uint32_t *)0x40044074))  /* AD0 */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * 32-bit Timer 0 (CT32B0) Registers
+ *------------------------------------------------*/
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR      (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0      (*((volatile uint32_t *)0x40014018))
+#define TMR32B0EMR      (*((volatile uint32_t *)0x4001403C))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR(n)        (*((volatile uint32_t *)(0x4001C010 + 4 * (n))))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * NVIC Registers (Interrupt Controller)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define ADC_IRQn        49      /* ADC interrupt number */
+#define ADC_CHANNEL     0       /* AD0 = P0.11 */
+
+/* ADC clock = 72 MHz / 16 = 4.5 MHz */
+#define ADC_CLKDIV      15
+#define ADC_START_CT32B0_MAT0   (4 << 24)
+
+/* 15625 Hz = 4608 CPU clocks = 288 ADC clocks:
+ * jitter-free, see ADC-Timer-Sampling */
+#define ADC_SAMPLE_RATE_HZ  15625
+#define SAMPLE_HALF_PERIOD  (SYSTEM_CLOCK / (2 * ADC_SAMPLE_RATE_HZ))
+
+#if (SYSTEM_CLOCK / ADC_SAMPLE_RATE_HZ) % (2 * (ADC_CLKDIV + 1)) != 0
+#error "Sample period must be a multiple of two ADC clocks for zero jitter"
+#endif
+
+/* Live measurement: 13 bits, plain sum (order 1) */
+#define OVS_N           3       /* Extra bits, 0-3 */
+#define CIC_ORDER       1       /* 1 = plain sum, 2-3 = CIC */
+#define CIC_MAX_ORDER   3
+
+/* 10 + 2 * n * order bits must fit in 32 */
+#if OVS_N > 3 || CIC_ORDER < 1 || CIC_ORDER > CIC_MAX_ORDER
+#error "OVS_N must be 0-3 and CIC_ORDER 1-3"
+#endif
+
+/* Output ring (power of two) */
+#define OUT_RING_SIZE   16
+#define OUT_RING_MASK   (OUT_RING_SIZE - 1)
+
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Oversampling / CIC Decimator
+ *
+ * Integrators run at the input rate, combs at the
+ * output rate (differential delay 1). All sums are
+ * uint32_t and may wrap: the combs subtract the
+ * wrapped values and the result is still exact, as
+ * long as the true output fits in 32 bits.
+ *
+ * Gain is R^order with R = 4^n, i.e. 2*n*order
+ * bits. Shifting right by (2*order - 1) * n keeps
+ * 10 + n bits.
+ *------------------------------------------------*/
+typedef struct {
+    uint8_t n;                          /* Extra bits */
+    uint8_t order;                      /* CIC stages */
+    uint8_t warmup;                     /* Outputs to discard */
+    uint32_t count;                     /* Samples in this window */
+    uint32_t integ[CIC_MAX_ORDER];
+    uint32_t comb[CIC_MAX_ORDER];
+} ovs_t;
+
+static void ovs_init(ovs_t *o, uint8_t n, uint8_t order) {
+    o->n = n;
+    o->order = order;
+    o->warmup = order - 1;              /* Outputs before the filter settles */
+    o->count = 0;
+
+    for (uint8_t k = 0; k < CIC_MAX_ORDER; k++) {
+        o->integ[k] = 0;
+        o->comb[k] = 0;
+    }
+}
+
+/*
+ * Feed one 10-bit sample. Returns 1 and stores a
+ * (10 + n)-bit result in *out every 4^n samples.
+ */
+static int ovs_feed(ovs_t *o, uint32_t sample, uint32_t *out) {
+    uint32_t acc = sample;
+
+    for (uint8_t k = 0; k < o->order; k++) {
+        o->integ[k] += acc;
+        acc = o->integ[k];
+    }
+
+    if (++o->count < (1UL << (2 * o->n))) {
+        return 0;
+    }
+    o->count = 0;
+
+    for (uint8_t k = 0; k < o->order; k++) {
+        uint32_t t = acc - o->comb[k];
+        o->comb[k] = acc;
+        acc = t;
+    }
+
+    /* Round instead of truncating (truncation would
+     * bias every result by -1/2 output LSB) */
+    uint32_t shift = (2 * o->order - 1) * o->n;
+    if (shift) {
+        acc = (acc + (1UL << (shift - 1))) >> shift;
+    }
+
+    if (o->warmup) {
+        o->warmup--;
+        return 0;
+    }
+
+    *out = acc;
+    return 1;
+}
+
+/*--------------------------------------------------
+ * ADC Sampling (ISR feeds the decimator)
+ *------------------------------------------------*/
+static ovs_t adc_ovs;
+
+static uint16_t out_ring[OUT_RING_SIZE];
+static volatile uint32_t out_head = 0;
+static volatile uint32_t out_tail = 0;
+
+volatile uint32_t out_overflows = 0;
+
+void ADC_IRQHandler(void) {
+    uint32_t data = AD0DR(ADC_CHANNEL);
+    uint32_t result;
+
+    if (!ovs_feed(&adc_ovs, (data >> 6) & 0x3FF, &result)) {
+        return;
+    }
+
+    uint32_t head = out_head;
+
+    if (head - out_tail >= OUT_RING_SIZE) {
+        out_overflows++;
+        return;
+    }
+
+    out_ring[head & OUT_RING_MASK] = result;
+    __asm volatile ("" ::: "memory");
+    out_head = head + 1;
+}
+
+static void adc_sampling_start(void) {
+    ovs_init(&adc_ovs, OVS_N, CIC_ORDER);
+
+    /* Enable ADC and CT32B0 clocks, power up ADC */
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 9) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    IOCON_R_PIO0_11 = 0x02;             /* AD0, analog mode */
+
+    AD0CR = (1 << ADC_CHANNEL)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;      /* Rising MAT0 edge */
+    AD0INTEN = (1 << ADC_CHANNEL);
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    TMR32B0TCR = 0x02;
+    TMR32B0PR = 0;
+    TMR32B0MR0 = SAMPLE_HALF_PERIOD - 1;
+    TMR32B0MCR = (1 << 1);              /* Reset on MR0 */
+    TMR32B0EMR = (3 << 4);              /* Toggle MAT0 */
+    TMR32B0TCR = 0x01;
+}
+
+static int adc_read(uint32_t *value) {
+    uint32_t tail = out_tail;
+
+    if (tail == out_head) return 0;
+
+    __asm volatile ("" ::: "memory");
+    *value = out_ring[tail & OUT_RING_MASK];
+    __asm volatile ("" ::: "memory");
+    out_tail = tail + 1;
+    return 1;
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/* Print value / 2^frac_bits with 3 decimals */
+static void print_fixed(uint32_t value, uint8_t frac_bits, uint8_t width) {
+    uint32_t scale = 1UL << frac_bits;
+    uint32_t milli = ((value % scale) * 1000 + scale / 2) / scale;
+    uint32_t whole = value / scale;
+
+    if (milli == 1000) {
+        whole++;
+        milli = 0;
+    }
+
+    print_number(whole, width);
+    uart_putchar('.');
+    print_number(milli / 100, 1);
+    print_number(milli / 10 % 10, 1);
+    print_number(milli % 10, 1);
+}
+
+/*--------------------------------------------------
+ * Integer Helpers for the Self-Test
+ *------------------------------------------------*/
+static uint32_t isqrt(uint32_t x) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > x) bit >>= 2;
+
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/* log2 of a Q16 number (>= 1.0), result in Q4 */
+static uint32_t log2_q4(uint32_t x) {
+    uint32_t result = 0;
+
+    while (x >= (2UL << 16)) {
+        x >>= 1;
+        result += 16;
+    }
+
+    /* Fraction bits: square, and if >= 2 halve */
+    for (uint32_t bit = 8; bit; bit >>= 1) {
+        x = (uint32_t)(((uint64_t)x * x) >> 16);
+        if (x >= (2UL << 16)) {
+            x >>= 1;
+            result += bit;
+        }
+    }
+    return result;
+}
+
+static uint32_t lcg_state = 12345;
+
+/* Uniform noise in [-1, +1) LSB, Q8 */
+static int32_t noise_q8(void) {
+    lcg_state = lcg_state * 1664525 + 1013904223;
+    return (int32_t)((lcg_state >> 16) & 0x1FF) - 256;
+}
+
+/*--------------------------------------------------
+ * Self-Test with Synthetic Input
+ *
+ * The true input steps through 16 DC levels from
+ * 512.0 to 512.9375 LSB (1/16 LSB apart). Noise is
+ * the sum of four uniform values in [-1, +1) LSB
+ * (~1.15 LSB rms). Each sample is rounded to a
+ * 10-bit code, as the ADC does.
+ *
+ * Returns the RMS error of the outputs against the
+ * true level, in 1/256 LSB (Q8).
+ *------------------------------------------------*/
+#define SELFTEST_LEVELS         16
+#define SELFTEST_SAMPLES        4096    /* Per level */
+
+static uint32_t ovs_self_test(uint8_t n, uint8_t order) {
+    uint64_t sum_sq = 0;
+    uint32_t outputs = 0;
+
+    for (uint32_t level = 0; level < SELFTEST_LEVELS; level++) {
+        int32_t true_q8 = (512 << 8) + (int32_t)(level << 4);
+        ovs_t o;
+
+        /* Fresh decimator per level: warm-up also
+         * hides the step from the previous level */
+        ovs_init(&o, n, order);
+
+        for (uint32_t i = 0; i < SELFTEST_SAMPLES; i++) {
+            int32_t x = true_q8 + noise_q8() + noise_q8() +
+                        noise_q8() + noise_q8();
+            int32_t code = (x + 128) >> 8;
+            uint32_t out;
+
+            if (code < 0) code = 0;
+            if (code > 1023) code = 1023;
+
+            if (ovs_feed(&o, (uint32_t)code, &out)) {
+                int32_t err_q8 = (int32_t)(out << (8 - n)) - true_q8;
+                sum_sq += (uint64_t)((int64_t)err_q8 * err_q8);
+                outputs++;
+            }
+        }
+    }
+
+    return isqrt((uint32_t)(sum_sq / outputs));
+}
+
+static void run_self_test(void) {
+    uint32_t rms_raw = ovs_self_test(0, 1);
+
+    uart_puts("\r\nSelf-test: 16 DC levels 1/16 LSB apart, ~1.15 LSB rms noise\r\n");
+    uart_puts(" n order bits  rate Hz  rms error LSB  gain bits\r\n");
+
+    for (uint8_t n = 0; n <= 3; n++) {
+        for (uint8_t order = 1; order <= CIC_MAX_ORDER; order++) {
+            if (n == 0 && order > 1) continue;
+
+            uint32_t rms = (n == 0) ? rms_raw : ovs_self_test(n, order);
+            uint32_t gain_q4 = log2_q4((uint32_t)(((uint64_t)rms_raw << 16) / rms));
+
+            print_number(n, 2);
+            print_number(order, 6);
+            print_number(10 + n, 5);
+            uart_puts("  ");
+            print_fixed((ADC_SAMPLE_RATE_HZ << 8) >> (2 * n), 8, 5);
+            uart_puts("  ");
+            print_fixed(rms, 8, 6);
+            uart_puts("      ");
+            print_fixed(gain_q4, 4, 2);
+            uart_puts("\r\n");
+        }
+    }
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    uint32_t value;
+    uint32_t count = 0;
+
+    uart_init(115200);
+    uart_puts("\r\nADC Oversampling\r\n");
+
+    run_self_test();
+
+    uart_puts("\r\nLive: AD0, ");
+    print_number(10 + OVS_N, 0);
+    uart_puts(" bits (+");
+    print_number(OVS_N, 0);
+    uart_puts("), CIC order ");
+    print_number(CIC_ORDER, 0);
+    uart_puts(", ");
+    print_fixed((ADC_SAMPLE_RATE_HZ << 8) >> (2 * OVS_N), 8, 0);
+    uart_puts(" Hz\r\n");
+
+    adc_sampling_start();
+
+    /* Print about 4 readings per second, in 10-bit
+     * LSB units with the extra bits as a fraction */
+    while (1) {
+        if (!adc_read(&value)) {
+            __asm volatile ("wfi");
+            continue;
+        }
+
+        if (++count < ((ADC_SAMPLE_RATE_HZ >> (2 * OVS_N)) / 4)) {
+            continue;
+        }
+        count = 0;
+
+        print_number(value, 5);
+        uart_puts("  = ");
+        print_fixed(value, OVS_N, 4);
+        uart_puts(" LSB  overflows ");
+        print_number(out_overflows, 0);
+        uart_puts("\r\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,347 @@
+/**************************************************
+ * LPC1343 ADC Example: Timer-Triggered Sampling
+ * Chapter 7: Analog to Digital Conversion
+ *
+ * Samples the potentiometer at exactly 1000 Hz.
+ * Each conversion is started in hardware by the
+ * CT32B0 MAT0 signal (AD0CR START = 100), so the
+ * sample rate comes from the timer, not from a
+ * delay loop or the ADC clock. The ISR only moves
+ * each result into a ring buffer; the main loop
+ * takes samples out whenever it has time.
+ *
+ * The sample period (72000 CPU clocks) is an
+ * exact multiple of the ADC clock period (16 CPU
+ * clocks), so every start edge meets the ADC clock
+ * at the same phase: the sample instants have no
+ * jitter at all.
+ *
+ * Samples that do not fit into the ring buffer,
+ * and conversions the ISR missed, are counted, so
+ * downstream code always knows whether the stream
+ * is continuous.
+ *
+ * Hardware:
+ *   Potentiometer → P0.11 (AD0)
+ *   LED → P0.7 (onboard, active low)
+ *   UART TXD → P1.7 (115200 8N1) - block statistics
+ *
+ * Key Concepts:
+ *   - Hardware conversion start from a timer match
+ *   - EMR toggle: one rising edge every two matches
+ *   - Jitter-free sampling (timer period a multiple
+ *     of the ADC clock)
+ *   - Power-of-two single-producer ring buffer
+ *   - Overflow and overrun accounting
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_R_PIO0_11 (*((volatile uint32_t *)0x40044074))  /* AD0 */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+
+/*--------------------------------------------------
+ * 32-bit Timer 0 (CT32B0) Registers
+ *------------------------------------------------*/
+#define TMR32B0IR       (*((volatile uint32_t *)0x40014000))
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0TC       (*((volatile uint32_t *)0x40014008))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR      (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0      (*((volatile uint32_t *)0x40014018))
+#define TMR32B0EMR      (*((volatile uint32_t *)0x4001403C))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR(n)        (*((volatile uint32_t *)(0x4001C010 + 4 * (n))))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * NVIC Registers (Interrupt Controller)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define LED_PIN         7
+#define ADC_IRQn        49      /* ADC interrupt number */
+
+#define ADC_CHANNEL     0       /* AD0 = P0.11 */
+
+/* AD0DRn bits */
+#define ADC_OVERRUN     (1UL << 30)
+
+/* AD0CR START field: conversion on a CT32B0_MAT0
+ * edge; EDGE = 0 selects the rising edge */
+#define ADC_START_CT32B0_MAT0   (4 << 24)
+#define ADC_EDGE_RISING         (0 << 27)
+
+/* ADC clock = 72 MHz / 16 = 4.5 MHz (the maximum),
+ * one conversion = 11 clocks = 2.44 us */
+#define ADC_CLKDIV      15
+
+#define ADC_SAMPLE_RATE_HZ  1000
+
+/* MAT0 toggles on every match and the ADC starts
+ * on rising edges only, so the timer matches at
+ * twice the sample rate */
+#define SAMPLE_HALF_PERIOD  (SYSTEM_CLOCK / (2 * ADC_SAMPLE_RATE_HZ))
+
+#if (SYSTEM_CLOCK / ADC_SAMPLE_RATE_HZ) % (2 * (ADC_CLKDIV + 1)) != 0
+#error "Sample period must be a multiple of two ADC clocks for zero jitter"
+#endif
+
+/* Ring buffer size: power of two, so indices wrap
+ * with a mask. 512 samples = 512 ms at 1 kHz. */
+#define ADC_RING_SIZE   512
+#define ADC_RING_MASK   (ADC_RING_SIZE - 1)
+
+#if (ADC_RING_SIZE & ADC_RING_MASK) != 0
+#error "ADC_RING_SIZE must be a power of two"
+#endif
+
+#define BLOCK_SIZE      ADC_SAMPLE_RATE_HZ   /* 1 s of samples */
+
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Sample Ring Buffer
+ *
+ * head and tail run freely and are masked on use,
+ * so head - tail is the fill level even after they
+ * wrap. Only the ISR writes head, only the main
+ * loop writes tail.
+ *------------------------------------------------*/
+static uint16_t adc_ring[ADC_RING_SIZE];
+static volatile uint32_t adc_head = 0;
+static volatile uint32_t adc_tail = 0;
+
+volatile uint32_t adc_overflows = 0;   /* Ring full, sample dropped */
+volatile uint32_t adc_overruns = 0;    /* ISR too late, sample lost */
+
+/*--------------------------------------------------
+ * ADC Interrupt Handler
+ *
+ * One call per conversion. Reading AD0DRn clears
+ * its DONE flag and the interrupt.
+ *------------------------------------------------*/
+void ADC_IRQHandler(void) {
+    uint32_t data = AD0DR(ADC_CHANNEL);
+    uint32_t head = adc_head;
+
+    if (data & ADC_OVERRUN) {
+        adc_overruns++;
+    }
+
+    if (head - adc_tail >= ADC_RING_SIZE) {
+        adc_overflows++;
+        return;
+    }
+
+    adc_ring[head & ADC_RING_MASK] = (data >> 6) & 0x3FF;
+
+    /* Sample must be stored before it is published */
+    __asm volatile ("" ::: "memory");
+    adc_head = head + 1;
+}
+
+/*--------------------------------------------------
+ * Start Sampling at ADC_SAMPLE_RATE_HZ
+ *------------------------------------------------*/
+static void adc_sampling_start(void) {
+    /* Enable ADC and CT32B0 clocks, power up ADC */
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 9) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    /* P0.11 = AD0, analog mode */
+    IOCON_R_PIO0_11 = 0x02;
+
+    /* AD0CR bit fields:
+     *   [7:0]   SEL    = channel 0
+     *   [15:8]  CLKDIV = 15 (4.5 MHz)
+     *   [16]    BURST  = 0 (one conversion per start)
+     *   [26:24] START  = 100 (CT32B0_MAT0)
+     *   [27]    EDGE   = 0 (rising)
+     */
+    AD0CR = (1 << ADC_CHANNEL)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0
+          | ADC_EDGE_RISING;
+
+    AD0INTEN = (1 << ADC_CHANNEL);
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    /* CT32B0: count CPU clocks, reset on MR0 and
+     * toggle the internal MAT0 signal. The ADC sees
+     * it without routing MAT0 to a pin. */
+    TMR32B0TCR = 0x02;                  /* Reset */
+    TMR32B0PR = 0;
+    TMR32B0MR0 = SAMPLE_HALF_PERIOD - 1;
+    TMR32B0MCR = (1 << 1);              /* MR0R: reset on MR0 */
+    TMR32B0EMR = (3 << 4);              /* EMC0 = toggle, EM0 = 0 */
+    TMR32B0TCR = 0x01;                  /* Start */
+}
+
+/*--------------------------------------------------
+ * Take up to max Samples out of the Ring
+ *
+ * Returns the number copied. Never blocks.
+ *------------------------------------------------*/
+static uint32_t adc_read(uint16_t *dst, uint32_t max) {
+    uint32_t tail = adc_tail;
+    uint32_t count = adc_head - tail;
+
+    if (count > max) count = max;
+
+    /* Samples up to adc_head are complete */
+    __asm volatile ("" ::: "memory");
+
+    for (uint32_t i = 0; i < count; i++) {
+        dst[i] = adc_ring[(tail + i) & ADC_RING_MASK];
+    }
+
+    /* Copy is done before the slots are freed */
+    __asm volatile ("" ::: "memory");
+    adc_tail = tail + count;
+
+    return count;
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    uint16_t chunk[64];
+    uint32_t in_block = 0;
+    uint32_t sum = 0;
+    uint16_t min = 0x3FF, max = 0;
+
+    /* Enable GPIO clock */
+    SYSAHBCLKCTRL |= (1 << 6);
+
+    /* Configure LED pin as output */
+    GPIO0DIR |= (1 << LED_PIN);
+
+    uart_init(115200);
+    uart_puts("\r\nADC Timer Sampling - AD0 at 1000 Hz\r\n");
+
+    adc_sampling_start();
+
+    /* Statistics over blocks of exactly 1000
+     * samples. The sample count is the clock here:
+     * the LED toggles once per second, as exactly
+     * as the timer runs. */
+    while (1) {
+        uint32_t n = adc_read(chunk, 64);
+
+        for (uint32_t i = 0; i < n; i++) {
+            uint16_t v = chunk[i];
+
+            sum += v;
+            if (v < min) min = v;
+            if (v > max) max = v;
+
+            if (++in_block == BLOCK_SIZE) {
+                GPIO0DATA ^= (1 << LED_PIN);
+
+                uart_puts("min ");
+                print_number(min, 4);
+                uart_puts("  mean ");
+                print_number(sum / BLOCK_SIZE, 4);
+                uart_puts("  max ");
+                print_number(max, 4);
+                uart_puts("  overflows ");
+                print_number(adc_overflows, 0);
+                uart_puts("  overruns ");
+                print_number(adc_overruns, 0);
+                uart_puts("\r\n");
+
+                in_block = 0;
+                sum = 0;
+                min = 0x3FF;
+                max = 0;
+            }
+        }
+
+        if (n == 0) {
+            __asm volatile ("wfi");     /* Next sample wakes us */
+        }
+    }
+
+    return 0;
+}
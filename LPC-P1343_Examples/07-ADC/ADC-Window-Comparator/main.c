@@ -0,0 +1,456 @@
+/**************************************************
+ * LPC1343 ADC Example: Window Comparator Events
+ * Chapter 7: Analog to Digital Conversion
+ *
+ * Light-Sensor polls the ADC in the main loop and
+ * applies its hysteresis there. Here the ADC
+ * interrupt does that work: each channel has a
+ * window comparator with three zones
+ *
+ *        ABOVE
+ *   ───────────── high ± hysteresis
+ *        INSIDE
+ *   ───────────── low ± hysteresis
+ *        BELOW
+ *
+ * A new zone must be seen in 'debounce' samples
+ * in a row before it is accepted. Only then does
+ * the ISR queue an event (channel, old zone, new
+ * zone, value). Samples that do not change a zone
+ * cost a few dozen cycles and nothing else.
+ *
+ * The main loop sleeps with SLEEPONEXIT set: after
+ * each ADC interrupt the CPU goes straight back to
+ * sleep without returning to main. The ISR clears
+ * SLEEPONEXIT when it queues an event, so main()
+ * runs only when a zone has actually changed.
+ *
+ * CT32B0 MAT0 starts one conversion every 5 ms;
+ * the ISR switches to the next channel each time,
+ * so each channel is sampled at 100 Hz.
+ *
+ * Hardware:
+ *   LDR divider (see Light-Sensor) → P0.11 (AD0)
+ *   Potentiometer → P1.0 (AD1)
+ *   LED → P0.7 (onboard, active low) - dark
+ *   UART TXD → P1.7 (115200 8N1) - events
+ *
+ * Key Concepts:
+ *   - Hysteresis and debouncing inside the ISR
+ *   - Events only on zone crossings
+ *   - Timer-triggered channel rotation
+ *   - Event queue (ISR → main loop)
+ *   - WFI with SLEEPONEXIT
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_R_PIO0_11 (*((volatile uint32_t *)0x40044074))  /* AD0 */
+#define IOCON_R_PIO1_0  (*((volatile uint32_t *)0x40044078))  /* AD1 */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+
+/*--------------------------------------------------
+ * 32-bit Timer 0 (CT32B0) Registers
+ *------------------------------------------------*/
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR      (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0      (*((volatile uint32_t *)0x40014018))
+#define TMR32B0EMR      (*((volatile uint32_t *)0x4001403C))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR(n)        (*((volatile uint32_t *)(0x4001C010 + 4 * (n))))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * Core Registers (NVIC, SCB)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+#define SCB_SCR         (*((volatile uint32_t *)0xE000ED10))
+
+#define SCR_SLEEPONEXIT (1 << 1)
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define LED_PIN         7
+#define ADC_IRQn        49      /* ADC interrupt number */
+
+#define ADC_OVERRUN     (1UL << 30)
+#define ADC_CLKDIV      15      /* 4.5 MHz */
+#define ADC_START_CT32B0_MAT0   (4 << 24)
+
+#define WIN_CHANNELS    2       /* AD0, AD1 */
+
+/* One conversion per MAT0 rising edge, channels
+ * take turns: 200 Hz / 2 = 100 Hz per channel */
+#define CONVERSION_RATE_HZ  200
+#define SAMPLE_HALF_PERIOD  (SYSTEM_CLOCK / (2 * CONVERSION_RATE_HZ))
+
+#if (SYSTEM_CLOCK / CONVERSION_RATE_HZ) % (2 * (ADC_CLKDIV + 1)) != 0
+#error "Sample period must be a multiple of two ADC clocks for zero jitter"
+#endif
+
+#define EVENT_QUEUE_SIZE    8   /* Power of two */
+#define EVENT_QUEUE_MASK    (EVENT_QUEUE_SIZE - 1)
+
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Window Comparators
+ *------------------------------------------------*/
+enum {
+    ZONE_BELOW,
+    ZONE_INSIDE,
+    ZONE_ABOVE
+};
+
+typedef struct {
+    /* Configuration */
+    uint16_t low;               /* BELOW / INSIDE boundary */
+    uint16_t high;              /* INSIDE / ABOVE boundary */
+    uint16_t hysteresis;        /* Counts past a boundary */
+    uint8_t debounce;           /* Samples in a row */
+
+    /* State (ISR only) */
+    uint8_t zone;               /* Accepted zone */
+    uint8_t pending;            /* Candidate zone */
+    uint8_t count;              /* Samples seen in 'pending' */
+} adc_window_t;
+
+static adc_window_t windows[WIN_CHANNELS] = {
+    /* AD0, LDR: dark below 300, bright above 400
+     * (the thresholds of Light-Sensor), 50 ms */
+    { 350, 1023, 50, 5, ZONE_INSIDE, ZONE_INSIDE, 0 },
+
+    /* AD1, pot: a 400-600 window, 30 ms */
+    { 400, 600, 8, 3, ZONE_INSIDE, ZONE_INSIDE, 0 },
+};
+
+/*--------------------------------------------------
+ * Event Queue
+ *
+ * Free-running head and tail, as the sample ring
+ * in ADC-Timer-Sampling. Only the ISR writes head,
+ * only the main loop writes tail.
+ *------------------------------------------------*/
+typedef struct {
+    uint8_t channel;
+    uint8_t from;
+    uint8_t to;
+    uint16_t value;
+} adc_event_t;
+
+static adc_event_t event_queue[EVENT_QUEUE_SIZE];
+static volatile uint32_t event_head = 0;
+static volatile uint32_t event_tail = 0;
+
+volatile uint32_t events_lost = 0;    /* Queue full */
+volatile uint32_t adc_samples = 0;    /* Conversions seen */
+volatile uint32_t adc_overruns = 0;   /* ISR too late */
+
+static uint8_t adc_channel = 0;       /* Being converted */
+
+/*--------------------------------------------------
+ * Zone of a Sample
+ *
+ * The boundaries move away from the current zone
+ * by the hysteresis, so leaving a zone takes a
+ * sample clearly beyond the boundary, in either
+ * direction. A jump straight across the INSIDE
+ * zone is possible.
+ *------------------------------------------------*/
+static uint8_t window_zone(const adc_window_t *w, uint16_t value) {
+    int32_t low = (w->zone == ZONE_BELOW) ? w->low + w->hysteresis
+                                          : w->low - w->hysteresis;
+    int32_t high = (w->zone == ZONE_ABOVE) ? w->high - w->hysteresis
+                                           : w->high + w->hysteresis;
+
+    if (value < low) return ZONE_BELOW;
+    if (value > high) return ZONE_ABOVE;
+    return ZONE_INSIDE;
+}
+
+/*--------------------------------------------------
+ * Update a Comparator
+ *
+ * Returns 1 when the accepted zone changed.
+ *------------------------------------------------*/
+static uint8_t window_update(adc_window_t *w, uint16_t value) {
+    uint8_t zone = window_zone(w, value);
+
+    if (zone == w->zone) {
+        w->count = 0;                   /* Back in the old zone */
+        return 0;
+    }
+
+    if (zone != w->pending || w->count == 0) {
+        w->pending = zone;
+        w->count = 0;
+    }
+
+    if (++w->count < w->debounce) return 0;
+
+    w->zone = zone;
+    w->count = 0;
+    return 1;
+}
+
+/*--------------------------------------------------
+ * ADC Interrupt Handler
+ *
+ * One call per conversion. Reading AD0DRn clears
+ * its DONE flag and the interrupt. The next MAT0
+ * edge converts the newly selected channel.
+ *------------------------------------------------*/
+void ADC_IRQHandler(void) {
+    uint8_t ch = adc_channel;
+    uint32_t data = AD0DR(ch);
+    uint16_t value = (data >> 6) & 0x3FF;
+    adc_window_t *w = &windows[ch];
+    uint8_t from = w->zone;
+
+    /* Select the next channel */
+    adc_channel = (ch + 1 < WIN_CHANNELS) ? ch + 1 : 0;
+    AD0CR = (1 << adc_channel)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;
+    AD0INTEN = (1 << adc_channel);
+
+    adc_samples++;
+    if (data & ADC_OVERRUN) adc_overruns++;
+
+    if (!window_update(w, value)) return;
+
+    uint32_t head = event_head;
+
+    if (head - event_tail >= EVENT_QUEUE_SIZE) {
+        events_lost++;
+        return;
+    }
+
+    adc_event_t *e = &event_queue[head & EVENT_QUEUE_MASK];
+    e->channel = ch;
+    e->from = from;
+    e->to = w->zone;
+    e->value = value;
+
+    __asm volatile ("" ::: "memory");
+    event_head = head + 1;
+
+    /* Return to main() to handle it */
+    SCB_SCR &= ~SCR_SLEEPONEXIT;
+}
+
+/*--------------------------------------------------
+ * Take the Next Event
+ *
+ * Returns 0 if the queue is empty.
+ *------------------------------------------------*/
+static uint8_t event_get(adc_event_t *e) {
+    uint32_t tail = event_tail;
+
+    if (tail == event_head) return 0;
+
+    __asm volatile ("" ::: "memory");
+    *e = event_queue[tail & EVENT_QUEUE_MASK];
+
+    __asm volatile ("" ::: "memory");
+    event_tail = tail + 1;
+
+    return 1;
+}
+
+/*--------------------------------------------------
+ * Sleep Until the Next Event
+ *
+ * With interrupts masked, an event queued between
+ * the check and WFI still ends the WFI (the
+ * interrupt is pending), so it cannot be missed.
+ * The ISRs then run, and with SLEEPONEXIT each one
+ * goes back to sleep - until one queues an event
+ * and clears the bit.
+ *------------------------------------------------*/
+static void sleep_until_event(void) {
+    __asm volatile ("cpsid i" ::: "memory");
+
+    if (event_tail == event_head) {
+        SCB_SCR |= SCR_SLEEPONEXIT;
+        __asm volatile ("wfi");
+    }
+
+    __asm volatile ("cpsie i" ::: "memory");
+}
+
+/*--------------------------------------------------
+ * Start the Timer-Triggered Conversions
+ *------------------------------------------------*/
+static void adc_windows_start(void) {
+    /* Enable ADC and CT32B0 clocks, power up ADC */
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 9) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    IOCON_R_PIO0_11 = 0x02;             /* AD0, analog mode */
+    IOCON_R_PIO1_0 = 0x02;              /* AD1, analog mode */
+
+    adc_channel = 0;
+    AD0CR = (1 << 0)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;      /* Rising MAT0 edge */
+    AD0INTEN = (1 << 0);
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    TMR32B0TCR = 0x02;                  /* Reset */
+    TMR32B0PR = 0;
+    TMR32B0MR0 = SAMPLE_HALF_PERIOD - 1;
+    TMR32B0MCR = (1 << 1);              /* MR0R: reset on MR0 */
+    TMR32B0EMR = (3 << 4);              /* EMC0 = toggle, EM0 = 0 */
+    TMR32B0TCR = 0x01;                  /* Start */
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*--------------------------------------------------
+ * LED Control (active low)
+ *------------------------------------------------*/
+static void led_on(void) {
+    GPIO0DATA &= ~(1 << LED_PIN);
+}
+
+static void led_off(void) {
+    GPIO0DATA |= (1 << LED_PIN);
+}
+
+/*--------------------------------------------------
+ * Handle One Event
+ *------------------------------------------------*/
+static const char *const zone_names[] = { "BELOW", "INSIDE", "ABOVE" };
+
+static void handle_event(const adc_event_t *e) {
+    /* AD0 BELOW = dark: nightlight on */
+    if (e->channel == 0) {
+        if (e->to == ZONE_BELOW) led_on();
+        else led_off();
+    }
+
+    uart_puts("AD");
+    print_number(e->channel, 0);
+    uart_puts(": ");
+    uart_puts(zone_names[e->from]);
+    uart_puts(" -> ");
+    uart_puts(zone_names[e->to]);
+    uart_puts(" at ");
+    print_number(e->value, 4);
+    uart_puts("   (");
+    print_number(adc_samples, 0);
+    uart_puts(" samples, ");
+    print_number(events_lost, 0);
+    uart_puts(" lost)\r\n");
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    adc_event_t e;
+    uint32_t wakeups = 0;
+
+    /* Enable GPIO clock */
+    SYSAHBCLKCTRL |= (1 << 6);
+
+    GPIO0DIR |= (1 << LED_PIN);
+    led_off();
+
+    uart_init(115200);
+    uart_puts("\r\nADC Window Comparator\r\n");
+
+    adc_windows_start();
+
+    while (1) {
+        sleep_until_event();
+        wakeups++;
+
+        while (event_get(&e)) {
+            handle_event(&e);
+        }
+
+        uart_puts("  main() woke ");
+        print_number(wakeups, 0);
+        uart_puts(" times\r\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,649 @@
+/**************************************************
+ * LPC1343 ADC Example: Fixed-Point DSP Filters
+ * Chapter 7: Analog to Digital Conversion
+ *
+ * A small Q15/Q31 filter library for ADC data:
+ *
+ *   - Biquad IIR cascade (Q31 data, Q2.30 coeffs)
+ *   - Moving average with a running sum
+ *   - Exponential smoothing (Q15 alpha)
+ *   - Median of 5 (removes single spikes)
+ *
+ * The Cortex-M3 has no DSP extension (no SMLAD,
+ * no saturating adds), but it does have fast
+ * 32x32->64 bit multiplies: SMULL and SMLAL take
+ * 3-5 cycles. The kernels are built around them:
+ * every multiply-accumulate goes into a 64-bit
+ * accumulator, so intermediate results never
+ * overflow and are only rounded once per output.
+ *
+ * At start-up a self-test runs every filter over
+ * a synthetic signal and compares it with a
+ * golden model (double precision for the IIR and
+ * the smoothing filter, exact re-computation for
+ * the moving average and the median). It prints
+ * the largest difference and the cycles per
+ * sample measured with the DWT cycle counter.
+ * A last run drives the biquad with full-scale
+ * steps to check that its overshoot saturates.
+ *
+ * Then the potentiometer is sampled at 1000 Hz
+ * (timer-triggered, as in ADC-Timer-Sampling) and
+ * all four filters run in the ADC interrupt.
+ *
+ * Hardware:
+ *   Potentiometer / LDR divider → P0.11 (AD0)
+ *   UART TXD → P1.7 (115200 8N1) - results
+ *
+ * Key Concepts:
+ *   - Q15 and Q31 fixed point
+ *   - SMULL / SMLAL with 64-bit accumulators
+ *   - Direct Form I biquads, cascaded
+ *   - O(1) moving average
+ *   - Sorting network median
+ *   - Golden-model testing on the target
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_R_PIO0_11 (*((volatile uint32_t *)0x40044074))  /* AD0 */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * 32-bit Timer 0 (CT32B0) Registers
+ *------------------------------------------------*/
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR      (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0      (*((volatile uint32_t *)0x40014018))
+#define TMR32B0EMR      (*((volatile uint32_t *)0x4001403C))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR(n)        (*((volatile uint32_t *)(0x4001C010 + 4 * (n))))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * Core Registers (NVIC, DWT)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define ADC_IRQn        49      /* ADC interrupt number */
+#define ADC_CHANNEL     0       /* AD0 = P0.11 */
+#define ADC_CLKDIV      15      /* 4.5 MHz */
+#define ADC_START_CT32B0_MAT0   (4 << 24)
+
+#define ADC_SAMPLE_RATE_HZ  1000
+#define SAMPLE_HALF_PERIOD  (SYSTEM_CLOCK / (2 * ADC_SAMPLE_RATE_HZ))
+
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Fixed-Point Basics
+ *
+ * Q15: int16_t, -1.0 .. +0.99997 (x / 32768)
+ * Q31: int32_t, -1.0 .. +0.99999999 (x / 2^31)
+ * Q2.30: int32_t coefficients, -2.0 .. +1.99999
+ *        (biquad a1 can exceed 1.0)
+ *------------------------------------------------*/
+#define Q15_MAX         32767
+#define Q15_MIN         (-32768)
+#define Q31_MAX         2147483647L
+#define Q31_MIN         (-Q31_MAX - 1)
+
+/* 32 x 32 -> 64 bit signed multiply */
+static inline int64_t smull(int32_t a, int32_t b) {
+    int64_t r;
+    __asm ("smull %Q0, %R0, %1, %2" : "=&r" (r) : "r" (a), "r" (b));
+    return r;
+}
+
+/* acc += 32 x 32 -> 64 bit signed multiply */
+static inline int64_t smlal(int64_t acc, int32_t a, int32_t b) {
+    __asm ("smlal %Q0, %R0, %1, %2" : "+r" (acc) : "r" (a), "r" (b));
+    return acc;
+}
+
+static inline int16_t sat_q15(int32_t x) {
+    if (x > Q15_MAX) return Q15_MAX;
+    if (x < Q15_MIN) return Q15_MIN;
+    return (int16_t)x;
+}
+
+static inline int32_t sat_q31(int64_t x) {
+    if (x > Q31_MAX) return Q31_MAX;
+    if (x < Q31_MIN) return Q31_MIN;
+    return (int32_t)x;
+}
+
+/* Q15 <-> Q31 */
+#define Q15_TO_Q31(x)   ((int32_t)(x) << 16)
+#define Q31_TO_Q15(x)   sat_q15((int32_t)(((int64_t)(x) + 0x8000) >> 16))
+
+/*--------------------------------------------------
+ * Biquad IIR Cascade (Direct Form I)
+ *
+ *   y = b0 x + b1 x[-1] + b2 x[-2]
+ *     - a1 y[-1] - a2 y[-2]
+ *
+ * a1 and a2 are stored negated, so the kernel is
+ * five SMLALs into one 64-bit accumulator. The sum
+ * is Q2.30 x Q31 = Q61 (plus growth) and is shifted
+ * back to Q31 once, with rounding.
+ *
+ * Direct Form I keeps the state in the same Q31
+ * format as the data, which makes it the robust
+ * choice for fixed point: the internal values can
+ * never be larger than the input and output.
+ *------------------------------------------------*/
+typedef struct {
+    int32_t b0, b1, b2;    /* Q2.30 */
+    int32_t na1, na2;      /* Q2.30, = -a1, -a2 */
+} biquad_coeffs_t;
+
+typedef struct {
+    int32_t x1, x2, y1, y2;
+} biquad_state_t;
+
+typedef struct {
+    const biquad_coeffs_t *coeffs;
+    biquad_state_t *state;
+    uint8_t stages;
+} biquad_cascade_t;
+
+static int32_t biquad_cascade_q31(biquad_cascade_t *f, int32_t x) {
+    for (uint8_t i = 0; i < f->stages; i++) {
+        const biquad_coeffs_t *c = &f->coeffs[i];
+        biquad_state_t *s = &f->state[i];
+
+        int64_t acc = smull(c->b0, x);
+        acc = smlal(acc, c->b1, s->x1);
+        acc = smlal(acc, c->b2, s->x2);
+        acc = smlal(acc, c->na1, s->y1);
+        acc = smlal(acc, c->na2, s->y2);
+
+        int32_t y = sat_q31((acc + (1L << 29)) >> 30);
+
+        s->x2 = s->x1;
+        s->x1 = x;
+        s->y2 = s->y1;
+        s->y1 = y;
+
+        x = y;                          /* Input of the next stage */
+    }
+    return x;
+}
+
+/* 4th-order Butterworth low-pass, fc = 10 Hz at
+ * fs = 1000 Hz, as two sections (Q = 0.5412 and
+ * Q = 1.3066), bilinear transform, scaled by 2^30 */
+static const biquad_coeffs_t lpf_coeffs[2] = {
+    { 1001305, 2002611, 1001305, 2025731614, -955995012 },
+    { 1034533, 2069067, 1034533, 2092954698, -1023351008 },
+};
+
+/*--------------------------------------------------
+ * Moving Average (Q15, running sum)
+ *
+ * Adds the new sample and subtracts the one that
+ * leaves the window: two operations per sample for
+ * any window length. The window is a power of two,
+ * so the division is a shift.
+ *------------------------------------------------*/
+#define MA_LOG2         4
+#define MA_LENGTH       (1 << MA_LOG2)  /* 16 samples */
+
+typedef struct {
+    int16_t buf[MA_LENGTH];
+    uint8_t pos;
+    int32_t sum;
+} moving_avg_t;
+
+static int16_t moving_avg_q15(moving_avg_t *m, int16_t x) {
+    m->sum += x - m->buf[m->pos];
+    m->buf[m->pos] = x;
+    m->pos = (m->pos + 1) & (MA_LENGTH - 1);
+
+    return (int16_t)(m->sum >> MA_LOG2);
+}
+
+/*--------------------------------------------------
+ * Exponential Smoothing (Q15 in/out, Q30 state)
+ *
+ *   y += alpha * (x - y)
+ *
+ * The state keeps 15 more fraction bits than the
+ * output; with Q15 state, small steps (x - y below
+ * 1 / alpha LSB) would be rounded away and y would
+ * stop short of x.
+ *------------------------------------------------*/
+typedef struct {
+    int32_t alpha;                      /* Q15, 0 .. 1.0 */
+    int32_t y;                          /* Q30 */
+} ema_t;
+
+static int16_t ema_q15(ema_t *e, int16_t x) {
+    int32_t diff = ((int32_t)x << 15) - e->y;
+
+    e->y += (int32_t)(smull(diff, e->alpha) >> 15);
+
+    return sat_q15((e->y + (1L << 14)) >> 15);
+}
+
+/*--------------------------------------------------
+ * Median of 5 (Q15)
+ *
+ * Sorting network on a copy of the window: 7
+ * compare-exchanges, no branches on the data
+ * except inside each exchange.
+ *------------------------------------------------*/
+typedef struct {
+    int16_t buf[5];
+    uint8_t pos;
+} median5_t;
+
+#define SORT2(a, b) do { if ((a) > (b)) { int16_t t = (a); (a) = (b); (b) = t; } } while (0)
+
+static int16_t median5_q15(median5_t *m, int16_t x) {
+    m->buf[m->pos] = x;
+    if (++m->pos == 5) m->pos = 0;
+
+    int16_t p0 = m->buf[0], p1 = m->buf[1], p2 = m->buf[2];
+    int16_t p3 = m->buf[3], p4 = m->buf[4];
+
+    SORT2(p0, p1); SORT2(p3, p4); SORT2(p0, p3);
+    SORT2(p1, p4); SORT2(p1, p2); SORT2(p2, p3);
+    SORT2(p1, p2);
+
+    return p2;
+}
+
+/*--------------------------------------------------
+ * Golden Models
+ *
+ * Straightforward versions of the same filters:
+ * double precision where the kernel rounds, exact
+ * re-computation where it should be bit-exact.
+ * The biquad model saturates each stage at the
+ * Q31 limits, as the kernel does.
+ *------------------------------------------------*/
+static double golden_biquad(double st[][4], const biquad_coeffs_t *c,
+                            uint8_t stages, double x) {
+    const double k = 1.0 / 1073741824.0;        /* 2^-30 */
+
+    for (uint8_t i = 0; i < stages; i++) {
+        double *s = st[i];
+        double y = k * (c[i].b0 * x + c[i].b1 * s[0] + c[i].b2 * s[1] +
+                        c[i].na1 * s[2] + c[i].na2 * s[3]);
+
+        if (y > Q31_MAX / 65536.0) y = Q31_MAX / 65536.0;
+        if (y < Q15_MIN) y = Q15_MIN;
+        s[1] = s[0];
+        s[0] = x;
+        s[3] = s[2];
+        s[2] = y;
+        x = y;
+    }
+    return x;
+}
+
+static int16_t golden_moving_avg(const int16_t *x, int32_t n) {
+    int32_t sum = 0;
+
+    for (int32_t i = n - MA_LENGTH + 1; i <= n; i++) {
+        if (i >= 0) sum += x[i];
+    }
+    return (int16_t)(sum >> MA_LOG2);
+}
+
+static int16_t golden_median5(const int16_t *x, int32_t n) {
+    int16_t w[5];
+
+    for (int32_t i = 0; i < 5; i++) {
+        int32_t j = n - 4 + i;
+        w[i] = (j >= 0) ? x[j] : 0;
+    }
+
+    /* Insertion sort */
+    for (int32_t i = 1; i < 5; i++) {
+        int16_t v = w[i];
+        int32_t j = i - 1;
+        while (j >= 0 && w[j] > v) {
+            w[j + 1] = w[j];
+            j--;
+        }
+        w[j + 1] = v;
+    }
+    return w[2];
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+static void print_signed(int32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+    uint32_t u = (n < 0) ? -(uint32_t)n : (uint32_t)n;
+
+    do {
+        temp[j++] = '0' + (u % 10);
+        u /= 10;
+    } while (u > 0);
+    if (n < 0) temp[j++] = '-';
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*--------------------------------------------------
+ * Self-Test: Kernels vs Golden Models
+ *
+ * Test signal (Q15): square wave of +-0.5 with a
+ * 500-sample period, uniform noise of +-0.125 and
+ * a +0.4 spike every 97 samples.
+ *------------------------------------------------*/
+#define TEST_SAMPLES    2048
+
+static int16_t test_in[TEST_SAMPLES];
+static int16_t test_out[TEST_SAMPLES];
+
+static uint32_t lcg_state = 1;
+
+static int16_t lcg_q15(void) {
+    lcg_state = lcg_state * 1664525 + 1013904223;
+    return (int16_t)(lcg_state >> 16);
+}
+
+static void make_test_signal(void) {
+    for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+        int32_t x = ((i % 500) < 250) ? 16384 : -16384;
+
+        x += lcg_q15() >> 3;            /* +-0.125 */
+        if (i % 97 == 0) x += 13107;    /* +0.4 spike */
+
+        test_in[i] = sat_q15(x);
+    }
+}
+
+/* Full-scale steps: the low-pass overshoots by ~10%
+ * and has to saturate, not wrap around */
+static void make_step_signal(void) {
+    for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+        if (i < 100) {
+            test_in[i] = 0;
+        } else {
+            test_in[i] = (((i - 100) / 400) & 1) ? Q15_MIN : Q15_MAX;
+        }
+    }
+}
+
+/* tolerance: largest error that still passes, in LSB (0 = bit-exact) */
+static void print_result(const char *name, uint32_t cycles, int32_t max_err,
+                         int32_t tolerance) {
+    uart_puts(name);
+    print_number(cycles / TEST_SAMPLES, 5);
+    uart_puts(" cycles/sample   max error ");
+    print_number(max_err, 0);
+    uart_puts(" LSB");
+    uart_puts(max_err <= tolerance ? "   PASS\r\n" : "   FAIL\r\n");
+}
+
+/* Biquad cascade over test_in[], from a cleared state */
+static void test_biquad(const char *name) {
+    biquad_state_t state[2] = { { 0 } };
+    biquad_cascade_t lpf = { lpf_coeffs, state, 2 };
+    double golden[2][4] = { { 0 } };
+    int32_t max_err = 0;
+
+    uint32_t t0 = DWT_CYCCNT;
+    for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+        int32_t y = biquad_cascade_q31(&lpf, Q15_TO_Q31(test_in[i]));
+        test_out[i] = Q31_TO_Q15(y);
+    }
+    uint32_t cycles = DWT_CYCCNT - t0;
+
+    for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+        double g = golden_biquad(golden, lpf_coeffs, 2, test_in[i]);
+        int32_t gq = sat_q15((int32_t)(g < 0 ? g - 0.5 : g + 0.5));
+        int32_t err = test_out[i] - gq;
+        if (err < 0) err = -err;
+        if (err > max_err) max_err = err;
+    }
+    print_result(name, cycles, max_err, 1);
+}
+
+static void run_self_test(void) {
+    uint32_t t0;
+    int32_t max_err;
+
+    make_test_signal();
+
+    uart_puts("\r\nSelf-test: 2048 samples vs golden model\r\n");
+
+    /* Biquad cascade: Q15 in, Q31 inside */
+    test_biquad("  biquad x2 (LPF 10 Hz) ");
+
+    /* Moving average: must be bit-exact */
+    {
+        moving_avg_t ma = { { 0 }, 0, 0 };
+
+        t0 = DWT_CYCCNT;
+        for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+            test_out[i] = moving_avg_q15(&ma, test_in[i]);
+        }
+        uint32_t cycles = DWT_CYCCNT - t0;
+
+        max_err = 0;
+        for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+            int32_t err = test_out[i] - golden_moving_avg(test_in, i);
+            if (err < 0) err = -err;
+            if (err > max_err) max_err = err;
+        }
+        print_result("  moving average (16)   ", cycles, max_err, 0);
+    }
+
+    /* Exponential smoothing, alpha = 0.05 */
+    {
+        ema_t ema = { 1638, 0 };
+        double g = 0.0;
+
+        t0 = DWT_CYCCNT;
+        for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+            test_out[i] = ema_q15(&ema, test_in[i]);
+        }
+        uint32_t cycles = DWT_CYCCNT - t0;
+
+        max_err = 0;
+        for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+            g += (1638.0 / 32768.0) * (test_in[i] - g);
+            int32_t gq = (int32_t)(g < 0 ? g - 0.5 : g + 0.5);
+            int32_t err = test_out[i] - gq;
+            if (err < 0) err = -err;
+            if (err > max_err) max_err = err;
+        }
+        print_result("  exponential (a=0.05)  ", cycles, max_err, 1);
+    }
+
+    /* Median of 5: must be bit-exact */
+    {
+        median5_t med = { { 0 }, 0 };
+
+        t0 = DWT_CYCCNT;
+        for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+            test_out[i] = median5_q15(&med, test_in[i]);
+        }
+        uint32_t cycles = DWT_CYCCNT - t0;
+
+        max_err = 0;
+        for (int32_t i = 0; i < TEST_SAMPLES; i++) {
+            int32_t err = test_out[i] - golden_median5(test_in, i);
+            if (err < 0) err = -err;
+            if (err > max_err) max_err = err;
+        }
+        print_result("  median of 5           ", cycles, max_err, 0);
+    }
+
+    /* Biquad again, overshooting into saturation */
+    make_step_signal();
+    test_biquad("  biquad x2 (FS steps)  ");
+}
+
+/*--------------------------------------------------
+ * Live Filtering in the ADC Interrupt
+ *------------------------------------------------*/
+static biquad_state_t live_lpf_state[2];
+static biquad_cascade_t live_lpf = { lpf_coeffs, live_lpf_state, 2 };
+static moving_avg_t live_ma;
+static ema_t live_ema = { 1638, 0 };
+static median5_t live_med;
+
+volatile int16_t out_raw, out_lpf, out_ma, out_ema, out_med;
+volatile uint32_t isr_cycles_max = 0;
+
+void ADC_IRQHandler(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    uint32_t code = (AD0DR(ADC_CHANNEL) >> 6) & 0x3FF;
+
+    /* 0..1023 -> Q15 -1.0 .. +0.998 */
+    int16_t x = (int16_t)(((int32_t)code - 512) << 6);
+
+    out_raw = x;
+    out_lpf = Q31_TO_Q15(biquad_cascade_q31(&live_lpf, Q15_TO_Q31(x)));
+    out_ma = moving_avg_q15(&live_ma, x);
+    out_ema = ema_q15(&live_ema, x);
+    out_med = median5_q15(&live_med, x);
+
+    uint32_t cycles = DWT_CYCCNT - t0;
+    if (cycles > isr_cycles_max) isr_cycles_max = cycles;
+}
+
+static void adc_sampling_start(void) {
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 9) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    IOCON_R_PIO0_11 = 0x02;             /* AD0, analog mode */
+
+    AD0CR = (1 << ADC_CHANNEL)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;      /* Rising MAT0 edge */
+    AD0INTEN = (1 << ADC_CHANNEL);
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    TMR32B0TCR = 0x02;
+    TMR32B0PR = 0;
+    TMR32B0MR0 = SAMPLE_HALF_PERIOD - 1;
+    TMR32B0MCR = (1 << 1);              /* Reset on MR0 */
+    TMR32B0EMR = (3 << 4);              /* Toggle MAT0 */
+    TMR32B0TCR = 0x01;
+}
+
+/* Q15 -> ADC code 0..1023 for printing */
+static int32_t q15_to_code(int16_t x) {
+    return (x >> 6) + 512;
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    DEMCR |= (1 << 24);                 /* TRCENA */
+    DWT_CTRL |= (1 << 0);               /* CYCCNTENA */
+
+    uart_init(115200);
+    uart_puts("\r\nDSP Filters\r\n");
+
+    run_self_test();
+
+    uart_puts("\r\nLive: AD0 at 1000 Hz (ADC codes)\r\n");
+    uart_puts("  raw  lpf   ma  ema  med  isr cycles\r\n");
+
+    adc_sampling_start();
+
+    while (1) {
+        for (volatile uint32_t i = 0; i < 1500000; i++);
+
+        print_signed(q15_to_code(out_raw), 5);
+        print_signed(q15_to_code(out_lpf), 5);
+        print_signed(q15_to_code(out_ma), 5);
+        print_signed(q15_to_code(out_ema), 5);
+        print_signed(q15_to_code(out_med), 5);
+        print_number(isr_cycles_max, 6);
+        uart_puts("\r\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,744 @@
+/**************************************************
+ * LPC1343 ADC Example: FFT and Goertzel Analysis
+ * Chapter 7: Analog to Digital Conversion
+ *
+ * Finds frequencies in an ADC stream on the chip
+ * itself, instead of sending raw samples away:
+ *
+ *   - FFT, 64-512 points, Q15, in place
+ *   - Goertzel detector for one frequency
+ *
+ * FFT: decimation in time. The input is put into
+ * bit-reversed order first - one RBIT instruction
+ * per index. Then either
+ *
+ *   radix-2: log2(N) passes of 2-point
+ *            butterflies: 4 complex multiplies
+ *            per 4 points every two passes
+ *   radix-4: two radix-2 passes merged into one
+ *            4-point butterfly (twiddles W^j,
+ *            W^2j, W^3j): 3 complex multiplies
+ *            per 4 points and half the passes
+ *            over memory. For odd log2(N) one
+ *            radix-2 pass comes first.
+ *
+ * Every pass scales by 1/2 per radix-2 stage, so
+ * nothing can overflow and the result is X[k] / N.
+ * Twiddles come from a 129-entry quarter sine
+ * table in flash (258 bytes).
+ *
+ * Goertzel computes one DFT bin with one multiply
+ * per sample and 12 bytes of state - the cheaper
+ * choice for a few known frequencies (tones,
+ * DTMF, a machine's running speed).
+ *
+ * At start-up a benchmark checks both FFTs
+ * against a direct DFT and prints cycles per
+ * transform and the RAM each size needs. Then AD0
+ * is sampled at 10 kHz into a ring buffer (as in
+ * ADC-Timer-Sampling): a 256-point FFT reports the
+ * strongest frequency and a Goertzel detector
+ * watches for 1000 Hz.
+ *
+ * Hardware:
+ *   Signal (biased to 1.65 V) → P0.11 (AD0)
+ *     e.g. electret mic module, piezo, or a
+ *     signal generator
+ *   LED → P0.7 (onboard, active low) - 1000 Hz tone
+ *   UART TXD → P1.7 (115200 8N1) - results
+ *
+ * Key Concepts:
+ *   - Q15 complex arithmetic, scaling per pass
+ *   - RBIT for bit-reversed addressing
+ *   - Radix-2 vs radix-4 butterflies
+ *   - Hann window
+ *   - Goertzel single-bin detector
+ *   - RAM budget on an 8 KB part
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_R_PIO0_11 (*((volatile uint32_t *)0x40044074))  /* AD0 */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+
+/*--------------------------------------------------
+ * 32-bit Timer 0 (CT32B0) Registers
+ *------------------------------------------------*/
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR      (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0      (*((volatile uint32_t *)0x40014018))
+#define TMR32B0EMR      (*((volatile uint32_t *)0x4001403C))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR0          (*((volatile uint32_t *)0x4001C010))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * Core Registers (NVIC, DWT)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define LED_PIN         7
+#define ADC_IRQn        49      /* ADC interrupt number */
+
+#define ADC_OVERRUN     (1UL << 30)
+#define ADC_CLKDIV      15      /* 4.5 MHz */
+#define ADC_START_CT32B0_MAT0   (4 << 24)
+
+#define ADC_SAMPLE_RATE_HZ  10000
+#define SAMPLE_HALF_PERIOD  (SYSTEM_CLOCK / (2 * ADC_SAMPLE_RATE_HZ))
+
+#if (SYSTEM_CLOCK / ADC_SAMPLE_RATE_HZ) % (2 * (ADC_CLKDIV + 1)) != 0
+#error "Sample period must be a multiple of two ADC clocks for zero jitter"
+#endif
+
+#define ADC_RING_SIZE   512     /* Power of two */
+#define ADC_RING_MASK   (ADC_RING_SIZE - 1)
+
+#define FFT_MAX_LOG2    9       /* 512 points */
+#define FFT_MAX_N       (1 << FFT_MAX_LOG2)
+
+#define LIVE_FFT_LOG2   8       /* 256 points: 39 Hz bins */
+#define LIVE_FFT_N      (1 << LIVE_FFT_LOG2)
+
+/* Goertzel: 1000 Hz in blocks of 200 samples
+ * (20 ms, bin width 50 Hz, k = 20 exactly) */
+#define TONE_HZ         1000
+#define TONE_BLOCK      200
+
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Sine Table: sin(0 .. 90 degrees) in Q15
+ *------------------------------------------------*/
+static const int16_t sin_table[129] = {
+        0,   402,   804,  1206,  1608,  2009,  2410,  2811,
+     3212,  3612,  4011,  4410,  4808,  5205,  5602,  5998,
+     6393,  6786,  7179,  7571,  7962,  8351,  8739,  9126,
+     9512,  9896, 10278, 10659, 11039, 11417, 11793, 12167,
+    12539, 12910, 13279, 13645, 14010, 14372, 14732, 15090,
+    15446, 15800, 16151, 16499, 16846, 17189, 17530, 17869,
+    18204, 18537, 18868, 19195, 19519, 19841, 20159, 20475,
+    20787, 21096, 21403, 21705, 22005, 22301, 22594, 22884,
+    23170, 23452, 23731, 24007, 24279, 24547, 24811, 25072,
+    25329, 25582, 25832, 26077, 26319, 26556, 26790, 27019,
+    27245, 27466, 27683, 27896, 28105, 28310, 28510, 28706,
+    28898, 29085, 29268, 29447, 29621, 29791, 29956, 30117,
+    30273, 30424, 30571, 30714, 30852, 30985, 31113, 31237,
+    31356, 31470, 31580, 31685, 31785, 31880, 31971, 32057,
+    32137, 32213, 32285, 32351, 32412, 32469, 32521, 32567,
+    32609, 32646, 32678, 32705, 32728, 32745, 32757, 32765,
+    32767,
+};
+
+/* phase: 0x10000 = one full turn. Multiples of
+ * 0x80 (every twiddle up to 512 points) come
+ * straight from the table, the rest is linearly
+ * interpolated. */
+static int32_t sin_q15(uint32_t phase) {
+    uint32_t quadrant = (phase >> 14) & 3;
+    uint32_t p = phase & 0x3FFF;
+
+    if (quadrant & 1) p = 0x4000 - p;   /* Falling quarter */
+
+    uint32_t i = p >> 7;
+    uint32_t frac = p & 0x7F;
+    int32_t v = sin_table[i];
+
+    if (frac) v += ((sin_table[i + 1] - v) * (int32_t)frac) >> 7;
+
+    return (quadrant & 2) ? -v : v;
+}
+
+static int32_t cos_q15(uint32_t phase) {
+    return sin_q15(phase + 0x4000);
+}
+
+/*--------------------------------------------------
+ * FFT: Bit-Reversed Reordering
+ *
+ * x holds N complex Q15 values, re and im
+ * interleaved. RBIT reverses all 32 bits of the
+ * index; the top log2n bits are the reversed
+ * index.
+ *------------------------------------------------*/
+static inline uint32_t rbit(uint32_t x) {
+    uint32_t r;
+    __asm ("rbit %0, %1" : "=r" (r) : "r" (x));
+    return r;
+}
+
+static void fft_bit_reverse(int16_t *x, uint8_t log2n) {
+    uint32_t n = 1UL << log2n;
+
+    for (uint32_t i = 1; i < n - 1; i++) {
+        uint32_t j = rbit(i) >> (32 - log2n);
+
+        if (j > i) {
+            int16_t t = x[2 * i];
+            x[2 * i] = x[2 * j];
+            x[2 * j] = t;
+            t = x[2 * i + 1];
+            x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j + 1] = t;
+        }
+    }
+}
+
+/*--------------------------------------------------
+ * FFT: One Radix-2 Pass
+ *
+ * Butterflies (k, k + half) in blocks of 2 * half,
+ * twiddle W^j = e^(-2 pi i j / (2 * half)). The
+ * twiddle loop is outside, so each twiddle is
+ * looked up once per pass. Scales by 1/2.
+ *------------------------------------------------*/
+static void fft_radix2_pass(int16_t *x, uint32_t n, uint32_t half) {
+    uint32_t step = 0x10000 / (2 * half);
+
+    for (uint32_t j = 0; j < half; j++) {
+        int32_t c = cos_q15(j * step);
+        int32_t s = sin_q15(j * step);
+
+        for (uint32_t k = j; k < n; k += 2 * half) {
+            int16_t *a = &x[2 * k];
+            int16_t *b = &x[2 * (k + half)];
+
+            /* t = b * (c - i s) */
+            int32_t tr = (b[0] * c + b[1] * s) >> 15;
+            int32_t ti = (b[1] * c - b[0] * s) >> 15;
+            int32_t ar = a[0], ai = a[1];
+
+            a[0] = (ar + tr) >> 1;
+            a[1] = (ai + ti) >> 1;
+            b[0] = (ar - tr) >> 1;
+            b[1] = (ai - ti) >> 1;
+        }
+    }
+}
+
+/*--------------------------------------------------
+ * FFT: One Radix-4 Pass
+ *
+ * Replaces the radix-2 passes with half = L and
+ * half = 2L. With a0..a3 at j, j+L, j+2L, j+3L
+ * and W = e^(-2 pi i / 4L):
+ *
+ *   q = W^2j a1   p = W^j a2   r = W^3j a3
+ *
+ *   y0 = a0 + q + (p + r)
+ *   y1 = a0 - q - i (p - r)
+ *   y2 = a0 + q - (p + r)
+ *   y3 = a0 - q + i (p - r)
+ *
+ * Scales by 1/4.
+ *------------------------------------------------*/
+#define CMUL_RE(xr, xi, c, s)   (((xr) * (c) + (xi) * (s)) >> 15)
+#define CMUL_IM(xr, xi, c, s)   (((xi) * (c) - (xr) * (s)) >> 15)
+
+static void fft_radix4_pass(int16_t *x, uint32_t n, uint32_t quarter) {
+    uint32_t step = 0x10000 / (4 * quarter);
+    uint32_t l2 = 2 * quarter;          /* Offsets in int16_t */
+
+    for (uint32_t j = 0; j < quarter; j++) {
+        int32_t c1 = cos_q15(j * step), s1 = sin_q15(j * step);
+        int32_t c2 = cos_q15(2 * j * step), s2 = sin_q15(2 * j * step);
+        int32_t c3 = cos_q15(3 * j * step), s3 = sin_q15(3 * j * step);
+
+        for (uint32_t k = j; k < n; k += 4 * quarter) {
+            int16_t *a = &x[2 * k];
+            int32_t a0r = a[0], a0i = a[1];
+            int32_t a1r = a[l2], a1i = a[l2 + 1];
+            int32_t a2r = a[2 * l2], a2i = a[2 * l2 + 1];
+            int32_t a3r = a[3 * l2], a3i = a[3 * l2 + 1];
+
+            int32_t qr = CMUL_RE(a1r, a1i, c2, s2), qi = CMUL_IM(a1r, a1i, c2, s2);
+            int32_t pr = CMUL_RE(a2r, a2i, c1, s1), pi = CMUL_IM(a2r, a2i, c1, s1);
+            int32_t rr = CMUL_RE(a3r, a3i, c3, s3), ri = CMUL_IM(a3r, a3i, c3, s3);
+
+            int32_t t0r = a0r + qr, t0i = a0i + qi;
+            int32_t t1r = a0r - qr, t1i = a0i - qi;
+            int32_t t2r = pr + rr, t2i = pi + ri;
+            int32_t t3r = pr - rr, t3i = pi - ri;
+
+            a[0] = (t0r + t2r) >> 2;
+            a[1] = (t0i + t2i) >> 2;
+            a[l2] = (t1r + t3i) >> 2;
+            a[l2 + 1] = (t1i - t3r) >> 2;
+            a[2 * l2] = (t0r - t2r) >> 2;
+            a[2 * l2 + 1] = (t0i - t2i) >> 2;
+            a[3 * l2] = (t1r - t3i) >> 2;
+            a[3 * l2 + 1] = (t1i + t3r) >> 2;
+        }
+    }
+}
+
+/*--------------------------------------------------
+ * FFT Entry Points
+ *
+ * In place on N = 2^log2n complex Q15 values
+ * (4 * N bytes). Result: X[k] / N.
+ *
+ * Keep inputs within +-0.5 (|x| < 16384): then no
+ * butterfly can overflow, because every pass
+ * scales by 1/2 per stage.
+ *------------------------------------------------*/
+static void fft_radix2(int16_t *x, uint8_t log2n) {
+    uint32_t n = 1UL << log2n;
+
+    fft_bit_reverse(x, log2n);
+    for (uint32_t half = 1; half < n; half <<= 1) {
+        fft_radix2_pass(x, n, half);
+    }
+}
+
+static void fft_radix4(int16_t *x, uint8_t log2n) {
+    uint32_t n = 1UL << log2n;
+    uint32_t quarter = 1;
+
+    fft_bit_reverse(x, log2n);
+    if (log2n & 1) {
+        fft_radix2_pass(x, n, 1);
+        quarter = 2;
+    }
+    for (; quarter < n; quarter <<= 2) {
+        fft_radix4_pass(x, n, quarter);
+    }
+}
+
+/*--------------------------------------------------
+ * Goertzel Single-Bin Detector
+ *
+ *   s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2]
+ *
+ * After a block of N samples
+ *
+ *   |X|^2 = s1^2 + s2^2 - 2 cos(w) s1 s2
+ *
+ * The coefficient is Q14 (2 cos(w) reaches 2.0),
+ * and the state can grow to N times the input, so
+ * the products use 64 bits (SMULL).
+ *------------------------------------------------*/
+typedef struct {
+    int32_t coeff;              /* 2 cos(w), Q14 */
+    int32_t s1, s2;
+} goertzel_t;
+
+static void goertzel_init(goertzel_t *g, uint32_t freq_hz, uint32_t rate_hz) {
+    /* w = 2 pi f / fs as a 16-bit phase */
+    uint32_t phase = (uint32_t)(((uint64_t)freq_hz << 16) / rate_hz);
+
+    g->coeff = cos_q15(phase);          /* cos in Q15 = 2 cos in Q14 */
+    g->s1 = 0;
+    g->s2 = 0;
+}
+
+static inline void goertzel_feed(goertzel_t *g, int32_t x) {
+    int32_t s = x + (int32_t)(((int64_t)g->coeff * g->s1) >> 14) - g->s2;
+
+    g->s2 = g->s1;
+    g->s1 = s;
+}
+
+/* |X|^2 of the block, then ready for the next one */
+static uint64_t goertzel_power(goertzel_t *g) {
+    int64_t s1 = g->s1, s2 = g->s2;
+    int64_t p = s1 * s1 + s2 * s2 - ((g->coeff * s1) >> 14) * s2;
+
+    g->s1 = 0;
+    g->s2 = 0;
+    return (p > 0) ? (uint64_t)p : 0;
+}
+
+/*--------------------------------------------------
+ * Sample Ring Buffer (as in ADC-Timer-Sampling)
+ *------------------------------------------------*/
+static uint16_t adc_ring[ADC_RING_SIZE];
+static volatile uint32_t adc_head = 0;
+static volatile uint32_t adc_tail = 0;
+
+volatile uint32_t adc_overflows = 0;   /* Ring full, sample dropped */
+volatile uint32_t adc_overruns = 0;    /* ISR too late, sample lost */
+
+void ADC_IRQHandler(void) {
+    uint32_t data = AD0DR0;
+    uint32_t head = adc_head;
+
+    if (data & ADC_OVERRUN) {
+        adc_overruns++;
+    }
+
+    if (head - adc_tail >= ADC_RING_SIZE) {
+        adc_overflows++;
+        return;
+    }
+
+    adc_ring[head & ADC_RING_MASK] = (data >> 6) & 0x3FF;
+
+    __asm volatile ("" ::: "memory");
+    adc_head = head + 1;
+}
+
+static void adc_sampling_start(void) {
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 9) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    IOCON_R_PIO0_11 = 0x02;             /* AD0, analog mode */
+
+    AD0CR = (1 << 0)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;      /* Rising MAT0 edge */
+    AD0INTEN = (1 << 0);
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    TMR32B0TCR = 0x02;                  /* Reset */
+    TMR32B0PR = 0;
+    TMR32B0MR0 = SAMPLE_HALF_PERIOD - 1;
+    TMR32B0MCR = (1 << 1);              /* MR0R: reset on MR0 */
+    TMR32B0EMR = (3 << 4);              /* EMC0 = toggle, EM0 = 0 */
+    TMR32B0TCR = 0x01;                  /* Start */
+}
+
+/* Take one sample, waiting if necessary */
+static uint16_t adc_get(void) {
+    uint32_t tail = adc_tail;
+
+    while (adc_head == tail) {
+        __asm volatile ("wfi");
+    }
+
+    __asm volatile ("" ::: "memory");
+    uint16_t v = adc_ring[tail & ADC_RING_MASK];
+
+    __asm volatile ("" ::: "memory");
+    adc_tail = tail + 1;
+
+    return v;
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*--------------------------------------------------
+ * FFT Buffer
+ *
+ * One buffer serves every size: N complex Q15
+ * values = 4 * N bytes (2 KB at 512 points).
+ *------------------------------------------------*/
+static int16_t fft_buf[2 * FFT_MAX_N];
+
+/* Largest |X[k]|^2, ignoring DC; returns k */
+static uint32_t fft_peak(const int16_t *x, uint32_t n, uint32_t *power) {
+    uint32_t best = 1, best_power = 0;
+
+    for (uint32_t k = 1; k < n / 2; k++) {
+        int32_t re = x[2 * k], im = x[2 * k + 1];
+        uint32_t p = (uint32_t)(re * re) + (uint32_t)(im * im);
+
+        if (p > best_power) {
+            best_power = p;
+            best = k;
+        }
+    }
+    *power = best_power;
+    return best;
+}
+
+/*--------------------------------------------------
+ * Benchmark and Self-Test
+ *
+ * Test signal: 0.25 sine at bin N/16 plus 0.125
+ * sine at bin 3N/10 (between bins: leakage) plus
+ * a DC offset of 0.05. Both FFTs are compared
+ * with a direct DFT using the same sine table.
+ *------------------------------------------------*/
+static void make_test_signal(int16_t *x, uint32_t n) {
+    uint32_t f1 = n / 16;
+    uint32_t f2_q8 = (3 * n * 256) / 10;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t ph1 = (uint32_t)((uint64_t)f1 * i * 0x10000 / n);
+        uint32_t ph2 = (uint32_t)((uint64_t)f2_q8 * i * 0x100 / n);
+
+        x[2 * i] = (sin_q15(ph1) >> 2) + (sin_q15(ph2) >> 3) + 1638;
+        x[2 * i + 1] = 0;
+    }
+}
+
+/* Largest |FFT - DFT| over all bins, in LSB */
+static uint32_t dft_max_error(const int16_t *fft, uint32_t n) {
+    static int16_t in[2 * 64];
+    uint32_t max_err = 0;
+
+    make_test_signal(in, n);
+
+    for (uint32_t k = 0; k < n; k++) {
+        int64_t re = 0, im = 0;
+
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t ph = (uint32_t)((k * i) % n) * (0x10000 / n);
+            int32_t c = cos_q15(ph), s = sin_q15(ph);
+            re += (int64_t)in[2 * i] * c;
+            im -= (int64_t)in[2 * i] * s;
+        }
+
+        /* / (32768 * N), rounded */
+        int32_t dr = (int32_t)((re + ((int64_t)n << 14)) / ((int64_t)n << 15));
+        int32_t di = (int32_t)((im + ((int64_t)n << 14)) / ((int64_t)n << 15));
+        int32_t er = fft[2 * k] - dr, ei = fft[2 * k + 1] - di;
+
+        if (er < 0) er = -er;
+        if (ei < 0) ei = -ei;
+        if ((uint32_t)er > max_err) max_err = er;
+        if ((uint32_t)ei > max_err) max_err = ei;
+    }
+    return max_err;
+}
+
+static void run_benchmark(void) {
+    uint32_t power;
+
+    uart_puts("\r\nFFT benchmark (Q15, in place, cycles incl. bit reversal)\r\n");
+    uart_puts("    N  radix-2     us  radix-4     us  RAM bytes  peak bin\r\n");
+
+    for (uint8_t log2n = 6; log2n <= FFT_MAX_LOG2; log2n++) {
+        uint32_t n = 1UL << log2n;
+
+        make_test_signal(fft_buf, n);
+        uint32_t t0 = DWT_CYCCNT;
+        fft_radix2(fft_buf, log2n);
+        uint32_t cycles2 = DWT_CYCCNT - t0;
+        uint32_t err2 = (n == 64) ? dft_max_error(fft_buf, n) : 0;
+
+        make_test_signal(fft_buf, n);
+        t0 = DWT_CYCCNT;
+        fft_radix4(fft_buf, log2n);
+        uint32_t cycles4 = DWT_CYCCNT - t0;
+        uint32_t err4 = (n == 64) ? dft_max_error(fft_buf, n) : 0;
+
+        uint32_t peak = fft_peak(fft_buf, n, &power);
+
+        print_number(n, 5);
+        print_number(cycles2, 9);
+        print_number(cycles2 / 72, 7);
+        print_number(cycles4, 9);
+        print_number(cycles4 / 72, 7);
+        print_number(4 * n, 11);
+        print_number(peak, 10);
+        uart_puts(peak == n / 16 ? "  OK" : "  FAIL");
+        if (n == 64) {
+            uart_puts("  vs DFT: ");
+            print_number(err2, 0);
+            uart_puts(" / ");
+            print_number(err4, 0);
+            uart_puts(" LSB");
+        }
+        uart_puts("\r\n");
+    }
+
+    /* Goertzel on the 512-point test signal: bin
+     * 32 (the 0.25 sine) against bin 100 (nothing) */
+    {
+        goertzel_t g;
+        uint64_t p_tone, p_none;
+
+        make_test_signal(fft_buf, 512);
+
+        goertzel_init(&g, 32, 512);
+        uint32_t t0 = DWT_CYCCNT;
+        for (uint32_t i = 0; i < 512; i++) {
+            goertzel_feed(&g, fft_buf[2 * i]);
+        }
+        p_tone = goertzel_power(&g);
+        uint32_t cycles = DWT_CYCCNT - t0;
+
+        goertzel_init(&g, 100, 512);
+        for (uint32_t i = 0; i < 512; i++) {
+            goertzel_feed(&g, fft_buf[2 * i]);
+        }
+        p_none = goertzel_power(&g);
+
+        uart_puts("Goertzel, 512 samples: ");
+        print_number(cycles, 0);
+        uart_puts(" cycles (");
+        print_number(cycles / 512, 0);
+        uart_puts("/sample), 12 bytes state, tone/empty bin power ratio ");
+        print_number((uint32_t)(p_tone / (p_none ? p_none : 1)), 0);
+        uart_puts("\r\n");
+    }
+
+    uart_puts("RAM: FFT buffer ");
+    print_number(sizeof(fft_buf), 0);
+    uart_puts(" + ADC ring ");
+    print_number(sizeof(adc_ring), 0);
+    uart_puts(" bytes; sine table 258 bytes flash\r\n");
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    goertzel_t tone;
+    uint32_t tone_n = 0;
+    int32_t tone_sum = 0;
+    uint64_t tone_sumsq = 0;
+    uint32_t fft_n = 0, frames = 0;
+
+    /* Enable GPIO clock */
+    SYSAHBCLKCTRL |= (1 << 6);
+
+    GPIO0DIR |= (1 << LED_PIN);
+    GPIO0DATA |= (1 << LED_PIN);
+
+    DEMCR |= (1 << 24);                 /* TRCENA */
+    DWT_CTRL |= (1 << 0);               /* CYCCNTENA */
+
+    uart_init(115200);
+    uart_puts("\r\nFFT and Goertzel\r\n");
+
+    run_benchmark();
+
+    uart_puts("\r\nLive: 10 kHz, 256-point FFT (Hann), Goertzel at 1000 Hz\r\n");
+
+    goertzel_init(&tone, TONE_HZ, ADC_SAMPLE_RATE_HZ);
+    adc_sampling_start();
+
+    while (1) {
+        /* Centred, +-0.5 full scale */
+        int32_t x = ((int32_t)adc_get() - 512) << 5;
+
+        /* Goertzel, block by block */
+        goertzel_feed(&tone, x);
+        tone_sum += x;
+        tone_sumsq += (int64_t)x * x;
+
+        if (++tone_n == TONE_BLOCK) {
+            uint64_t power = goertzel_power(&tone);
+
+            /* AC energy of the block times N: a pure
+             * tone puts |X|^2 = N * energy / 2 into its
+             * bin. Detect when half of that is there. */
+            uint64_t energy_n = tone_sumsq * TONE_BLOCK
+                              - (uint64_t)((int64_t)tone_sum * tone_sum);
+
+            if (power * 4 > energy_n && power > 0) {
+                GPIO0DATA &= ~(1 << LED_PIN);
+            } else {
+                GPIO0DATA |= (1 << LED_PIN);
+            }
+
+            tone_n = 0;
+            tone_sum = 0;
+            tone_sumsq = 0;
+        }
+
+        /* FFT frame with a Hann window */
+        int32_t w = (32768 - cos_q15(fft_n * (0x10000 / LIVE_FFT_N))) >> 1;
+        fft_buf[2 * fft_n] = (x * w) >> 15;
+        fft_buf[2 * fft_n + 1] = 0;
+
+        if (++fft_n == LIVE_FFT_N) {
+            fft_n = 0;
+            fft_radix4(fft_buf, LIVE_FFT_LOG2);
+
+            /* Print ~2 times per second */
+            if (++frames % 20 == 0) {
+                uint32_t power;
+                uint32_t k = fft_peak(fft_buf, LIVE_FFT_N, &power);
+
+                uart_puts("peak ");
+                print_number(k * ADC_SAMPLE_RATE_HZ / LIVE_FFT_N, 5);
+                uart_puts(" Hz  power ");
+                print_number(power, 8);
+                uart_puts("  tone ");
+                uart_puts((GPIO0DATA & (1 << LED_PIN)) ? "no " : "yes");
+                if (adc_overflows) {
+                    uart_puts("  dropped ");
+                    print_number(adc_overflows, 0);
+                }
+                uart_puts("\r\n");
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,693 @@
+/**************************************************
+ * LPC1343 I2C Example: Interrupt-Driven Master
+ * Chapter 8: I2C Communication
+ *
+ * BMP280-Read waits in i2c_wait() for the SI flag
+ * after every byte: a 3-byte register read at
+ * 100 kHz is about 60 bit times, ~600 us in which
+ * the CPU does nothing else.
+ *
+ * Here the I2C interrupt does the waiting. Every
+ * SI event enters I2C0_IRQHandler, which looks at
+ * I2C0STAT (the status codes 0x08-0x58 below) and
+ * does the one thing that state needs: load the
+ * next byte, ACK/NACK, repeated START or STOP.
+ *
+ * Work is described by transfers:
+ *
+ *   write           tx_len > 0, rx_len = 0
+ *   read            tx_len = 0, rx_len > 0
+ *   write-then-read tx_len > 0, rx_len > 0
+ *                   (repeated START between)
+ *
+ * i2c_submit() puts a transfer into a queue and
+ * returns at once. The ISR runs the queue in
+ * order, sets each transfer's result and calls
+ * its completion callback. The next transfer
+ * starts with STOP+START in the same interrupt.
+ *
+ * The demo queues the whole BMP280 set-up at once,
+ * then reads the temperature every 100 ms from
+ * SysTick. main() only sleeps and prints.
+ *
+ * Hardware:
+ *   BMP280 Module:
+ *     VCC → 3.3V
+ *     GND → GND
+ *     SCL → P0.4
+ *     SDA → P0.5
+ *     CSB → 3.3V (for I2C mode)
+ *     SDO → GND (address 0x76) or 3.3V (0x77)
+ *
+ *   UART TXD → P1.7 (115200 8N1) - results
+ *   LED: P0.7 (onboard, active low) - I2C busy
+ *
+ * Key Concepts:
+ *   - I2C master as an interrupt state machine
+ *   - Transfer queue with completion callbacks
+ *   - Repeated START for register reads
+ *   - NACK, arbitration and bus error handling
+ *   - CPU time per transfer vs bus time
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define PRESETCTRL      (*((volatile uint32_t *)0x40048004))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_PIO0_4    (*((volatile uint32_t *)0x40044030))  /* SCL */
+#define IOCON_PIO0_5    (*((volatile uint32_t *)0x40044034))  /* SDA */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+
+/*--------------------------------------------------
+ * I2C Registers
+ *------------------------------------------------*/
+#define I2C0CONSET      (*((volatile uint32_t *)0x40000000))
+#define I2C0CONCLR      (*((volatile uint32_t *)0x40000018))
+#define I2C0STAT        (*((volatile uint32_t *)0x40000004))
+#define I2C0DAT         (*((volatile uint32_t *)0x40000008))
+#define I2C0SCLH        (*((volatile uint32_t *)0x40000010))
+#define I2C0SCLL        (*((volatile uint32_t *)0x40000014))
+
+/*--------------------------------------------------
+ * I2C Control Bits
+ *------------------------------------------------*/
+#define I2C_AA          (1 << 2)
+#define I2C_SI          (1 << 3)
+#define I2C_STO         (1 << 4)
+#define I2C_STA         (1 << 5)
+#define I2C_I2EN        (1 << 6)
+
+/*--------------------------------------------------
+ * I2C Status Codes
+ *------------------------------------------------*/
+#define I2C_BUS_ERROR       0x00
+#define I2C_START_SENT      0x08
+#define I2C_REP_START_SENT  0x10
+#define I2C_SLA_W_ACK       0x18
+#define I2C_SLA_W_NACK      0x20
+#define I2C_DATA_W_ACK      0x28
+#define I2C_DATA_W_NACK     0x30
+#define I2C_ARB_LOST        0x38
+#define I2C_SLA_R_ACK       0x40
+#define I2C_SLA_R_NACK      0x48
+#define I2C_DATA_R_ACK      0x50
+#define I2C_DATA_R_NACK     0x58
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * Core Registers (NVIC, SysTick, DWT)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+#define SYST_CSR        (*((volatile uint32_t *)0xE000E010))
+#define SYST_RVR        (*((volatile uint32_t *)0xE000E014))
+#define SYST_CVR        (*((volatile uint32_t *)0xE000E018))
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*--------------------------------------------------
+ * BMP280 Constants
+ *------------------------------------------------*/
+#define BMP280_ADDR         0x76    /* or 0x77 */
+#define BMP280_ID_REG       0xD0    /* Chip ID register */
+#define BMP280_ID_VALUE     0x58    /* Expected chip ID */
+#define BMP280_CTRL_MEAS    0xF4    /* Control register */
+#define BMP280_CONFIG       0xF5    /* Config register */
+#define BMP280_TEMP_MSB     0xFA    /* Temperature MSB */
+#define BMP280_CALIB_START  0x88    /* Calibration data start */
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define LED_PIN         7
+#define I2C0_IRQn       40      /* I2C interrupt number */
+
+#define I2C_QUEUE_SIZE  8       /* Power of two */
+
+#define TICK_HZ         100
+#define READ_EVERY_TICKS 10     /* 100 ms */
+#define PRINT_EVERY     10      /* Every 10th reading */
+
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * Transfers
+ *
+ * The caller owns the transfer and its buffers;
+ * they must stay untouched until result is no
+ * longer I2C_BUSY. done() runs in the I2C
+ * interrupt and may submit further transfers.
+ *------------------------------------------------*/
+#define I2C_OK          0
+#define I2C_BUSY        1       /* Queued or on the bus */
+#define I2C_NACK        2       /* Address or data not acknowledged */
+#define I2C_ERROR       3       /* Arbitration lost, bus error */
+
+typedef struct i2c_xfer i2c_xfer_t;
+typedef void (*i2c_done_t)(i2c_xfer_t *x);
+
+struct i2c_xfer {
+    uint8_t addr;               /* 7-bit address */
+    uint8_t tx_len;             /* Bytes to write first */
+    uint8_t rx_len;             /* Bytes to read after */
+    volatile uint8_t result;
+    const uint8_t *tx;
+    uint8_t *rx;
+    i2c_done_t done;            /* May be 0 */
+};
+
+static i2c_xfer_t *i2c_queue[I2C_QUEUE_SIZE];
+static volatile uint32_t i2c_head = 0;      /* Written by i2c_submit() */
+static volatile uint32_t i2c_tail = 0;      /* Written by the ISR */
+static volatile uint8_t i2c_running = 0;    /* Bus owned by the queue */
+static uint8_t i2c_pos = 0;                 /* Byte index in this phase */
+
+/* Statistics */
+volatile uint32_t i2c_isr_calls = 0;
+volatile uint32_t i2c_isr_cycles = 0;
+volatile uint32_t i2c_failed = 0;
+
+/*--------------------------------------------------
+ * Interrupt Helpers
+ *------------------------------------------------*/
+static inline uint32_t irq_save(void) {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/*--------------------------------------------------
+ * LED Control
+ *------------------------------------------------*/
+static void led_on(void) {
+    GPIO0DATA &= ~(1 << LED_PIN);
+}
+
+static void led_off(void) {
+    GPIO0DATA |= (1 << LED_PIN);
+}
+
+/*--------------------------------------------------
+ * Finish the Current Transfer
+ *
+ * Called by the ISR with SI still set. Sends STOP,
+ * or STOP and START together if more transfers
+ * are waiting: the controller then generates the
+ * STOP first and the new START as soon as the bus
+ * is free, and the next interrupt is 0x08.
+ *------------------------------------------------*/
+static void i2c_finish(i2c_xfer_t *x, uint8_t result) {
+    if (result != I2C_OK) i2c_failed++;
+
+    i2c_tail++;
+    x->result = result;
+
+    /* May queue more work; i2c_running is still
+     * set so i2c_submit() does not start it */
+    if (x->done) x->done(x);
+
+    if (i2c_head != i2c_tail) {
+        I2C0CONSET = I2C_STO | I2C_STA;
+    } else {
+        I2C0CONSET = I2C_STO;
+        i2c_running = 0;
+        led_off();
+    }
+}
+
+/*--------------------------------------------------
+ * I2C Interrupt Handler
+ *
+ * One call per bus event. Whatever it writes to
+ * CONSET/DAT takes effect when SI is cleared,
+ * which is always the last step.
+ *------------------------------------------------*/
+void I2C0_IRQHandler(void) {
+    uint32_t t0 = DWT_CYCCNT;
+    i2c_xfer_t *x = i2c_queue[i2c_tail & (I2C_QUEUE_SIZE - 1)];
+
+    switch (I2C0STAT) {
+    case I2C_START_SENT:
+        /* Write phase first; a transfer with no data
+         * at all is an address probe (SLA+W) */
+        i2c_pos = 0;
+        if (x->tx_len || !x->rx_len) {
+            I2C0DAT = (x->addr << 1) | 0;
+        } else {
+            I2C0DAT = (x->addr << 1) | 1;
+        }
+        I2C0CONCLR = I2C_STA;
+        break;
+
+    case I2C_REP_START_SENT:
+        i2c_pos = 0;
+        I2C0DAT = (x->addr << 1) | 1;
+        I2C0CONCLR = I2C_STA;
+        break;
+
+    case I2C_SLA_W_ACK:
+    case I2C_DATA_W_ACK:
+        if (i2c_pos < x->tx_len) {
+            I2C0DAT = x->tx[i2c_pos++];
+        } else if (x->rx_len) {
+            I2C0CONSET = I2C_STA;           /* Repeated START */
+        } else {
+            i2c_finish(x, I2C_OK);
+        }
+        break;
+
+    case I2C_DATA_W_NACK:
+        /* A slave may NACK the last byte of a write */
+        if (i2c_pos == x->tx_len && !x->rx_len) {
+            i2c_finish(x, I2C_OK);
+        } else {
+            i2c_finish(x, I2C_NACK);
+        }
+        break;
+
+    case I2C_SLA_W_NACK:
+    case I2C_SLA_R_NACK:
+        i2c_finish(x, I2C_NACK);
+        break;
+
+    case I2C_SLA_R_ACK:
+        /* ACK every byte but the last */
+        if (x->rx_len > 1) {
+            I2C0CONSET = I2C_AA;
+        } else {
+            I2C0CONCLR = I2C_AA;
+        }
+        break;
+
+    case I2C_DATA_R_ACK:
+        x->rx[i2c_pos++] = I2C0DAT;
+        if (i2c_pos < x->rx_len - 1) {
+            I2C0CONSET = I2C_AA;
+        } else {
+            I2C0CONCLR = I2C_AA;
+        }
+        break;
+
+    case I2C_DATA_R_NACK:
+        x->rx[i2c_pos++] = I2C0DAT;         /* Last byte */
+        i2c_finish(x, I2C_OK);
+        break;
+
+    case I2C_ARB_LOST:
+    case I2C_BUS_ERROR:
+    default:
+        /* STO here releases the bus without sending
+         * a STOP (UM10375, I2C0CONSET) */
+        i2c_finish(x, I2C_ERROR);
+        break;
+    }
+
+    I2C0CONCLR = I2C_SI;
+
+    i2c_isr_cycles += DWT_CYCCNT - t0;
+    i2c_isr_calls++;
+}
+
+/*--------------------------------------------------
+ * Queue a Transfer
+ *
+ * Returns 0 if the queue is full. Safe to call
+ * from main(), other interrupts and done().
+ *------------------------------------------------*/
+static uint8_t i2c_submit(i2c_xfer_t *x) {
+    uint8_t ok = 0;
+    uint32_t primask = irq_save();
+
+    if (i2c_head - i2c_tail < I2C_QUEUE_SIZE) {
+        x->result = I2C_BUSY;
+        i2c_queue[i2c_head & (I2C_QUEUE_SIZE - 1)] = x;
+        i2c_head++;
+
+        if (!i2c_running) {
+            i2c_running = 1;
+            led_on();
+            I2C0CONSET = I2C_STA;
+        }
+        ok = 1;
+    }
+
+    irq_restore(primask);
+    return ok;
+}
+
+/*--------------------------------------------------
+ * Sleep Until a Transfer Has Finished
+ *
+ * Interrupts are masked around the test so the
+ * completion cannot slip in between test and WFI;
+ * a pending interrupt still ends WFI.
+ *------------------------------------------------*/
+static uint8_t i2c_wait_done(const i2c_xfer_t *x) {
+    while (1) {
+        __asm volatile ("cpsid i" ::: "memory");
+        if (x->result != I2C_BUSY) break;
+        __asm volatile ("wfi");
+        __asm volatile ("cpsie i" ::: "memory");
+    }
+    __asm volatile ("cpsie i" ::: "memory");
+
+    return x->result;
+}
+
+/*--------------------------------------------------
+ * Initialize I2C (100 kHz)
+ *------------------------------------------------*/
+static void i2c_init(void) {
+    SYSAHBCLKCTRL |= (1 << 5);   /* I2C clock */
+    PRESETCTRL |= (1 << 1);      /* De-assert reset */
+
+    IOCON_PIO0_4 = 0x01;         /* SCL function */
+    IOCON_PIO0_5 = 0x01;         /* SDA function */
+
+    /* 100 kHz: 72 MHz / 720 */
+    I2C0SCLH = 360;
+    I2C0SCLL = 360;
+
+    I2C0CONCLR = I2C_AA | I2C_SI | I2C_STA | I2C_I2EN;
+    I2C0CONSET = I2C_I2EN;
+
+    ISER1 = (1 << (I2C0_IRQn - 32));
+}
+
+/*--------------------------------------------------
+ * Transfer Helpers
+ *------------------------------------------------*/
+static void i2c_xfer_init(i2c_xfer_t *x, uint8_t addr,
+                          const uint8_t *tx, uint8_t tx_len,
+                          uint8_t *rx, uint8_t rx_len,
+                          i2c_done_t done) {
+    x->addr = addr;
+    x->tx = tx;
+    x->tx_len = tx_len;
+    x->rx = rx;
+    x->rx_len = rx_len;
+    x->done = done;
+    x->result = I2C_OK;
+}
+
+/*--------------------------------------------------
+ * BMP280 Transfers
+ *
+ * Register reads are write-then-read: the register
+ * number, a repeated START, then the data.
+ *------------------------------------------------*/
+static const uint8_t reg_id[1]    = { BMP280_ID_REG };
+static const uint8_t reg_calib[1] = { BMP280_CALIB_START };
+static const uint8_t reg_temp[1]  = { BMP280_TEMP_MSB };
+
+/* osrs_t = x1, osrs_p = x1, normal mode */
+static const uint8_t set_ctrl[2]   = { BMP280_CTRL_MEAS, 0x27 };
+/* No filter, 0.5 ms standby */
+static const uint8_t set_config[2] = { BMP280_CONFIG, 0x00 };
+
+static uint8_t chip_id;
+static uint8_t calib[6];
+static uint8_t temp_raw[3];
+
+static i2c_xfer_t x_id, x_calib, x_ctrl, x_config, x_temp;
+
+/*--------------------------------------------------
+ * Calibration Data (from BMP280)
+ *------------------------------------------------*/
+static uint16_t dig_T1;
+static int16_t dig_T2;
+static int16_t dig_T3;
+
+/*--------------------------------------------------
+ * BMP280: Calculate Temperature
+ *
+ * Bosch compensation formula, as in BMP280-Read.
+ * Returns temperature in 0.01 degrees C.
+ *------------------------------------------------*/
+static int32_t bmp280_calc_temp(int32_t adc_T) {
+    int32_t var1, var2, T;
+
+    var1 = ((((adc_T >> 3) - ((int32_t)dig_T1 << 1))) * ((int32_t)dig_T2)) >> 11;
+    var2 = (((((adc_T >> 4) - ((int32_t)dig_T1)) *
+              ((adc_T >> 4) - ((int32_t)dig_T1))) >> 12) *
+            ((int32_t)dig_T3)) >> 14;
+
+    T = (var1 + var2) * 5 + 128;
+    T = T >> 8;
+
+    return T;  /* Temperature in 0.01°C */
+}
+
+/*--------------------------------------------------
+ * Temperature Readings
+ *
+ * Started by SysTick, finished by the I2C ISR.
+ * Each reading records the bus time (submit to
+ * done) and the ISR cycles it cost.
+ *------------------------------------------------*/
+volatile int32_t temp_c = 0;            /* 0.01°C */
+volatile uint32_t temp_seq = 0;         /* Readings completed */
+volatile uint32_t temp_bus_cycles = 0;
+volatile uint32_t temp_isr_cycles = 0;
+volatile uint32_t temp_skipped = 0;     /* Previous still busy */
+
+static uint32_t temp_t0;
+static uint32_t temp_isr0;
+
+static void temp_done(i2c_xfer_t *x) {
+    if (x->result == I2C_OK) {
+        int32_t raw = ((int32_t)temp_raw[0] << 12) |
+                      ((int32_t)temp_raw[1] << 4) |
+                      ((int32_t)temp_raw[2] >> 4);
+        temp_c = bmp280_calc_temp(raw);
+    }
+
+    temp_bus_cycles = DWT_CYCCNT - temp_t0;
+    /* This call is not counted yet: a lower bound */
+    temp_isr_cycles = i2c_isr_cycles - temp_isr0;
+    temp_seq++;
+}
+
+static volatile uint32_t ticks = 0;
+
+void SysTick_Handler(void) {
+    if (++ticks % READ_EVERY_TICKS) return;
+
+    if (x_temp.result == I2C_BUSY) {
+        temp_skipped++;
+        return;
+    }
+
+    temp_t0 = DWT_CYCCNT;
+    temp_isr0 = i2c_isr_cycles;
+    i2c_submit(&x_temp);
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+static void print_hex8(uint8_t v) {
+    const char hex[] = "0123456789ABCDEF";
+    uart_putchar(hex[v >> 4]);
+    uart_putchar(hex[v & 0x0F]);
+}
+
+static void print_result(const char *what, const i2c_xfer_t *x) {
+    static const char *const names[] = { "OK", "BUSY", "NACK", "ERROR" };
+
+    uart_puts(what);
+    uart_puts(names[x->result]);
+    uart_puts("\r\n");
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    uint32_t last_seq = 0;
+    uint32_t wakeups = 0;
+
+    /* Enable GPIO clock */
+    SYSAHBCLKCTRL |= (1 << 6);
+
+    GPIO0DIR |= (1 << LED_PIN);
+    led_off();
+
+    /* Cycle counter for the timings */
+    DEMCR |= (1 << 24);
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1;
+
+    uart_init(115200);
+    i2c_init();
+
+    uart_puts("\r\nI2C Interrupt-Driven Master\r\n");
+
+    /* Whole set-up in one go: four transfers queued,
+     * run back to back by the ISR */
+    i2c_xfer_init(&x_id, BMP280_ADDR, reg_id, 1, &chip_id, 1, 0);
+    i2c_xfer_init(&x_calib, BMP280_ADDR, reg_calib, 1, calib, 6, 0);
+    i2c_xfer_init(&x_ctrl, BMP280_ADDR, set_ctrl, 2, 0, 0, 0);
+    i2c_xfer_init(&x_config, BMP280_ADDR, set_config, 2, 0, 0, 0);
+
+    uint32_t t0 = DWT_CYCCNT;
+    uint32_t isr0 = i2c_isr_cycles;
+
+    i2c_submit(&x_id);
+    i2c_submit(&x_calib);
+    i2c_submit(&x_ctrl);
+    i2c_submit(&x_config);
+
+    i2c_wait_done(&x_config);               /* Last in the queue */
+
+    uint32_t bus = DWT_CYCCNT - t0;
+    uint32_t isr = i2c_isr_cycles - isr0;
+
+    print_result("  chip id read:  ", &x_id);
+    print_result("  calibration:   ", &x_calib);
+    print_result("  ctrl_meas:     ", &x_ctrl);
+    print_result("  config:        ", &x_config);
+
+    uart_puts("  set-up: ");
+    print_number(bus / (SYSTEM_CLOCK / 1000000), 0);
+    uart_puts(" us on the bus, ");
+    print_number(isr, 0);
+    uart_puts(" cycles in the ISR\r\n");
+
+    if (x_id.result != I2C_OK || chip_id != BMP280_ID_VALUE) {
+        uart_puts("BMP280 not found (id 0x");
+        print_hex8(chip_id);
+        uart_puts(")\r\n");
+
+        /* Rapid blink error */
+        while (1) {
+            led_on();
+            for (volatile uint32_t i = 0; i < 50000; i++);
+            led_off();
+            for (volatile uint32_t i = 0; i < 50000; i++);
+        }
+    }
+
+    /* Temperature calibration (little-endian) */
+    dig_T1 = (uint16_t)(calib[1] << 8) | calib[0];
+    dig_T2 = (int16_t)(calib[3] << 8) | calib[2];
+    dig_T3 = (int16_t)(calib[5] << 8) | calib[4];
+
+    /* Periodic readings from SysTick */
+    i2c_xfer_init(&x_temp, BMP280_ADDR, reg_temp, 1, temp_raw, 3, temp_done);
+
+    SYST_RVR = (SYSTEM_CLOCK / TICK_HZ) - 1;
+    SYST_CVR = 0;
+    SYST_CSR = 0x07;            /* Core clock, interrupt, enable */
+
+    while (1) {
+        /* Sleep through the bus traffic as well */
+        __asm volatile ("wfi");
+        wakeups++;
+
+        if (temp_seq == last_seq) continue;
+        last_seq = temp_seq;
+
+        if (last_seq % PRINT_EVERY) continue;
+
+        int32_t t = temp_c;
+        uint32_t bus_us = temp_bus_cycles / (SYSTEM_CLOCK / 1000000);
+        uint32_t isr_cyc = temp_isr_cycles;
+
+        uart_puts("T=");
+        if (t < 0) {
+            uart_putchar('-');
+            t = -t;
+        }
+        print_number(t / 100, 0);
+        uart_putchar('.');
+        print_number(t % 100 / 10, 1);
+        print_number(t % 10, 1);
+        uart_puts(" C  bus ");
+        print_number(bus_us, 0);
+        uart_puts(" us, ISR ");
+        print_number(isr_cyc, 0);
+        uart_puts(" cycles (");
+        /* ISR share of the bus time, in 0.1 % */
+        print_number(temp_bus_cycles ? isr_cyc * 1000 / temp_bus_cycles : 0, 0);
+        uart_puts(" permille)  wakeups ");
+        print_number(wakeups, 0);
+        uart_puts("  failed ");
+        print_number(i2c_failed, 0);
+        uart_puts("  skipped ");
+        print_number(temp_skipped, 0);
+        uart_puts("\r\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,646 @@
+/**************************************************
+ * LPC1343 SPI Example: ADC Flash Recorder
+ * Chapter 9: SPI Communication
+ *
+ * Records seconds of ADC samples at tens of kHz
+ * into the W25Q16 SPI flash - far more than the
+ * 8 KB of SRAM could hold.
+ *
+ * The ADC is started by CT32B0 MAT0 (see 07-ADC
+ * ADC-Timer-Sampling) and its interrupt stores
+ * each 16-bit sample into one of two 256-byte
+ * page buffers. While the interrupt fills one
+ * page, the main loop programs the other one with
+ * the W25Q page program command:
+ *
+ *   ADC ISR:  [fill A][fill B][fill A][fill B]...
+ *   main:            [prog A][prog B][prog A]...
+ *
+ * A page is 128 samples. At 30 kHz it fills in
+ * 4.27 ms, and a page program takes 0.7 ms
+ * (3 ms worst case) plus 0.12 ms to clock the
+ * data out at 18 MHz, so the flash always keeps
+ * up. If it does not, the interrupt drops samples
+ * (it never overwrites a page being programmed)
+ * and counts them.
+ *
+ * A sector erase takes 45 ms (up to 400 ms) and
+ * blocks page programs while it runs - a few
+ * thousand samples, more than two pages of RAM
+ * can buffer. So the sectors are erased ahead of
+ * the write pointer before the capture is armed,
+ * and the page program refuses to write past the
+ * erased area.
+ *
+ * At start-up a benchmark records at several
+ * rates and prints, for each one, the dropped
+ * samples, the longest page program and a
+ * checksum comparison of the flash contents
+ * against the samples taken. Then it records at
+ * RECORD_RATE_HZ every 10 s.
+ *
+ * Hardware:
+ *   W25Q16 Module:
+ *     VCC   → 3.3V
+ *     GND   → GND
+ *     CLK   → P0.6 (SCK)
+ *     DO    → P0.8 (MISO)
+ *     DI    → P0.9 (MOSI)
+ *     /CS   → P0.2 (GPIO)
+ *     /WP   → 3.3V
+ *     /HOLD → 3.3V
+ *   Use short wires: SCK runs at 18 MHz.
+ *
+ *   Signal (0-3.3 V) → P0.11 (AD0)
+ *   UART TXD → P1.7 (115200 8N1) - results
+ *   LED: P0.7 (onboard, active low) - recording
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define SSP0CLKDIV      (*((volatile uint32_t *)0x40048094))
+#define PRESETCTRL      (*((volatile uint32_t *)0x40048004))
+#define PDRUNCFG        (*((volatile uint32_t *)0x40048238))
+#define UARTCLKDIV      (*((volatile uint32_t *)0x40048098))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_SCK_LOC   (*((volatile uint32_t *)0x400440B0))
+#define IOCON_PIO0_6    (*((volatile uint32_t *)0x4004404C))
+#define IOCON_PIO0_8    (*((volatile uint32_t *)0x40044060))
+#define IOCON_PIO0_9    (*((volatile uint32_t *)0x40044064))
+#define IOCON_PIO0_2    (*((volatile uint32_t *)0x4004401C))
+#define IOCON_R_PIO0_11 (*((volatile uint32_t *)0x40044074))  /* AD0 */
+#define IOCON_PIO1_6    (*((volatile uint32_t *)0x400440A4))  /* RXD */
+#define IOCON_PIO1_7    (*((volatile uint32_t *)0x400440A8))  /* TXD */
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+
+/*--------------------------------------------------
+ * SSP0 Registers (SPI)
+ *------------------------------------------------*/
+#define SSP0CR0         (*((volatile uint32_t *)0x40040000))
+#define SSP0CR1         (*((volatile uint32_t *)0x40040004))
+#define SSP0DR          (*((volatile uint32_t *)0x40040008))
+#define SSP0SR          (*((volatile uint32_t *)0x4004000C))
+#define SSP0CPSR        (*((volatile uint32_t *)0x40040010))
+
+/*--------------------------------------------------
+ * 32-bit Timer 0 (CT32B0) Registers
+ *------------------------------------------------*/
+#define TMR32B0TCR      (*((volatile uint32_t *)0x40014004))
+#define TMR32B0PR       (*((volatile uint32_t *)0x4001400C))
+#define TMR32B0MCR      (*((volatile uint32_t *)0x40014014))
+#define TMR32B0MR0      (*((volatile uint32_t *)0x40014018))
+#define TMR32B0EMR      (*((volatile uint32_t *)0x4001403C))
+
+/*--------------------------------------------------
+ * ADC Registers
+ *------------------------------------------------*/
+#define AD0CR           (*((volatile uint32_t *)0x4001C000))
+#define AD0INTEN        (*((volatile uint32_t *)0x4001C00C))
+#define AD0DR(n)        (*((volatile uint32_t *)(0x4001C010 + 4 * (n))))
+
+/*--------------------------------------------------
+ * UART Registers
+ *------------------------------------------------*/
+#define U0THR           (*((volatile uint32_t *)0x40008000))
+#define U0DLL           (*((volatile uint32_t *)0x40008000))
+#define U0DLM           (*((volatile uint32_t *)0x40008004))
+#define U0FCR           (*((volatile uint32_t *)0x40008008))
+#define U0LCR           (*((volatile uint32_t *)0x4000800C))
+#define U0LSR           (*((volatile uint32_t *)0x40008014))
+
+/*--------------------------------------------------
+ * Core Registers (NVIC, DWT)
+ *------------------------------------------------*/
+#define ISER1           (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*--------------------------------------------------
+ * Status Bits
+ *------------------------------------------------*/
+#define SSP_TFE         (1 << 0)
+#define SSP_TNF         (1 << 1)
+#define SSP_RNE         (1 << 2)
+#define SSP_BSY         (1 << 4)
+
+#define ADC_OVERRUN     (1UL << 30)
+#define LSR_THRE        (1 << 5)
+
+/*--------------------------------------------------
+ * W25Q16 Commands
+ *------------------------------------------------*/
+#define W25Q_WRITE_ENABLE   0x06
+#define W25Q_READ_STATUS1   0x05
+#define W25Q_READ_DATA      0x03
+#define W25Q_PAGE_PROGRAM   0x02
+#define W25Q_SECTOR_ERASE   0x20
+#define W25Q_JEDEC_ID       0x9F
+
+/* Status Register 1 bits */
+#define W25Q_BUSY           (1 << 0)
+#define W25Q_WEL            (1 << 1)   /* Write Enable Latch */
+
+#define W25Q_PAGE_SIZE      256
+#define W25Q_SECTOR_SIZE    4096
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define SYSTEM_CLOCK    72000000UL
+#define LED_PIN         7
+#define CS_PIN          2
+
+#define ADC_IRQn        49      /* ADC interrupt number */
+#define ADC_CHANNEL     0       /* AD0 = P0.11 */
+#define ADC_CLKDIV      15      /* 4.5 MHz */
+#define ADC_START_CT32B0_MAT0   (4 << 24)
+
+/* Sample periods must be a multiple of two ADC
+ * clocks (32 cycles) for zero jitter:
+ * 72 MHz / 32 / k = 2250000 / k Hz */
+#define RECORD_RATE_HZ  30000
+
+#if (SYSTEM_CLOCK / RECORD_RATE_HZ) % (2 * (ADC_CLKDIV + 1)) != 0
+#error "Sample period must be a multiple of two ADC clocks for zero jitter"
+#endif
+
+/* Capture area: 32 sectors = 128 KB = 65536
+ * samples, 2.18 s at 30 kHz */
+#define CAPTURE_ADDR    0x000000
+#define CAPTURE_SECTORS 32
+#define CAPTURE_BYTES   (CAPTURE_SECTORS * W25Q_SECTOR_SIZE)
+#define CAPTURE_PAGES   (CAPTURE_BYTES / W25Q_PAGE_SIZE)
+
+#define PAGE_SAMPLES    (W25Q_PAGE_SIZE / 2)
+
+/*--------------------------------------------------
+ * Recorder State
+ *
+ * page_full[i] is set by the ADC interrupt when
+ * page i is complete and cleared by the main loop
+ * when it has been programmed. The interrupt only
+ * writes into a page whose flag is clear.
+ *------------------------------------------------*/
+static uint16_t page_buf[2][PAGE_SAMPLES];
+static volatile uint8_t page_full[2];
+static volatile uint8_t fill_page;
+static volatile uint16_t fill_pos;
+static volatile uint32_t pages_filled;
+
+volatile uint32_t rec_dropped = 0;    /* No free page buffer */
+volatile uint32_t rec_overruns = 0;   /* ADC result overwritten */
+
+/* Fletcher-style checksum of the stored samples,
+ * compared with the flash contents afterwards */
+static volatile uint32_t rec_sum1, rec_sum2;
+
+/* End of the erased area: the write pointer must
+ * stay below it */
+static uint32_t erased_end = CAPTURE_ADDR;
+
+/* Page program timing (DWT cycles) */
+static uint32_t prog_max, prog_total;
+
+/*--------------------------------------------------
+ * Simple Delay Function
+ *------------------------------------------------*/
+static void delay(volatile uint32_t count) {
+    while (count--) {
+        __asm volatile ("nop");
+    }
+}
+
+/*--------------------------------------------------
+ * LED and Chip Select Control
+ *------------------------------------------------*/
+static void led_on(void) {
+    GPIO0DATA &= ~(1 << LED_PIN);
+}
+
+static void led_off(void) {
+    GPIO0DATA |= (1 << LED_PIN);
+}
+
+static void cs_low(void) {
+    GPIO0DATA &= ~(1 << CS_PIN);
+}
+
+static void cs_high(void) {
+    GPIO0DATA |= (1 << CS_PIN);
+}
+
+/*--------------------------------------------------
+ * UART (transmit only)
+ *------------------------------------------------*/
+static void uart_init(uint32_t baud) {
+    SYSAHBCLKCTRL |= (1 << 12) | (1 << 16);
+    UARTCLKDIV = 1;
+    IOCON_PIO1_6 = 0x01;
+    IOCON_PIO1_7 = 0x01;
+
+    U0LCR = 0x80;
+    uint32_t divisor = SYSTEM_CLOCK / (16 * baud);
+    U0DLL = divisor & 0xFF;
+    U0DLM = (divisor >> 8) & 0xFF;
+    U0LCR = 0x03;
+    U0FCR = 0x07;
+}
+
+static void uart_putchar(char c) {
+    while (!(U0LSR & LSR_THRE));
+    U0THR = c;
+}
+
+static void uart_puts(const char *s) {
+    while (*s) uart_putchar(*s++);
+}
+
+static void print_number(uint32_t n, uint8_t width) {
+    char temp[12];
+    int j = 0;
+
+    do {
+        temp[j++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    while (width > j) {
+        uart_putchar(' ');
+        width--;
+    }
+    while (j > 0) uart_putchar(temp[--j]);
+}
+
+/*--------------------------------------------------
+ * Initialize SPI (SSP0)
+ *
+ * Mode 0, 8-bit, SCK = 72 MHz / (2 * (1 + 1))
+ * = 18 MHz.
+ *------------------------------------------------*/
+static void spi_init(void) {
+    SYSAHBCLKCTRL |= (1 << 11);
+    SSP0CLKDIV = 1;
+    PRESETCTRL |= (1 << 0);
+
+    IOCON_SCK_LOC = 0x02;
+    IOCON_PIO0_6 = 0x02;
+    IOCON_PIO0_8 = 0x01;
+    IOCON_PIO0_9 = 0x01;
+
+    IOCON_PIO0_2 = 0x00;
+    GPIO0DIR |= (1 << CS_PIN);
+    cs_high();
+
+    SSP0CR0 = 0x07 | (0 << 4) | (0 << 6) | (0 << 7) | (1 << 8);
+    SSP0CPSR = 2;
+    SSP0CR1 = (1 << 1);
+}
+
+/*--------------------------------------------------
+ * SPI Transfer Single Byte
+ *------------------------------------------------*/
+static uint8_t spi_transfer(uint8_t data) {
+    while ((SSP0SR & SSP_TNF) == 0);
+    SSP0DR = data;
+    while (SSP0SR & SSP_BSY);
+    while ((SSP0SR & SSP_RNE) == 0);
+    return SSP0DR;
+}
+
+/*--------------------------------------------------
+ * SPI Block Transfer
+ *
+ * Keeps up to 8 bytes in flight, so SCK runs
+ * without gaps. Either pointer may be 0 (transmit
+ * 0xFF / discard the received bytes). Returns when
+ * the last byte has been clocked.
+ *------------------------------------------------*/
+static void spi_transfer_block(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    uint16_t to_send = len;
+    uint16_t to_recv = len;
+
+    while (to_recv) {
+        if (to_send && (to_recv - to_send) < 8 && (SSP0SR & SSP_TNF)) {
+            SSP0DR = tx ? *tx++ : 0xFF;
+            to_send--;
+        }
+        if (SSP0SR & SSP_RNE) {
+            uint8_t b = SSP0DR;
+            if (rx) *rx++ = b;
+            to_recv--;
+        }
+    }
+}
+
+/*--------------------------------------------------
+ * W25Q16 Basics (as in SPI-Flash-ReadWrite)
+ *------------------------------------------------*/
+static uint8_t w25q_read_status(void) {
+    uint8_t status;
+
+    cs_low();
+    spi_transfer(W25Q_READ_STATUS1);
+    status = spi_transfer(0xFF);
+    cs_high();
+
+    return status;
+}
+
+static void w25q_wait_busy(void) {
+    while (w25q_read_status() & W25Q_BUSY) {
+        /* Wait for BUSY bit to clear */
+    }
+}
+
+static void w25q_write_enable(void) {
+    cs_low();
+    spi_transfer(W25Q_WRITE_ENABLE);
+    cs_high();
+
+    while ((w25q_read_status() & W25Q_WEL) == 0);
+}
+
+static void w25q_send_command(uint8_t cmd, uint32_t addr) {
+    spi_transfer(cmd);
+    spi_transfer((addr >> 16) & 0xFF);
+    spi_transfer((addr >> 8) & 0xFF);
+    spi_transfer(addr & 0xFF);
+}
+
+static uint8_t w25q_verify_id(void) {
+    uint8_t id[3];
+
+    cs_low();
+    spi_transfer(W25Q_JEDEC_ID);
+    spi_transfer_block(0, id, 3);
+    cs_high();
+
+    return (id[0] == 0xEF) && (id[1] == 0x40) && (id[2] == 0x15);
+}
+
+static void w25q_erase_sector(uint32_t addr) {
+    w25q_write_enable();
+
+    cs_low();
+    w25q_send_command(W25Q_SECTOR_ERASE, addr);
+    cs_high();
+
+    /* Sector erase takes up to 400ms */
+    w25q_wait_busy();
+}
+
+/*--------------------------------------------------
+ * Program One Full Page
+ *
+ * Refuses pages that are not erased yet: flash
+ * bits only go 1→0, so the data would be ANDed
+ * with the old contents.
+ *------------------------------------------------*/
+static uint8_t w25q_program_page(uint32_t addr, const uint8_t *data) {
+    if (addr + W25Q_PAGE_SIZE > erased_end) return 0;
+
+    w25q_write_enable();
+
+    cs_low();
+    w25q_send_command(W25Q_PAGE_PROGRAM, addr);
+    spi_transfer_block(data, 0, W25Q_PAGE_SIZE);
+    cs_high();
+
+    /* Page program takes up to 3ms */
+    w25q_wait_busy();
+    return 1;
+}
+
+/*--------------------------------------------------
+ * Erase Ahead of the Write Pointer
+ *
+ * Erases sectors until erased_end reaches 'end'.
+ *------------------------------------------------*/
+static void erase_ahead(uint32_t end) {
+    while (erased_end < end) {
+        w25q_erase_sector(erased_end);
+        erased_end += W25Q_SECTOR_SIZE;
+    }
+}
+
+/*--------------------------------------------------
+ * ADC Interrupt: Fill the Page Buffers
+ *------------------------------------------------*/
+void ADC_IRQHandler(void) {
+    uint32_t dr = AD0DR(ADC_CHANNEL);   /* Clears DONE */
+    uint16_t code = (dr >> 6) & 0x3FF;
+    uint8_t page = fill_page;
+
+    if (dr & ADC_OVERRUN) rec_overruns++;
+
+    if (page_full[page]) {
+        rec_dropped++;                  /* Still being programmed */
+        return;
+    }
+
+    page_buf[page][fill_pos] = code;
+    rec_sum1 += code;
+    rec_sum2 += rec_sum1;
+
+    if (++fill_pos == PAGE_SAMPLES) {
+        fill_pos = 0;
+        __asm volatile ("" ::: "memory");
+        page_full[page] = 1;
+        fill_page = page ^ 1;
+
+        if (++pages_filled == CAPTURE_PAGES) {
+            TMR32B0TCR = 0x02;          /* Stop: capture complete */
+        }
+    }
+}
+
+/*--------------------------------------------------
+ * Initialize ADC (AD0, started by CT32B0 MAT0)
+ *------------------------------------------------*/
+static void adc_init(void) {
+    SYSAHBCLKCTRL |= (1 << 13) | (1 << 9) | (1 << 16);
+    PDRUNCFG &= ~(1 << 4);
+
+    IOCON_R_PIO0_11 = 0x02;             /* AD0, analog mode */
+
+    AD0CR = (1 << ADC_CHANNEL)
+          | (ADC_CLKDIV << 8)
+          | ADC_START_CT32B0_MAT0;      /* Rising MAT0 edge */
+    AD0INTEN = (1 << ADC_CHANNEL);
+    ISER1 = (1 << (ADC_IRQn - 32));
+
+    TMR32B0TCR = 0x02;
+    TMR32B0PR = 0;
+    TMR32B0MCR = (1 << 1);              /* Reset on MR0 */
+    TMR32B0EMR = (3 << 4);              /* Toggle MAT0 */
+}
+
+/*--------------------------------------------------
+ * Record One Capture
+ *
+ * Erases the capture area, starts the timer and
+ * programs each page as soon as the ADC interrupt
+ * has filled it.
+ *------------------------------------------------*/
+static void record(uint32_t rate_hz) {
+    erased_end = CAPTURE_ADDR;
+    erase_ahead(CAPTURE_ADDR + CAPTURE_BYTES);
+
+    page_full[0] = 0;
+    page_full[1] = 0;
+    fill_page = 0;
+    fill_pos = 0;
+    pages_filled = 0;
+    rec_dropped = 0;
+    rec_overruns = 0;
+    rec_sum1 = 0;
+    rec_sum2 = 0;
+    prog_max = 0;
+    prog_total = 0;
+
+    led_on();
+    TMR32B0MR0 = SYSTEM_CLOCK / (2 * rate_hz) - 1;
+    TMR32B0EMR = (3 << 4);              /* MAT0 starts low */
+    TMR32B0TCR = 0x01;
+
+    for (uint32_t n = 0; n < CAPTURE_PAGES; n++) {
+        uint8_t page = n & 1;
+
+        while (!page_full[page]);
+
+        uint32_t t0 = DWT_CYCCNT;
+        w25q_program_page(CAPTURE_ADDR + n * W25Q_PAGE_SIZE,
+                          (const uint8_t *)page_buf[page]);
+        uint32_t cycles = DWT_CYCCNT - t0;
+
+        __asm volatile ("" ::: "memory");
+        page_full[page] = 0;
+
+        prog_total += cycles;
+        if (cycles > prog_max) prog_max = cycles;
+    }
+    led_off();
+}
+
+/*--------------------------------------------------
+ * Verify: Checksum of the Flash Contents
+ *------------------------------------------------*/
+static uint8_t verify(void) {
+    uint16_t samples[PAGE_SAMPLES];
+    uint32_t sum1 = 0, sum2 = 0;
+
+    cs_low();
+    w25q_send_command(W25Q_READ_DATA, CAPTURE_ADDR);
+    for (uint32_t n = 0; n < CAPTURE_PAGES; n++) {
+        spi_transfer_block(0, (uint8_t *)samples, W25Q_PAGE_SIZE);
+        for (uint16_t i = 0; i < PAGE_SAMPLES; i++) {
+            sum1 += samples[i];
+            sum2 += sum1;
+        }
+    }
+    cs_high();
+
+    return (sum1 == rec_sum1) && (sum2 == rec_sum2);
+}
+
+/*--------------------------------------------------
+ * Benchmark: Sustained Recording at Several Rates
+ *------------------------------------------------*/
+static const uint32_t bench_rates[] = {
+    10000, 30000, 45000, 75000, 112500
+};
+
+static void print_result(uint32_t rate_hz) {
+    print_number(rate_hz, 7);
+    print_number(rec_dropped, 9);
+    print_number(rec_overruns, 9);
+    print_number(prog_total / CAPTURE_PAGES / 72, 9);
+    print_number(prog_max / 72, 9);
+    print_number(1000000UL * PAGE_SAMPLES / rate_hz, 9);
+    uart_puts(verify() ? "   OK\r\n" : "   FAIL\r\n");
+}
+
+static void run_benchmark(void) {
+    uint32_t worst = 0;
+
+    uart_puts("\r\nBenchmark: 65536 samples per run\r\n");
+    uart_puts("   rate  dropped overruns  prog avg  prog max"
+              "  page fill  flash\r\n");
+    uart_puts("     Hz                        us        us"
+              "         us\r\n");
+
+    for (uint8_t i = 0; i < sizeof(bench_rates) / sizeof(bench_rates[0]); i++) {
+        record(bench_rates[i]);
+        print_result(bench_rates[i]);
+        if (prog_max > worst) worst = prog_max;
+    }
+
+    /* Two page buffers: a page must be programmed
+     * before the other one is full */
+    uart_puts("Max sustained rate for the slowest page: ");
+    print_number(SYSTEM_CLOCK / worst * PAGE_SAMPLES, 0);
+    uart_puts(" Hz\r\n");
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    /* Enable GPIO clock */
+    SYSAHBCLKCTRL |= (1 << 6);
+
+    GPIO0DIR |= (1 << LED_PIN);
+    led_off();
+
+    DEMCR |= (1 << 24);                 /* TRCENA */
+    DWT_CTRL |= (1 << 0);               /* CYCCNTENA */
+
+    uart_init(115200);
+    uart_puts("\r\nADC Flash Recorder\r\n");
+
+    spi_init();
+    delay(100000);
+
+    if (!w25q_verify_id()) {
+        uart_puts("W25Q16 not found\r\n");
+        while (1) {
+            led_on();
+            delay(50000);
+            led_off();
+            delay(50000);
+        }
+    }
+
+    adc_init();
+    run_benchmark();
+
+    while (1) {
+        uart_puts("\r\nRecording ");
+        print_number(CAPTURE_PAGES * PAGE_SAMPLES, 0);
+        uart_puts(" samples at ");
+        print_number(RECORD_RATE_HZ, 0);
+        uart_puts(" Hz\r\n");
+
+        record(RECORD_RATE_HZ);
+        print_result(RECORD_RATE_HZ);
+
+        delay(20000000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,430 @@
+/**************************************************
+ * LPC1343 SPI Example: WS2812 LED Strip Driver
+ * Chapter 9: SPI Communication
+ *
+ * Drives a strip of WS2812 (NeoPixel) LEDs from
+ * the SSP0 MOSI pin, without bit-banging and
+ * without disabling interrupts.
+ *
+ * WS2812 bits are pulses on one wire, 1.25 us
+ * each: a short HIGH is a 0, a long HIGH is a 1.
+ * Clocking SSP0 at ~3.27 MHz makes every LED bit
+ * 4 SPI bits:
+ *
+ *   LED bit 0  ->  1000   (306 ns HIGH, 917 ns LOW)
+ *   LED bit 1  ->  1110   (917 ns HIGH, 306 ns LOW)
+ *
+ * so one 16-bit SSP frame carries 4 LED bits and
+ * each colour byte is 2 frames, looked up from a
+ * 16-entry nibble table.
+ *
+ * The SSP0 "TX FIFO half empty" interrupt encodes
+ * the next frames straight from the pixel buffer
+ * (3 bytes per LED) and tops up the 8-frame FIFO.
+ * After the last LED it sends zero frames for the
+ * >280 us LOW that latches the colours.
+ *
+ * The FIFO holds ~39 us of data and the interrupt
+ * comes with ~20 us left, so SSP0 gets the highest
+ * interrupt priority. Other interrupts may run as
+ * long as they like, only code that disables
+ * interrupts for more than ~15 us can break an
+ * update (counted in ws2812_underruns).
+ *
+ * Hardware:
+ *   WS2812 / WS2812B strip:
+ *     DIN   → P0.9 (MOSI) via 74AHCT125 (5 V level)
+ *     5V    → external 5 V supply
+ *     GND   → GND (shared with the board)
+ *
+ *   P0.6 (SCK) toggles but is not connected.
+ *   A W25Q16 module may stay on the bus: /CS on
+ *   P0.2 is held high.
+ *
+ *   LEDs: P3.0-P3.3 (onboard, active low)
+ *     LED0: toggles every frame
+ *     LED3: on after an underrun
+ *
+ * Note: This example assumes 72 MHz system clock
+ **************************************************/
+
+#include <stdint.h>
+
+/*--------------------------------------------------
+ * System Control Registers
+ *------------------------------------------------*/
+#define SYSAHBCLKCTRL   (*((volatile uint32_t *)0x40048080))
+#define SSP0CLKDIV      (*((volatile uint32_t *)0x40048094))
+#define PRESETCTRL      (*((volatile uint32_t *)0x40048004))
+
+/*--------------------------------------------------
+ * IOCON Registers (Pin Configuration)
+ *------------------------------------------------*/
+#define IOCON_SCK_LOC   (*((volatile uint32_t *)0x400440B0))
+#define IOCON_PIO0_6    (*((volatile uint32_t *)0x4004404C))  /* SCK */
+#define IOCON_PIO0_8    (*((volatile uint32_t *)0x40044060))  /* MISO */
+#define IOCON_PIO0_9    (*((volatile uint32_t *)0x40044064))  /* MOSI */
+#define IOCON_PIO0_2    (*((volatile uint32_t *)0x4004401C))  /* CS (GPIO) */
+#define IOCON_PIO3_0    (*((volatile uint32_t *)0x40044084))
+#define IOCON_PIO3_1    (*((volatile uint32_t *)0x40044088))
+#define IOCON_PIO3_2    (*((volatile uint32_t *)0x4004409C))
+#define IOCON_PIO3_3    (*((volatile uint32_t *)0x400440AC))
+
+/*--------------------------------------------------
+ * GPIO Registers
+ *------------------------------------------------*/
+#define GPIO0DIR        (*((volatile uint32_t *)0x50008000))
+#define GPIO0DATA       (*((volatile uint32_t *)0x50003FFC))
+#define GPIO3DIR        (*((volatile uint32_t *)0x50038000))
+#define GPIO3_LEDS      (*((volatile uint32_t *)0x5003003C))  /* Masked: P3.0-P3.3 */
+
+/*--------------------------------------------------
+ * SSP0 Registers (SPI)
+ *------------------------------------------------*/
+#define SSP0CR0         (*((volatile uint32_t *)0x40040000))
+#define SSP0CR1         (*((volatile uint32_t *)0x40040004))
+#define SSP0DR          (*((volatile uint32_t *)0x40040008))
+#define SSP0SR          (*((volatile uint32_t *)0x4004000C))
+#define SSP0CPSR        (*((volatile uint32_t *)0x40040010))
+#define SSP0IMSC        (*((volatile uint32_t *)0x40040014))
+
+/*--------------------------------------------------
+ * SSP Status and Interrupt Bits
+ *------------------------------------------------*/
+#define SSP_TFE         (1 << 0)   /* TX FIFO empty */
+#define SSP_TNF         (1 << 1)   /* TX FIFO not full */
+#define SSP_BSY         (1 << 4)   /* SSP busy */
+#define SSP_TXIM        (1 << 3)   /* Interrupt: TX FIFO at least half empty */
+
+/*--------------------------------------------------
+ * Core Registers (NVIC, SysTick, DWT)
+ *------------------------------------------------*/
+#define NVIC_ISER1      (*((volatile uint32_t *)0xE000E104))  /* IRQ 32-63 */
+#define NVIC_IPR(irq)   (*((volatile uint8_t *)(0xE000E400 + (irq))))
+#define SHPR3           (*((volatile uint32_t *)0xE000ED20))  /* SysTick priority [31:24] */
+
+#define SYST_CSR        (*((volatile uint32_t *)0xE000E010))
+#define SYST_RVR        (*((volatile uint32_t *)0xE000E014))
+#define SYST_CVR        (*((volatile uint32_t *)0xE000E018))
+
+#define DEMCR           (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL        (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile uint32_t *)0xE0001004))
+
+/*--------------------------------------------------
+ * Constants
+ *------------------------------------------------*/
+#define CS_PIN          2          /* Flash chip select on P0.2 */
+#define LED_MASK        0x0F
+
+#define SSP0_IRQn       45
+#define SYSTEM_CLOCK    72000000UL
+#define FRAME_RATE_HZ   50
+
+#define WS2812_COUNT    60         /* LEDs on the strip */
+#define WS2812_BYTES    (WS2812_COUNT * 3)
+
+/* 16 SPI bits at 305.6 ns = 4.9 us per frame;
+ * 64 zero frames = 313 us LOW to latch */
+#define WS2812_RESET_FRAMES  64
+
+/*--------------------------------------------------
+ * Simple Delay Function
+ *------------------------------------------------*/
+static void delay(volatile uint32_t count) {
+    while (count--) {
+        __asm volatile ("nop");
+    }
+}
+
+/*--------------------------------------------------
+ * LED Control (P3.0-P3.3)
+ *------------------------------------------------*/
+static void led_init(void) {
+    IOCON_PIO3_0 = 0x01;
+    IOCON_PIO3_1 = 0x01;
+    IOCON_PIO3_2 = 0x01;
+    IOCON_PIO3_3 = 0x01;
+
+    GPIO3_LEDS = LED_MASK;         /* All off */
+    GPIO3DIR |= LED_MASK;
+}
+
+static void led_toggle(uint8_t led) {
+    GPIO3_LEDS ^= (1 << led);
+}
+
+static void led_on(uint8_t led) {
+    GPIO3_LEDS &= ~(1 << led);
+}
+
+/*--------------------------------------------------
+ * Initialize SPI (SSP0) for WS2812
+ *
+ * Same pins as the flash examples; only MOSI
+ * carries the LED data.
+ *
+ * Configuration:
+ * - 16-bit frames (4 LED bits each)
+ * - Mode 1 (CPOL=0, CPHA=1): the frame select
+ *   stays asserted between back-to-back frames,
+ *   so there is no gap on MOSI between frames
+ * - 72 MHz / (2 * 11) = 3.27 MHz
+ *------------------------------------------------*/
+static void spi_init(void) {
+    /* Enable SSP0 clock */
+    SYSAHBCLKCTRL |= (1 << 11);    /* Bit 11 = SSP0 */
+
+    /* Set SSP0 clock divider */
+    SSP0CLKDIV = 1;                /* PCLK = system clock */
+
+    /* De-assert SSP0 reset */
+    PRESETCTRL |= (1 << 0);        /* Bit 0 = SSP0 reset */
+
+    /* Configure pins for SSP0 function */
+    IOCON_SCK_LOC = 0x02;          /* SCK on P0.6 */
+    IOCON_PIO0_6 = 0x02;           /* P0.6 = SCK */
+    IOCON_PIO0_8 = 0x01;           /* P0.8 = MISO */
+    IOCON_PIO0_9 = 0x01;           /* P0.9 = MOSI */
+
+    /* Keep a flash chip on the bus deselected */
+    IOCON_PIO0_2 = 0x00;           /* P0.2 = GPIO */
+    GPIO0DIR |= (1 << CS_PIN);
+    GPIO0DATA |= (1 << CS_PIN);
+
+    /* Configure SSP0 Control Register 0:
+     *
+     * [3:0]  DSS  = 0x0F (16-bit data)
+     * [5:4]  FRF  = 0x00 (SPI frame format)
+     * [6]    CPOL = 0 (clock idle low)
+     * [7]    CPHA = 1 (continuous frames)
+     * [15:8] SCR  = 10 (serial clock rate)
+     *
+     * SPI clock = PCLK / (CPSR * (SCR + 1))
+     *           = 72 MHz / (2 * 11) = 3.27 MHz
+     */
+    SSP0CR0 = 0x0F                 /* 16-bit data */
+            | (0 << 4)             /* SPI format */
+            | (0 << 6)             /* CPOL = 0 */
+            | (1 << 7)             /* CPHA = 1 */
+            | (10 << 8);           /* SCR = 10 */
+
+    /* Set clock prescaler (must be even, >= 2) */
+    SSP0CPSR = 2;
+
+    /* Enable SSP0 as master.
+     * MISO is not used: the RX FIFO fills up and
+     * overruns, which is harmless with the receive
+     * interrupts masked.
+     */
+    SSP0CR1 = (1 << 1);
+}
+
+/*--------------------------------------------------
+ * WS2812 Bit Encoding
+ *
+ * Four LED bits (MSB first) -> one 16-bit frame.
+ *------------------------------------------------*/
+#define WS_BIT(b)       ((b) ? 0xE : 0x8)
+#define WS_NIBBLE(n)    ((WS_BIT((n) & 8) << 12) | (WS_BIT((n) & 4) << 8) | \
+                         (WS_BIT((n) & 2) << 4)  |  WS_BIT((n) & 1))
+
+static const uint16_t ws2812_nibble[16] = {
+    WS_NIBBLE(0),  WS_NIBBLE(1),  WS_NIBBLE(2),  WS_NIBBLE(3),
+    WS_NIBBLE(4),  WS_NIBBLE(5),  WS_NIBBLE(6),  WS_NIBBLE(7),
+    WS_NIBBLE(8),  WS_NIBBLE(9),  WS_NIBBLE(10), WS_NIBBLE(11),
+    WS_NIBBLE(12), WS_NIBBLE(13), WS_NIBBLE(14), WS_NIBBLE(15)
+};
+
+/*--------------------------------------------------
+ * WS2812 Driver State
+ *
+ * Two pixel buffers: the main loop draws into one
+ * while the interrupt sends the other.
+ *------------------------------------------------*/
+static uint8_t ws2812_buf[2][WS2812_BYTES];  /* G, R, B per LED */
+static uint8_t ws2812_draw = 0;              /* Buffer for ws2812_set() */
+
+static const uint8_t *tx_buf;                /* Buffer being sent */
+static uint32_t tx_frame;                    /* Next frame to queue */
+static uint32_t tx_reset;                    /* Latch frames left */
+
+static volatile uint8_t ws2812_sending = 0;  /* Frames left to queue */
+
+volatile uint32_t ws2812_underruns = 0;      /* Line went idle mid-strip */
+volatile uint32_t ws2812_isr_max = 0;        /* Longest interrupt, cycles */
+
+/*--------------------------------------------------
+ * SSP0 Interrupt: Refill the TX FIFO
+ *
+ * Fires while the TX FIFO is at least half empty,
+ * so each call queues 4-8 frames (20-39 us of
+ * data). Once the last latch frame is queued the
+ * interrupt is masked again.
+ *------------------------------------------------*/
+void SSP0_IRQHandler(void) {
+    uint32_t t0 = DWT_CYCCNT;
+
+    /* Shifter idle in the middle of the LED data:
+     * the strip saw a LOW long enough to latch */
+    if (tx_frame != 0 && tx_frame < 2 * WS2812_BYTES &&
+        (SSP0SR & SSP_BSY) == 0) {
+        ws2812_underruns++;
+    }
+
+    while (SSP0SR & SSP_TNF) {
+        if (tx_frame < 2 * WS2812_BYTES) {
+            uint8_t byte = tx_buf[tx_frame >> 1];
+            SSP0DR = (tx_frame & 1) ? ws2812_nibble[byte & 0x0F]
+                                    : ws2812_nibble[byte >> 4];
+            tx_frame++;
+        } else if (tx_reset) {
+            SSP0DR = 0;            /* LOW for the latch */
+            tx_reset--;
+        } else {
+            SSP0IMSC = 0;
+            ws2812_sending = 0;
+            break;
+        }
+    }
+
+    uint32_t cycles = DWT_CYCCNT - t0;
+    if (cycles > ws2812_isr_max) ws2812_isr_max = cycles;
+}
+
+/*--------------------------------------------------
+ * WS2812 API
+ *------------------------------------------------*/
+static void ws2812_init(void) {
+    DEMCR |= (1 << 24);            /* TRCENA */
+    DWT_CTRL |= (1 << 0);          /* CYCCNTENA */
+
+    spi_init();
+
+    /* Highest priority: the FIFO only covers ~20 us */
+    NVIC_IPR(SSP0_IRQn) = 0x00;
+    NVIC_ISER1 = (1 << (SSP0_IRQn - 32));
+}
+
+/*
+ * True until the latch time after the last LED has
+ * passed. Pixel buffers can be swapped after that.
+ */
+static uint8_t ws2812_busy(void) {
+    return ws2812_sending || (SSP0SR & SSP_BSY);
+}
+
+/*
+ * Set one LED in the draw buffer (shown by the
+ * next ws2812_show()).
+ */
+static void ws2812_set(uint32_t led, uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t *p = &ws2812_buf[ws2812_draw][led * 3];
+
+    p[0] = g;                      /* WS2812 order is G, R, B */
+    p[1] = r;
+    p[2] = b;
+}
+
+/*
+ * Send the draw buffer to the strip and return at
+ * once. The other buffer becomes the draw buffer;
+ * it still holds the frame before last, so redraw
+ * every LED you care about.
+ */
+static void ws2812_show(void) {
+    while (ws2812_busy());         /* Previous update still latching */
+
+    tx_buf = ws2812_buf[ws2812_draw];
+    tx_frame = 0;
+    tx_reset = WS2812_RESET_FRAMES;
+    ws2812_draw ^= 1;
+    ws2812_sending = 1;
+
+    /* State above must be stored before the IRQ can run */
+    __asm volatile ("" ::: "memory");
+
+    /* FIFO is empty, so the interrupt fires at once */
+    SSP0IMSC = SSP_TXIM;
+}
+
+/*--------------------------------------------------
+ * Frame Timer (SysTick, lowest priority)
+ *------------------------------------------------*/
+static volatile uint8_t frame_tick = 0;
+
+void SysTick_Handler(void) {
+    frame_tick = 1;
+}
+
+static void frame_timer_init(void) {
+    SHPR3 = (SHPR3 & 0x00FFFFFF) | (0xE0u << 24);  /* Lowest priority */
+
+    SYST_RVR = SYSTEM_CLOCK / FRAME_RATE_HZ - 1;
+    SYST_CVR = 0;
+    SYST_CSR = 0x07;               /* CPU clock, interrupt, enable */
+}
+
+/*--------------------------------------------------
+ * Colour Wheel: 0-255 -> red -> green -> blue
+ *------------------------------------------------*/
+static void wheel(uint8_t pos, uint8_t *r, uint8_t *g, uint8_t *b) {
+    if (pos < 85) {
+        *r = 255 - pos * 3; *g = pos * 3;       *b = 0;
+    } else if (pos < 170) {
+        pos -= 85;
+        *r = 0;             *g = 255 - pos * 3; *b = pos * 3;
+    } else {
+        pos -= 170;
+        *r = pos * 3;       *g = 0;             *b = 255 - pos * 3;
+    }
+}
+
+/*--------------------------------------------------
+ * Main Function
+ *------------------------------------------------*/
+int main(void) {
+    uint8_t offset = 0;
+
+    /* Enable GPIO and IOCON clocks */
+    SYSAHBCLKCTRL |= (1 << 6) | (1 << 16);
+
+    led_init();
+    ws2812_init();
+
+    /* Let the strip power up, then switch all LEDs off */
+    delay(100000);
+    ws2812_show();
+
+    frame_timer_init();
+
+    /* Rainbow running along the strip, 50 frames/s.
+     * With 60 LEDs an update takes ~2.1 ms of SPI
+     * time; the CPU only spends the short refill
+     * interrupts on it and draws the next frame
+     * meanwhile.
+     */
+    while (1) {
+        for (uint32_t i = 0; i < WS2812_COUNT; i++) {
+            uint8_t r, g, b;
+
+            wheel((uint8_t)(offset + i * 256 / WS2812_COUNT), &r, &g, &b);
+
+            /* Quarter brightness keeps the 5 V current down */
+            ws2812_set(i, r >> 2, g >> 2, b >> 2);
+        }
+
+        while (!frame_tick) {
+            __asm volatile ("wfi");
+        }
+        frame_tick = 0;
+
+        ws2812_show();
+        offset++;
+
+        led_toggle(0);
+        if (ws2812_underruns) led_on(3);
+    }
+
+    return 0;
+}